@@ -0,0 +1,203 @@
+// cacheprog.c
+// cache dos programas lidos de arquivos '.maq'
+// simulador de computador
+// so25b
+
+#include "cacheprog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+
+// um programa lido de um arquivo
+typedef struct entrada_t {
+  char *nome;
+  struct timespec modificacao;  // data de modificação e tamanho do arquivo
+  off_t tamanho_arquivo;        //   quando foi lido
+  programa_t *prog;
+  int referencias;
+  bool obsoleta;                // o arquivo mudou; não é mais achada pelo nome
+  struct entrada_t *prox;
+} entrada_t;
+
+struct cacheprog_t {
+  int capacidade;
+  // lista das entradas, da usada mais recentemente para a menos
+  entrada_t *entradas;
+  int num_entradas;
+  int acertos;
+  int faltas;
+  int invalidacoes;
+};
+
+cacheprog_t *cacheprog_cria(int capacidade)
+{
+  cacheprog_t *self = malloc(sizeof(*self));
+  if (self == NULL) return NULL;
+  self->capacidade = capacidade;
+  self->entradas = NULL;
+  self->num_entradas = 0;
+  self->acertos = 0;
+  self->faltas = 0;
+  self->invalidacoes = 0;
+  return self;
+}
+
+static void destroi_entrada(entrada_t *entrada)
+{
+  prog_destroi(entrada->prog);
+  free(entrada->nome);
+  free(entrada);
+}
+
+void cacheprog_destroi(cacheprog_t *self)
+{
+  if (self == NULL) return;
+  while (self->entradas != NULL) {
+    entrada_t *entrada = self->entradas;
+    self->entradas = entrada->prox;
+    destroi_entrada(entrada);
+  }
+  free(self);
+}
+
+// retira da lista a entrada apontada por 'elo' e a destrói
+static void remove_entrada(cacheprog_t *self, entrada_t **elo)
+{
+  entrada_t *entrada = *elo;
+  *elo = entrada->prox;
+  destroi_entrada(entrada);
+  self->num_entradas--;
+}
+
+// destrói as entradas sem referências que não servem mais (obsoletas) ou
+//   que passam da capacidade, das usadas menos recentemente
+static void descarta_excesso(cacheprog_t *self)
+{
+  int sem_referencias = 0;
+  for (entrada_t *e = self->entradas; e != NULL; e = e->prox) {
+    if (e->referencias == 0 && !e->obsoleta) sem_referencias++;
+  }
+  int a_descartar = sem_referencias - self->capacidade;
+  // percorre do mais recente para o menos: as últimas sem referências a
+  //   passar da capacidade são descartadas
+  int vistas = 0;
+  entrada_t **elo = &self->entradas;
+  while (*elo != NULL) {
+    entrada_t *e = *elo;
+    if (e->referencias == 0) {
+      if (e->obsoleta) {
+        remove_entrada(self, elo);
+        continue;
+      }
+      vistas++;
+      if (a_descartar > 0 && vistas > sem_referencias - a_descartar) {
+        remove_entrada(self, elo);
+        continue;
+      }
+    }
+    elo = &e->prox;
+  }
+}
+
+static bool mesma_data(struct timespec a, struct timespec b)
+{
+  return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+programa_t *cacheprog_obtem(cacheprog_t *self, char *nome)
+{
+  struct stat st;
+  if (stat(nome, &st) != 0) {
+    return NULL;
+  }
+
+  for (entrada_t **elo = &self->entradas; *elo != NULL; elo = &(*elo)->prox) {
+    entrada_t *e = *elo;
+    if (e->obsoleta || strcmp(e->nome, nome) != 0) {
+      continue;
+    }
+    if (!mesma_data(e->modificacao, st.st_mtim) || e->tamanho_arquivo != st.st_size) {
+      // o arquivo mudou: a entrada é descartada quando não tiver referências
+      e->obsoleta = true;
+      self->invalidacoes++;
+      break;
+    }
+    // acerto: a entrada passa para o início da lista
+    *elo = e->prox;
+    e->prox = self->entradas;
+    self->entradas = e;
+    e->referencias++;
+    self->acertos++;
+    return e->prog;
+  }
+
+  self->faltas++;
+  programa_t *prog = prog_cria(nome);
+  if (prog == NULL) {
+    descarta_excesso(self);
+    return NULL;
+  }
+  entrada_t *e = malloc(sizeof(*e));
+  char *copia_nome = strdup(nome);
+  if (e == NULL || copia_nome == NULL) {
+    // sem memória para a entrada: tratado como falha na leitura
+    free(e);
+    free(copia_nome);
+    prog_destroi(prog);
+    return NULL;
+  }
+  e->nome = copia_nome;
+  e->modificacao = st.st_mtim;
+  e->tamanho_arquivo = st.st_size;
+  e->prog = prog;
+  e->referencias = 1;
+  e->obsoleta = false;
+  e->prox = self->entradas;
+  self->entradas = e;
+  self->num_entradas++;
+  descarta_excesso(self);
+  return prog;
+}
+
+void cacheprog_retem(cacheprog_t *self, programa_t *prog)
+{
+  for (entrada_t *e = self->entradas; e != NULL; e = e->prox) {
+    if (e->prog == prog) {
+      e->referencias++;
+      break;
+    }
+  }
+}
+
+void cacheprog_libera(cacheprog_t *self, programa_t *prog)
+{
+  for (entrada_t *e = self->entradas; e != NULL; e = e->prox) {
+    if (e->prog == prog) {
+      if (e->referencias > 0) e->referencias--;
+      break;
+    }
+  }
+  descarta_excesso(self);
+}
+
+int cacheprog_acertos(cacheprog_t *self)
+{
+  return self->acertos;
+}
+
+int cacheprog_faltas(cacheprog_t *self)
+{
+  return self->faltas;
+}
+
+int cacheprog_invalidacoes(cacheprog_t *self)
+{
+  return self->invalidacoes;
+}
+
+int cacheprog_num_entradas(cacheprog_t *self)
+{
+  return self->num_entradas;
+}
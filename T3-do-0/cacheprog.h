@@ -0,0 +1,53 @@
+// cacheprog.h
+// cache dos programas lidos de arquivos '.maq'
+// simulador de computador
+// so25b
+
+#ifndef CACHEPROG_H
+#define CACHEPROG_H
+
+// guarda os programas já lidos, identificados pelo nome do arquivo, para que
+//   criar outro processo com o mesmo programa não leia o arquivo de novo
+// uma entrada só é usada se o arquivo ainda tem a data de modificação e o
+//   tamanho que tinha quando foi lido; senão o arquivo é lido outra vez
+// cada programa obtido da cache conta como uma referência, devolvida com
+//   cacheprog_libera; um programa com referências nunca é destruído (nem
+//   quando o arquivo muda, só deixa de ser encontrado pelo nome), e dos sem
+//   referências a cache mantém os 'capacidade' usados mais recentemente
+
+#include "programa.h"
+
+// tipo opaco que representa a cache
+typedef struct cacheprog_t cacheprog_t;
+
+// cria uma cache vazia, que mantém até 'capacidade' programas sem referências
+// retorna NULL em caso de erro
+cacheprog_t *cacheprog_cria(int capacidade);
+
+// destrói a cache e todos os programas nela, mesmo os com referências
+void cacheprog_destroi(cacheprog_t *self);
+
+// retorna o programa contido no arquivo 'nome', com uma referência a mais;
+//   o arquivo só é lido se o programa não está na cache ou se ele mudou
+// o programa não deve ser destruído por quem o recebe
+// retorna NULL se o arquivo não existe ou não contém um programa
+programa_t *cacheprog_obtem(cacheprog_t *self, char *nome);
+
+// acrescenta uma referência a um programa obtido com cacheprog_obtem (para
+//   um processo que passa a compartilhá-lo), a ser devolvida com
+//   cacheprog_libera
+void cacheprog_retem(cacheprog_t *self, programa_t *prog);
+
+// devolve uma referência a um programa obtido com cacheprog_obtem
+void cacheprog_libera(cacheprog_t *self, programa_t *prog);
+
+// número de programas obtidos da cache sem ler o arquivo (acertos), lidos
+//   do arquivo (faltas), e de entradas descartadas porque o arquivo mudou
+int cacheprog_acertos(cacheprog_t *self);
+int cacheprog_faltas(cacheprog_t *self);
+int cacheprog_invalidacoes(cacheprog_t *self);
+
+// número de programas na cache (com ou sem referências)
+int cacheprog_num_entradas(cacheprog_t *self);
+
+#endif // CACHEPROG_H
@@ -0,0 +1,148 @@
+// checkpoint.c
+// gravação e restauração do estado da máquina inteira
+// simulador de computador
+// so25b
+
+#include "checkpoint.h"
+#include "terminal.h"
+#include "config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <assert.h>
+
+#define CHECKPOINT_MAGICO 0x4d415143 // "CQAM"
+#define CHECKPOINT_VERSAO 4
+
+struct checkpoint_t {
+  mem_t *mem;
+  cpu_t *cpu;
+  relogio_t *relogio;
+  disco_t *disco;
+  console_t *console;
+  so_t *so;
+};
+
+// cabeçalho do arquivo, com a configuração que precisa ser a mesma para que
+//   o estado gravado faça sentido
+typedef struct {
+  int magico;
+  int versao;
+  int tam_memoria;
+  int tam_pagina;
+  int fator_mem_secundaria;
+  int escalonador;
+  int instante;             // relógio na gravação, só para informação
+} cabecalho_t;
+
+checkpoint_t *checkpoint_cria(mem_t *mem, cpu_t *cpu, relogio_t *relogio,
+                              disco_t *disco, console_t *console, so_t *so)
+{
+  checkpoint_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->mem = mem;
+  self->cpu = cpu;
+  self->relogio = relogio;
+  self->disco = disco;
+  self->console = console;
+  self->so = so;
+  return self;
+}
+
+void checkpoint_destroi(checkpoint_t *self)
+{
+  free(self);
+}
+
+static void checkpoint_preenche_cabecalho(checkpoint_t *self, cabecalho_t *cab)
+{
+  cab->magico = CHECKPOINT_MAGICO;
+  cab->versao = CHECKPOINT_VERSAO;
+  cab->tam_memoria = mem_tam(self->mem);
+  cab->tam_pagina = CONFIG_TAM_PAGINA;
+  cab->fator_mem_secundaria = CONFIG_FATOR_MEM_SECUNDARIA;
+  cab->escalonador = CONFIG_ESCALONADOR;
+  relogio_leitura(self->relogio, 0, &cab->instante);
+}
+
+// grava ou lê os terminais, na ordem das letras
+static bool checkpoint_terminais(checkpoint_t *self, FILE *arq, bool grava)
+{
+  terminal_t *terminal;
+  for (char id = 'A'; (terminal = console_terminal(self->console, id)) != NULL; id++) {
+    bool ok = grava ? terminal_salva(terminal, arq) : terminal_restaura(terminal, arq);
+    if (!ok) return false;
+  }
+  return true;
+}
+
+// tempo em ms desde 'inicio', para mostrar o custo da operação
+static double checkpoint_ms_desde(clock_t inicio)
+{
+  return (double)(clock() - inicio) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+bool checkpoint_grava(checkpoint_t *self, char *nome)
+{
+  clock_t inicio = clock();
+  FILE *arq = fopen(nome, "wb");
+  if (arq == NULL) {
+    console_printf("Checkpoint: não foi possível criar '%s'", nome);
+    return false;
+  }
+  cabecalho_t cab;
+  checkpoint_preenche_cabecalho(self, &cab);
+  bool ok = fwrite(&cab, sizeof(cab), 1, arq) == 1
+            && mem_salva(self->mem, arq)
+            && cpu_salva(self->cpu, arq)
+            && relogio_salva(self->relogio, arq)
+            && disco_salva(self->disco, arq)
+            && checkpoint_terminais(self, arq, true)
+            && so_salva(self->so, arq);
+  long tamanho = ftell(arq);
+  if (fclose(arq) != 0) ok = false;
+  if (!ok) {
+    console_printf("Checkpoint: erro na gravação de '%s'", nome);
+    remove(nome);
+    return false;
+  }
+  console_printf("Checkpoint: máquina gravada em '%s' no instante %d (%ld bytes, %.1f ms)",
+                 nome, cab.instante, tamanho, checkpoint_ms_desde(inicio));
+  return true;
+}
+
+bool checkpoint_restaura(checkpoint_t *self, char *nome)
+{
+  clock_t inicio = clock();
+  FILE *arq = fopen(nome, "rb");
+  if (arq == NULL) {
+    console_printf("Checkpoint: não foi possível abrir '%s'", nome);
+    return false;
+  }
+  cabecalho_t esperado, cab;
+  checkpoint_preenche_cabecalho(self, &esperado);
+  if (fread(&cab, sizeof(cab), 1, arq) != 1
+      || cab.magico != esperado.magico || cab.versao != esperado.versao
+      || cab.tam_memoria != esperado.tam_memoria || cab.tam_pagina != esperado.tam_pagina
+      || cab.fator_mem_secundaria != esperado.fator_mem_secundaria
+      || cab.escalonador != esperado.escalonador) {
+    console_printf("Checkpoint: '%s' não é de uma máquina com esta configuração", nome);
+    fclose(arq);
+    return false;
+  }
+  bool ok = mem_restaura(self->mem, arq)
+            && cpu_restaura(self->cpu, arq)
+            && relogio_restaura(self->relogio, arq)
+            && disco_restaura(self->disco, arq)
+            && checkpoint_terminais(self, arq, false)
+            && so_restaura(self->so, arq);
+  fclose(arq);
+  if (!ok) {
+    console_printf("Checkpoint: erro na leitura de '%s'; a máquina está inconsistente", nome);
+    return false;
+  }
+  console_printf("Checkpoint: máquina restaurada de '%s', instante %d (%.1f ms)",
+                 nome, cab.instante, checkpoint_ms_desde(inicio));
+  return true;
+}
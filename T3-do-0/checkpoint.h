@@ -0,0 +1,52 @@
+// checkpoint.h
+// gravação e restauração do estado da máquina inteira
+// simulador de computador
+// so25b
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// grava num arquivo o estado completo da máquina simulada: memória principal,
+//   registradores da CPU, relógio, controlador do disco, terminais e SO
+//   (processos, filas, tabelas de páginas, estado da memória virtual, memória
+//   secundária e cache de blocos do disco), e restaura a máquina a partir
+//   desse arquivo
+// o conteúdo do disco fica no arquivo dele, e não é gravado: um checkpoint
+//   só deve ser restaurado com a imagem do disco que havia na gravação
+// serve para começar um experimento de uma máquina já aquecida (SO
+//   inicializado, processos criados, páginas carregadas) em vez de repetir a
+//   inicialização; o arquivo só é aceito por um simulador da mesma compilação
+//   e configuração (tamanho da memória e da página, escalonador)
+// a gravação e a restauração são feitas entre duas instruções, quando todo o
+//   estado está nas estruturas da máquina e do SO
+
+#include "memoria.h"
+#include "cpu.h"
+#include "relogio.h"
+#include "disco.h"
+#include "console.h"
+#include "so.h"
+
+#include <stdbool.h>
+
+typedef struct checkpoint_t checkpoint_t;
+
+// cria o gravador do checkpoint da máquina formada pelos componentes
+//   fornecidos (que não pertencem a ele)
+checkpoint_t *checkpoint_cria(mem_t *mem, cpu_t *cpu, relogio_t *relogio,
+                              disco_t *disco, console_t *console, so_t *so);
+
+// destrói o gravador
+void checkpoint_destroi(checkpoint_t *self);
+
+// grava o estado da máquina no arquivo 'nome'
+// retorna false em caso de erro, informado na console
+bool checkpoint_grava(checkpoint_t *self, char *nome);
+
+// restaura o estado da máquina gravado no arquivo 'nome'
+// retorna false em caso de erro, informado na console; um arquivo de outra
+//   configuração é recusado sem alterar a máquina, mas um erro de leitura
+//   depois disso (arquivo truncado) deixa a máquina inconsistente
+bool checkpoint_restaura(checkpoint_t *self, char *nome);
+
+#endif // CHECKPOINT_H
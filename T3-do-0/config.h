@@ -11,6 +11,11 @@ typedef enum {
   SUBSTITUICAO_FIFO
 } substituicao_algoritmo_t;
 
+// programa executado pelo processo inicial; com "init_testes.maq", em vez de
+//   p1, p2 e p3 sao executados os programas de teste (teste_*.maq), um de cada
+//   vez
+#define CONFIG_PROGRAMA_INICIAL "init.maq"
+
 // tamanho da memoria principal (em palavras)
 #define CONFIG_TAM_MEMORIA_PRINCIPAL 200
 
@@ -27,4 +32,124 @@ typedef enum {
 // fator multiplicador do tamanho da memoria secundaria em relacao a principal
 #define CONFIG_FATOR_MEM_SECUNDARIA 4
 
+// tamanho maximo (em palavras) que um processo pode acrescentar com SO_SBRK
+#define CONFIG_TAM_MAX_HEAP 1000
+
+// programas sem processos que os executam mantidos na cache de programas, para
+//   que SO_CRIA_PROC não leia de novo o arquivo '.maq' (os que estão em uso
+//   ficam na cache enquanto durarem os processos)
+#define CONFIG_CACHE_PROGRAMAS 8
+
+// arquivo do hospedeiro que guarda a memoria secundaria (mapeado com mmap)
+// se definido, a memoria secundaria so ocupa cache de paginas do hospedeiro;
+//   o arquivo e zerado a cada execucao
+// se nao definido, a memoria secundaria fica no heap do simulador
+// #define CONFIG_ARQUIVO_MEM_SECUNDARIA "mem_sec.img"
+
+// checkpoint da máquina inteira (memória, CPU, relógio, terminais, SO e
+//   memória secundária), para começar experimentos de uma máquina já
+//   aquecida: arquivo gravado com o comando 'S' da console e restaurado com 'R'
+#define CONFIG_ARQUIVO_CHECKPOINT "maquina.ckp"
+// grava o checkpoint automaticamente quando o relógio chega a esse instante
+//   (em instruções); comente para gravar só com o comando
+// #define CONFIG_CHECKPOINT_INSTANTE 10000
+// restaura o checkpoint na inicialização, em vez de partir do boot (a
+//   simulação começa parada, como sempre); comente para sempre partir do boot
+// #define CONFIG_CHECKPOINT_RESTAURA
+
+// tamanho (em caracteres) do buffer de saída que o SO mantém para cada
+//   terminal (SO_ESCR_BUF)
+#define CONFIG_TAM_BUF_TERMINAL 64
+
+// disco e sistema de arquivos (SO_ABRE, SO_FECHA, SO_SEL_LE, SO_SEL_ESCR)
+// arquivo do hospedeiro com a imagem do disco (criada por cria_disco, com os
+//   arquivos que os programas podem abrir), número de blocos do disco e tempo
+//   (em instruções) de cada leitura ou gravação de bloco
+#define CONFIG_ARQUIVO_DISCO "disco.img"
+#define CONFIG_DISCO_BLOCOS 256
+#define CONFIG_DISCO_LATENCIA 20
+// blocos do disco mantidos pelo SO na cache de blocos (LRU)
+#define CONFIG_CACHE_BLOCOS 8
+// um bloco alterado na cache só é gravado no disco depois desse tempo (em
+//   instruções) desde a primeira alteração, para que as alterações seguintes
+//   sejam gravadas juntas (ou antes, se o arquivo for fechado)
+#define CONFIG_CACHE_ATRASO_GRAVACAO 300
+// arquivos abertos ao mesmo tempo por processo
+#define CONFIG_ARQUIVOS_POR_PROCESSO 4
+// blocos reservados para um arquivo criado com SO_ABRE (o arquivo não cresce
+//   além deles)
+#define CONFIG_FS_BLOCOS_NOVO_ARQUIVO 8
+
+// relógio sem tick periódico: o timer é programado só para o próximo evento
+//   que precisa do SO (fim de quantum com outro processo pronto, fim de
+//   transferência de página, prazo de envelhecimento), em vez de interromper a
+//   cada tick; comente para voltar à interrupção a cada tick
+#define CONFIG_RELOGIO_SEM_TICK
+// com o relógio sem tick, número máximo de ticks entre envelhecimentos das
+//   páginas do processo em execução (menos ticks, LRU mais preciso)
+#define CONFIG_RELOGIO_TICKS_ENVELHECIMENTO 4
+
+// quantum adaptativo (ESCAL_CIRCULAR, ESCAL_PRIORIDADE, ESCAL_STRIDE e
+//   ESCAL_LOTERIA): cada processo tem seu quantum, que dobra quando ele é
+//   preemptado por gastar o quantum inteiro e encolhe para perto da sua
+//   rajada média quando bloqueia para E/S; comente para usar o mesmo quantum
+//   fixo para todos
+#define CONFIG_QUANTUM_ADAPTATIVO
+// limites do quantum adaptativo (em ticks do relógio)
+#define CONFIG_QUANTUM_MINIMO 1
+#define CONFIG_QUANTUM_MAXIMO 12
+// tempo de resposta alvo (em ticks do relógio): o quantum concedido é
+//   limitado para que os outros prontos não esperem mais que isso
+#define CONFIG_ALVO_RESPOSTA 12
+
+// escalonamento ciente da memória (ESCAL_PRIORIDADE): com a memória principal
+//   cheia, a escolha leva em conta quanto do conjunto de trabalho de cada
+//   processo ainda está residente (quadros que ocupava ao deixar a CPU frente
+//   aos que ocupa agora), e os processos com taxa de faltas acima do limite
+//   são segurados, só executando quando não há outro pronto; comente para
+//   escalonar sem olhar a memória
+#define CONFIG_ESCALONAMENTO_MEMORIA
+// taxa de faltas (por 1000 instruções executadas) acima da qual o processo é
+//   segurado
+#define CONFIG_LIMITE_TAXA_FALTAS 25
+// janela (em instruções executadas pelo processo) da taxa de faltas; a cada
+//   janela as contagens são divididas por 2
+#define CONFIG_JANELA_FALTAS 500
+
+// classe de tempo real (SO_TEMPO_REAL), escalonada por EDF antes da classe do
+//   escalonador configurado: soma máxima, em porcentagem, das densidades
+//   (orçamento / prazo) dos processos de tempo real; o que sobra fica para os
+//   demais processos
+#define CONFIG_EDF_UTILIZACAO_MAXIMA 90
+
+// escalonador de processos (ESCAL_CIRCULAR, ESCAL_PRIORIDADE, ESCAL_MLFQ,
+//   ESCAL_CFS, ESCAL_STRIDE ou ESCAL_LOTERIA, definidos em so.h)
+#define CONFIG_ESCALONADOR ESCAL_PRIORIDADE
+
+// filas multinível com realimentação (ESCAL_MLFQ)
+// número de níveis (no máximo 32); o nível 0 é o de maior prioridade
+#define CONFIG_MLFQ_NIVEIS 4
+// quantum do nível 0 (em interrupções de relógio); dobra a cada nível, até
+//   CONFIG_MLFQ_QUANTUM_MAXIMO
+#define CONFIG_MLFQ_QUANTUM_INICIAL 2
+#define CONFIG_MLFQ_QUANTUM_MAXIMO 1024
+// intervalo (em interrupções de relógio) entre as elevações de todos os
+//   processos ao nível 0, para evitar inanição
+#define CONFIG_MLFQ_INTERVALO_ELEVACAO 100
+
+// escalonador justo (ESCAL_CFS)
+// latência alvo (em interrupções de relógio): período em que todos os
+//   processos prontos devem executar uma vez; a fatia de cada um é a parte
+//   desse período proporcional ao seu peso
+#define CONFIG_CFS_LATENCIA 12
+// fatia mínima (em interrupções de relógio), mesmo com muitos prontos
+#define CONFIG_CFS_FATIA_MINIMA 1
+
+// escalonadores proporcionais (ESCAL_STRIDE e ESCAL_LOTERIA)
+// bilhetes do processo inicial (os demais herdam do criador, ou recebem em
+//   SO_CRIA_PROC_BILH)
+#define CONFIG_BILHETES_PADRAO 100
+// semente do sorteio da loteria, para execuções reproduzíveis
+#define CONFIG_LOTERIA_SEMENTE 1
+
 #endif // CONFIG_H
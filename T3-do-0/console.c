@@ -126,6 +126,31 @@ terminal_t *console_terminal(console_t *self, char id_terminal)
   return self->term[num_terminal];
 }
 
+int console_interrupcoes(console_t *self)
+{
+  int pendentes = 0;
+  for (int t = 0; t < N_TERM; t++) {
+    pendentes |= terminal_interrupcao(self->term[t]) << (2 * t);
+  }
+  return pendentes;
+}
+
+err_t console_leitura_interrupcao(void *disp, int id, int *pvalor)
+{
+  console_t *self = disp;
+  *pvalor = console_interrupcoes(self);
+  return ERR_OK;
+}
+
+err_t console_escrita_interrupcao(void *disp, int id, int valor)
+{
+  console_t *self = disp;
+  for (int t = 0; t < N_TERM; t++) {
+    terminal_reconhece_interrupcao(self->term[t], (valor >> (2 * t)) & 3);
+  }
+  return ERR_OK;
+}
+
 static void atualiza_terminais(console_t *self)
 {
   for (int t = 0; t < N_TERM; t++) {
@@ -135,7 +160,7 @@ static void atualiza_terminais(console_t *self)
 
 static void insere_string_no_terminal(console_t *self, char id_terminal, char *str)
 {
-  // insere caracteres no terminal (e espaço no final)
+  // insere caracteres no terminal (e '\n' no final, cada entrada é uma linha)
   terminal_t *terminal = console_terminal(self, id_terminal);
   if (terminal == NULL) {
     console_printf("Terminal '%c' inválido\n", id_terminal);
@@ -146,7 +171,7 @@ static void insere_string_no_terminal(console_t *self, char id_terminal, char *s
     terminal_insere_char(terminal, *p);
     p++;
   }
-  terminal_insere_char(terminal, ' ');
+  terminal_insere_char(terminal, '\n');
 }
 
 static void limpa_saida_do_terminal(console_t *self, char id_terminal)
@@ -247,6 +272,8 @@ static void interpreta_linha_entrada(console_t *self)
   // 1     executa uma instrução
   // C     continua a execução
   // F     fim da simulação
+  // S     grava o checkpoint da máquina
+  // R     restaura o checkpoint da máquina
 
   char *linha = self->txt_entrada;
   console_printf("CMD: '%s'", linha);
@@ -267,6 +294,8 @@ static void interpreta_linha_entrada(console_t *self)
     case '1':
     case 'C':
     case 'F':
+    case 'S':
+    case 'R':
       insere_comando_externo(self, cmd);
       break;
     default:
@@ -320,8 +349,11 @@ static void desenha_terminais(console_t *self)
     int cor_txt = self->cor_txt[t];
     int cor_cursor = self->cor_cursor[t];
     int linha = LINHA_TERM + t * 2;
-    desenha_linha_terminal(terminal_txt_entrada(terminal), linha, cor_txt, cor_cursor);
-    desenha_linha_terminal(terminal_txt_saida(terminal), linha+1, cor_txt, cor_cursor);
+    char txt[N_COL + 1];
+    terminal_txt_entrada(terminal, txt);
+    desenha_linha_terminal(txt, linha, cor_txt, cor_cursor);
+    terminal_txt_saida(terminal, txt);
+    desenha_linha_terminal(txt, linha+1, cor_txt, cor_cursor);
   }
 }
 
@@ -343,7 +375,7 @@ static void desenha_console(console_t *self)
 
 static void desenha_entrada(console_t *self)
 {
-  char txt_fixo[] = "P=para C=continua 1=passo F=fim  Ets=entra Zt=zera";
+  char txt_fixo[] = "P=para C=continua 1=passo F=fim S/R=checkpoint Ets=entra Zt=zera";
   tela_posiciona(LINHA_ENTRADA, 0);
   tela_puts(COR_ENTRADA, ""); // gambiarra para limpar na cor certa
   tela_limpa_linha();
@@ -30,7 +30,9 @@ void console_print_status(console_t *self, char *txt);
 //   'P': para a execução,
 //   '1': executa uma instrução,
 //   'C': continua a execução,
-//   'F': finaliza a simulação.
+//   'F': finaliza a simulação,
+//   'S': grava o checkpoint da máquina,
+//   'R': restaura o checkpoint da máquina.
 // retorna '\0' caso não tenha comando externo digitado
 char console_comando_externo(console_t *self);
 
@@ -40,4 +42,15 @@ terminal_t *console_terminal(console_t *self, char id_terminal);
 // esta função deve ser chamada periodicamente para que tela funcione
 void console_tictac(console_t *self);
 
+// a console é também o controlador de interrupção dos seus terminais
+// retorna as interrupções pendentes: o bit 2*t é o pedido do teclado e o bit
+//   2*t+1 o da tela do terminal t (0 é o 'A')
+int console_interrupcoes(console_t *self);
+
+// Funções para o dispositivo D_TERM_INTERRUPCAO, que segue o protocolo de
+//   acesso do controlador de E/S (es.h): a leitura retorna as interrupções
+//   pendentes, a escrita desliga as que estiverem ligadas no valor escrito
+err_t console_leitura_interrupcao(void *disp, int id, int *pvalor);
+err_t console_escrita_interrupcao(void *disp, int id, int valor);
+
 #endif // CONSOLE_H
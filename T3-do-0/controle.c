@@ -4,6 +4,7 @@
 // so25b
 
 #include "controle.h"
+#include "config.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -13,16 +14,19 @@
 struct controle_t {
   cpu_t *cpu;
   relogio_t *relogio;
+  disco_t *disco;
   console_t *console;
+  checkpoint_t *checkpoint;
   enum { executando, passo, parado, fim } estado;
 };
 
 // funções auxiliares
 static void controle_processa_comandos_da_console(controle_t *self);
 static void controle_atualiza_estado_na_console(controle_t *self);
+static void controle_verifica_instante_checkpoint(controle_t *self);
 
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio, disco_t *disco)
 {
   controle_t *self = malloc(sizeof(*self));
   assert(self != NULL);
@@ -30,6 +34,8 @@ controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio)
   self->cpu = cpu;
   self->console = console;
   self->relogio = relogio;
+  self->disco = disco;
+  self->checkpoint = NULL;
   self->estado = parado;
 
   return self;
@@ -40,6 +46,11 @@ void controle_destroi(controle_t *self)
   free(self);
 }
 
+void controle_define_checkpoint(controle_t *self, checkpoint_t *checkpoint)
+{
+  self->checkpoint = checkpoint;
+}
+
 void controle_laco(controle_t *self)
 {
   // executa uma instrução por vez até a console dizer que chega
@@ -47,6 +58,7 @@ void controle_laco(controle_t *self)
     if (self->estado == passo || self->estado == executando) {
       cpu_executa_1(self->cpu);
       relogio_tictac(self->relogio);
+      disco_tictac(self->disco);
 
       if (self->estado == passo) self->estado = parado;
 
@@ -57,6 +69,16 @@ void controle_laco(controle_t *self)
       if (tem_int != 0) {
         cpu_interrompe(self->cpu, IRQ_RELOGIO);
       }
+      // os terminais pedem interrupção pela console; se a CPU já aceitou a
+      //   do relógio, esta continua pendente e é aceita depois
+      if (console_interrupcoes(self->console) != 0) {
+        cpu_interrompe(self->cpu, IRQ_TERMINAL);
+      }
+      disco_leitura(self->disco, DISCO_INTERRUPCAO, &tem_int);
+      if (tem_int != 0) {
+        cpu_interrompe(self->cpu, IRQ_DISCO);
+      }
+      controle_verifica_instante_checkpoint(self);
     }
     console_tictac(self->console);
 
@@ -84,7 +106,31 @@ static void controle_processa_comandos_da_console(controle_t *self)
     case 'C':
       self->estado = executando;
       break;
+    case 'S':
+      if (self->checkpoint != NULL) {
+        checkpoint_grava(self->checkpoint, CONFIG_ARQUIVO_CHECKPOINT);
+      }
+      break;
+    case 'R':
+      // uma máquina restaurada pela metade não pode continuar executando
+      if (self->checkpoint != NULL
+          && !checkpoint_restaura(self->checkpoint, CONFIG_ARQUIVO_CHECKPOINT)) {
+        self->estado = parado;
+      }
+      break;
+  }
+}
+
+// grava o checkpoint quando o relógio chega a CONFIG_CHECKPOINT_INSTANTE
+static void controle_verifica_instante_checkpoint(controle_t *self)
+{
+#ifdef CONFIG_CHECKPOINT_INSTANTE
+  int agora;
+  relogio_leitura(self->relogio, 0, &agora);
+  if (agora == CONFIG_CHECKPOINT_INSTANTE && self->checkpoint != NULL) {
+    checkpoint_grava(self->checkpoint, CONFIG_ARQUIVO_CHECKPOINT);
   }
+#endif
 }
 
 static void controle_atualiza_estado_na_console(controle_t *self)
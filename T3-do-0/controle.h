@@ -11,10 +11,16 @@ typedef struct controle_t controle_t;
 #include "cpu.h"
 #include "console.h"
 #include "relogio.h"
+#include "disco.h"
+#include "checkpoint.h"
 
-controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio);
+controle_t *controle_cria(cpu_t *cpu, console_t *console, relogio_t *relogio, disco_t *disco);
 void controle_destroi(controle_t *self);
 
+// define o checkpoint da máquina usado pelos comandos 'S' (grava) e 'R'
+//   (restaura) da console e pela gravação em CONFIG_CHECKPOINT_INSTANTE
+void controle_define_checkpoint(controle_t *self, checkpoint_t *checkpoint);
+
 // o laço principal da simulação
 void controle_laco(controle_t *self);
 
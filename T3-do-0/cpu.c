@@ -576,4 +576,38 @@ static void cpu_desinterrompe(cpu_t *self)
   self->modo        = usuario;
 }
 
+
+// ---------------------------------------------------------------------
+// CHECKPOINT {{{1
+// ---------------------------------------------------------------------
+
+// registradores e estado interno, na ordem em que são gravados
+typedef struct {
+  int PC;
+  int A;
+  int X;
+  int erro;
+  int complemento;
+  int modo;
+} cpu_registros_t;
+
+bool cpu_salva(cpu_t *self, FILE *arq)
+{
+  cpu_registros_t r = { self->PC, self->A, self->X, self->erro, self->complemento, self->modo };
+  return fwrite(&r, sizeof(r), 1, arq) == 1;
+}
+
+bool cpu_restaura(cpu_t *self, FILE *arq)
+{
+  cpu_registros_t r;
+  if (fread(&r, sizeof(r), 1, arq) != 1) return false;
+  self->PC = r.PC;
+  self->A = r.A;
+  self->X = r.X;
+  self->erro = r.erro;
+  self->complemento = r.complemento;
+  self->modo = r.modo;
+  return true;
+}
+
 // vim: foldmethod=marker
@@ -34,6 +34,9 @@ typedef enum { supervisor, usuario } cpu_modo_t;
 #include "irq.h"
 #include "mmu.h"
 
+#include <stdbool.h>
+#include <stdio.h>
+
 // tipo da função a ser chamada quando executar a instrução CHAMAC
 typedef int (*func_chamaC_t)(void *argC, int reg_A);
 
@@ -65,4 +68,10 @@ void cpu_define_chamaC(cpu_t *self, func_chamaC_t func, void *argC);
 // concatena a descrição do estado da CPU no final de str
 void cpu_concatena_descricao(cpu_t *self, char *str);
 
+// grava em 'arq' os registradores e o modo da CPU (checkpoint da máquina), e
+//   recupera o que foi gravado; a MMU, a E/S e a função de CHAMAC não mudam
+// retornam false em caso de erro de escrita ou leitura
+bool cpu_salva(cpu_t *self, FILE *arq);
+bool cpu_restaura(cpu_t *self, FILE *arq);
+
 #endif // CPU_H
@@ -0,0 +1,95 @@
+// cria_disco.c
+// cria a imagem do disco, com um sistema de arquivos e arquivos do hospedeiro
+// simulador de computador
+// so25b
+
+// uso: cria_disco imagem [arquivo ...]
+// a imagem tem CONFIG_DISCO_BLOCOS blocos, no formato de sistarq.h; cada
+//   arquivo é copiado com o nome sem o diretório, um caractere por palavra,
+//   ocupando os blocos necessários (pelo menos um)
+
+#include "sistarq.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int disco[CONFIG_DISCO_BLOCOS][DISCO_TAM_BLOCO];
+
+// aborta o programa com uma mensagem de erro
+static void erro_brabo(char *msg, char *nome)
+{
+  fprintf(stderr, "ERRO FATAL: %s '%s'\n", msg, nome);
+  exit(1);
+}
+
+// copia o arquivo 'caminho' para a entrada 'n' do diretório, a partir do
+//   bloco 'inicio'; retorna o primeiro bloco depois dele
+static int copia_arquivo(char *caminho, int n, int inicio)
+{
+  char *nome = strrchr(caminho, '/');
+  nome = (nome == NULL) ? caminho : nome + 1;
+  if (strlen(nome) == 0 || strlen(nome) > FS_TAM_NOME) {
+    erro_brabo("nome de arquivo vazio ou muito grande:", nome);
+  }
+  if (n >= FS_NUM_ENTRADAS) {
+    erro_brabo("diretório cheio, não cabe", nome);
+  }
+  FILE *arq = fopen(caminho, "r");
+  if (arq == NULL) {
+    erro_brabo("não foi possível abrir", caminho);
+  }
+
+  int tamanho = 0;
+  int c;
+  while ((c = fgetc(arq)) != EOF) {
+    int bloco = inicio + tamanho / DISCO_TAM_BLOCO;
+    if (bloco >= CONFIG_DISCO_BLOCOS) {
+      erro_brabo("disco cheio, não cabe", nome);
+    }
+    disco[bloco][tamanho % DISCO_TAM_BLOCO] = (unsigned char)c;
+    tamanho++;
+  }
+  fclose(arq);
+
+  int num_blocos = (tamanho + DISCO_TAM_BLOCO - 1) / DISCO_TAM_BLOCO;
+  if (num_blocos == 0) num_blocos = 1;
+  if (inicio + num_blocos > CONFIG_DISCO_BLOCOS) {
+    erro_brabo("disco cheio, não cabe", nome);
+  }
+
+  int *ent = &disco[1 + n / FS_ENTRADAS_POR_BLOCO][(n % FS_ENTRADAS_POR_BLOCO) * FS_TAM_ENTRADA];
+  for (int i = 0; nome[i] != '\0'; i++) {
+    ent[FS_ENT_NOME + i] = (unsigned char)nome[i];
+  }
+  ent[FS_ENT_INICIO] = inicio;
+  ent[FS_ENT_BLOCOS] = num_blocos;
+  ent[FS_ENT_TAMANHO] = tamanho;
+  printf("%-12s blocos %d a %d, %d caracteres\n", nome, inicio, inicio + num_blocos - 1, tamanho);
+  return inicio + num_blocos;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "uso: %s imagem [arquivo ...]\n", argv[0]);
+    exit(1);
+  }
+
+  disco[0][FS_SB_MAGICO] = FS_MAGICO;
+  disco[0][FS_SB_BLOCOS] = CONFIG_DISCO_BLOCOS;
+  int livre = FS_PRIMEIRO_BLOCO_DADOS;
+  for (int i = 2; i < argc; i++) {
+    livre = copia_arquivo(argv[i], i - 2, livre);
+  }
+
+  FILE *imagem = fopen(argv[1], "wb");
+  if (imagem == NULL) {
+    erro_brabo("não foi possível criar", argv[1]);
+  }
+  if (fwrite(disco, sizeof(disco), 1, imagem) != 1 || fclose(imagem) != 0) {
+    erro_brabo("erro na gravação de", argv[1]);
+  }
+  return 0;
+}
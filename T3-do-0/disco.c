@@ -0,0 +1,171 @@
+// disco.c
+// dispositivo de E/S de blocos (disco)
+// simulador de computador
+// so25b
+
+#include "disco.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+struct disco_t {
+  // arquivo com o conteúdo dos blocos
+  FILE *imagem;
+  int num_blocos;
+  // tempo que demora cada operação
+  int latencia;
+  // bloco da próxima operação
+  int bloco;
+  // buffer do controlador, e posição do próximo acesso a ele
+  int buffer[DISCO_TAM_BLOCO];
+  int pos;
+  // operação em andamento (DISCO_LE, DISCO_GRAVA) ou 0, e quanto falta
+  int comando;
+  int t_restante;
+  // true se a última operação falhou
+  bool erro;
+  // true se está gerando interrupção
+  bool interrupcao_ativa;
+};
+
+disco_t *disco_cria(char *nome, int num_blocos, int latencia)
+{
+  FILE *imagem = fopen(nome, "r+b");
+  if (imagem == NULL) {
+    imagem = fopen(nome, "w+b");
+  }
+  if (imagem == NULL) {
+    return NULL;
+  }
+
+  disco_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+
+  self->imagem = imagem;
+  self->num_blocos = num_blocos;
+  self->latencia = latencia > 0 ? latencia : 1;
+  self->bloco = 0;
+  self->pos = 0;
+  self->comando = 0;
+  self->t_restante = 0;
+  self->erro = false;
+  self->interrupcao_ativa = false;
+
+  return self;
+}
+
+void disco_destroi(disco_t *self)
+{
+  fclose(self->imagem);
+  free(self);
+}
+
+// transfere o buffer de/para o bloco no arquivo
+static void disco_transfere(disco_t *self)
+{
+  long desloc = (long)self->bloco * DISCO_TAM_BLOCO * sizeof(int);
+  self->erro = fseek(self->imagem, desloc, SEEK_SET) != 0;
+  if (self->erro) return;
+  if (self->comando == DISCO_LE) {
+    // o que estiver além do fim do arquivo é lido como zero
+    size_t lidas = fread(self->buffer, sizeof(int), DISCO_TAM_BLOCO, self->imagem);
+    for (size_t i = lidas; i < DISCO_TAM_BLOCO; i++) {
+      self->buffer[i] = 0;
+    }
+    clearerr(self->imagem);
+  } else {
+    self->erro = fwrite(self->buffer, sizeof(int), DISCO_TAM_BLOCO, self->imagem) != DISCO_TAM_BLOCO
+                 || fflush(self->imagem) != 0;
+  }
+}
+
+void disco_tictac(disco_t *self)
+{
+  if (self->comando == 0) return;
+  self->t_restante--;
+  if (self->t_restante > 0) return;
+  // a operação terminou: faz a transferência e pede interrupção
+  disco_transfere(self);
+  self->comando = 0;
+  self->pos = 0;
+  self->interrupcao_ativa = true;
+}
+
+err_t disco_leitura(void *disp, int id, int *pvalor)
+{
+  disco_t *self = disp;
+  switch (id) {
+    case DISCO_BLOCO:
+      *pvalor = self->bloco;
+      break;
+    case DISCO_DADO:
+      if (self->comando != 0) return ERR_OCUP;
+      *pvalor = self->buffer[self->pos];
+      self->pos = (self->pos + 1) % DISCO_TAM_BLOCO;
+      break;
+    case DISCO_COMANDO:
+      *pvalor = self->comando != 0 ? 1 : (self->erro ? -1 : 0);
+      break;
+    case DISCO_INTERRUPCAO:
+      *pvalor = self->interrupcao_ativa;
+      break;
+    default:
+      return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+err_t disco_escrita(void *disp, int id, int valor)
+{
+  disco_t *self = disp;
+  switch (id) {
+    case DISCO_BLOCO:
+      if (self->comando != 0) return ERR_OCUP;
+      if (valor < 0 || valor >= self->num_blocos) return ERR_END_INV;
+      self->bloco = valor;
+      self->pos = 0;
+      break;
+    case DISCO_DADO:
+      if (self->comando != 0) return ERR_OCUP;
+      self->buffer[self->pos] = valor;
+      self->pos = (self->pos + 1) % DISCO_TAM_BLOCO;
+      break;
+    case DISCO_COMANDO:
+      if (self->comando != 0) return ERR_OCUP;
+      if (valor != DISCO_LE && valor != DISCO_GRAVA) return ERR_OP_INV;
+      self->comando = valor;
+      self->t_restante = self->latencia;
+      self->erro = false;
+      break;
+    case DISCO_INTERRUPCAO:
+      self->interrupcao_ativa = (valor != 0);
+      break;
+    default:
+      return ERR_END_INV;
+  }
+  return ERR_OK;
+}
+
+bool disco_salva(disco_t *self, FILE *arq)
+{
+  int campos[] = { self->num_blocos, self->bloco, self->pos, self->comando,
+                   self->t_restante, self->erro, self->interrupcao_ativa };
+  return fwrite(campos, sizeof(campos), 1, arq) == 1
+         && fwrite(self->buffer, sizeof(self->buffer), 1, arq) == 1;
+}
+
+bool disco_restaura(disco_t *self, FILE *arq)
+{
+  int campos[7];
+  if (fread(campos, sizeof(campos), 1, arq) != 1 || campos[0] != self->num_blocos
+      || fread(self->buffer, sizeof(self->buffer), 1, arq) != 1) {
+    return false;
+  }
+  self->bloco = campos[1];
+  self->pos = campos[2];
+  self->comando = campos[3];
+  self->t_restante = campos[4];
+  self->erro = campos[5];
+  self->interrupcao_ativa = campos[6];
+  return true;
+}
@@ -0,0 +1,73 @@
+// disco.h
+// dispositivo de E/S de blocos (disco)
+// simulador de computador
+// so25b
+
+#ifndef DISCO_H
+#define DISCO_H
+
+// simulador de um disco
+// dispositivo de E/S que guarda blocos de DISCO_TAM_BLOCO palavras num
+//   arquivo do hospedeiro (a imagem do disco), que sobrevive entre execuções
+// o acesso é feito por um buffer de um bloco no controlador: para gravar, o
+//   número do bloco e as palavras são colocados no controlador e o comando
+//   DISCO_GRAVA é dado; para ler, o comando DISCO_LE é dado depois do número
+//   do bloco, e as palavras são lidas do buffer quando a operação termina
+// cada operação demora 'latencia' unidades de tempo (tictac); o buffer não
+//   pode ser acessado nem outra operação iniciada enquanto isso, e no fim é
+//   pedida uma interrupção
+//
+// tem 4 dispositivos (id), para:
+// - ler ou escrever o número do bloco da próxima operação (volta a posição
+//   do buffer para o início)
+// - ler ou escrever a próxima palavra do buffer (a posição avança a cada acesso)
+// - iniciar uma operação (escrita), ou ler o estado do disco: 0 livre,
+//   1 ocupado, -1 se a última operação falhou
+// - ler ou escrever se uma interrupção está sendo pedida pelo disco
+
+#include "err.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// número de palavras em um bloco
+#define DISCO_TAM_BLOCO 32
+
+// os dispositivos do disco
+#define DISCO_BLOCO       0
+#define DISCO_DADO        1
+#define DISCO_COMANDO     2
+#define DISCO_INTERRUPCAO 3
+
+// os comandos do disco
+#define DISCO_LE    1
+#define DISCO_GRAVA 2
+
+typedef struct disco_t disco_t;
+
+// cria um disco com 'num_blocos' blocos, guardados no arquivo 'nome' (criado
+//   se não existir; os blocos além do fim do arquivo contêm zeros), cujas
+//   operações demoram 'latencia' unidades de tempo
+// retorna NULL se não for possível abrir ou criar o arquivo
+disco_t *disco_cria(char *nome, int num_blocos, int latencia);
+
+// destrói um disco (o arquivo permanece)
+void disco_destroi(disco_t *self);
+
+// registra a passagem de uma unidade de tempo
+// esta função é chamada pelo controlador após a execução de cada instrução
+void disco_tictac(disco_t *self);
+
+// Funções para acessar o disco como dispositivo de E/S, com os ids acima
+// Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h
+err_t disco_leitura(void *disp, int id, int *pvalor);
+err_t disco_escrita(void *disp, int id, int valor);
+
+// grava em 'arq' o estado do controlador do disco (checkpoint da máquina), e
+//   recupera o estado gravado; o conteúdo dos blocos está no arquivo do
+//   disco, e não é gravado
+// retornam false em caso de erro de escrita ou leitura
+bool disco_salva(disco_t *self, FILE *arq);
+bool disco_restaura(disco_t *self, FILE *arq);
+
+#endif // DISCO_H
@@ -33,6 +33,14 @@ typedef enum {
   D_RELOGIO_REAL,
   D_RELOGIO_TIMER,
   D_RELOGIO_INTERRUPCAO,
+  // interrupções pendentes dos terminais: o bit 2*t (teclado) ou 2*t+1
+  //   (tela) está ligado se o terminal t (0 é o A) pediu interrupção nesse
+  //   sentido; a escrita de um valor desliga os bits ligados nele
+  D_TERM_INTERRUPCAO,
+  D_DISCO_BLOCO,
+  D_DISCO_DADO,
+  D_DISCO_COMANDO,
+  D_DISCO_INTERRUPCAO,
   N_DISPOSITIVOS
 } dispositivo_id_t;
 
@@ -15,6 +15,7 @@ static char *nomes[N_ERR] = {
   [ERR_OCUP]        = "Dispositivo ocupado",
   [ERR_INSTR_PRIV]  = "Instrução privilegiada",
   [ERR_PAG_AUSENTE] = "Página ausente",
+  [ERR_PAG_PROTEGIDA] = "Página protegida",
 };
 
 // retorna o nome de erro
@@ -0,0 +1,188 @@
+// fprio.c
+// fila de prioridade indexada (heap binário de mínimo)
+// simulador de computador
+// so25b
+
+#include "fprio.h"
+#include <stdlib.h>
+#include <assert.h>
+
+struct fprio_t {
+  int capacidade;
+  int tamanho;
+  // heap[i] é o identificador na posição i do heap
+  int *heap;
+  // pos[id] é a posição de id no heap, ou -1 se não está na fila
+  int *pos;
+  // chave[id] é a chave de id
+  double *chave;
+};
+
+fprio_t *fprio_cria(int capacidade)
+{
+  fprio_t *self = malloc(sizeof(*self));
+  assert(self != NULL);
+  self->capacidade = capacidade;
+  self->tamanho = 0;
+  self->heap = malloc(capacidade * sizeof(*self->heap));
+  self->pos = malloc(capacidade * sizeof(*self->pos));
+  self->chave = malloc(capacidade * sizeof(*self->chave));
+  assert(self->heap != NULL && self->pos != NULL && self->chave != NULL);
+  for (int id = 0; id < capacidade; id++) {
+    self->pos[id] = -1;
+    self->chave[id] = 0;
+  }
+  return self;
+}
+
+void fprio_destroi(fprio_t *self)
+{
+  if (self == NULL) return;
+  free(self->heap);
+  free(self->pos);
+  free(self->chave);
+  free(self);
+}
+
+void fprio_aumenta(fprio_t *self, int capacidade)
+{
+  if (capacidade <= self->capacidade) return;
+  self->heap = realloc(self->heap, capacidade * sizeof(*self->heap));
+  self->pos = realloc(self->pos, capacidade * sizeof(*self->pos));
+  self->chave = realloc(self->chave, capacidade * sizeof(*self->chave));
+  assert(self->heap != NULL && self->pos != NULL && self->chave != NULL);
+  for (int id = self->capacidade; id < capacidade; id++) {
+    self->pos[id] = -1;
+    self->chave[id] = 0;
+  }
+  self->capacidade = capacidade;
+}
+
+int fprio_tamanho(fprio_t *self)
+{
+  return self->tamanho;
+}
+
+bool fprio_contem(fprio_t *self, int id)
+{
+  return id >= 0 && id < self->capacidade && self->pos[id] >= 0;
+}
+
+// true se o identificador 'a' deve vir antes de 'b'
+static bool antes(fprio_t *self, int a, int b)
+{
+  if (self->chave[a] != self->chave[b]) return self->chave[a] < self->chave[b];
+  return a < b;
+}
+
+static void coloca(fprio_t *self, int i, int id)
+{
+  self->heap[i] = id;
+  self->pos[id] = i;
+}
+
+static void sobe(fprio_t *self, int i)
+{
+  int id = self->heap[i];
+  while (i > 0) {
+    int pai = (i - 1) / 2;
+    if (!antes(self, id, self->heap[pai])) break;
+    coloca(self, i, self->heap[pai]);
+    i = pai;
+  }
+  coloca(self, i, id);
+}
+
+static void desce(fprio_t *self, int i)
+{
+  int id = self->heap[i];
+  for (;;) {
+    int filho = 2 * i + 1;
+    if (filho >= self->tamanho) break;
+    if (filho + 1 < self->tamanho && antes(self, self->heap[filho + 1], self->heap[filho])) {
+      filho++;
+    }
+    if (!antes(self, self->heap[filho], id)) break;
+    coloca(self, i, self->heap[filho]);
+    i = filho;
+  }
+  coloca(self, i, id);
+}
+
+void fprio_insere(fprio_t *self, int id, double chave)
+{
+  assert(id >= 0 && id < self->capacidade);
+  self->chave[id] = chave;
+  if (self->pos[id] >= 0) {
+    // já está na fila: a chave pode ter aumentado ou diminuído
+    sobe(self, self->pos[id]);
+    desce(self, self->pos[id]);
+    return;
+  }
+  coloca(self, self->tamanho, id);
+  self->tamanho++;
+  sobe(self, self->tamanho - 1);
+}
+
+void fprio_remove(fprio_t *self, int id)
+{
+  if (!fprio_contem(self, id)) return;
+  int i = self->pos[id];
+  self->pos[id] = -1;
+  self->tamanho--;
+  if (i == self->tamanho) return;
+  // o último ocupa o lugar do removido e é reposicionado
+  int movido = self->heap[self->tamanho];
+  coloca(self, i, movido);
+  sobe(self, i);
+  desce(self, self->pos[movido]);
+}
+
+int fprio_primeiro(fprio_t *self)
+{
+  if (self->tamanho == 0) return -1;
+  return self->heap[0];
+}
+
+int fprio_retira_primeiro(fprio_t *self)
+{
+  int id = fprio_primeiro(self);
+  fprio_remove(self, id);
+  return id;
+}
+
+double fprio_chave(fprio_t *self, int id)
+{
+  return self->chave[id];
+}
+
+bool fprio_salva(fprio_t *self, FILE *arq)
+{
+  size_t n = self->capacidade;
+  return fwrite(&self->capacidade, sizeof(self->capacidade), 1, arq) == 1
+         && fwrite(&self->tamanho, sizeof(self->tamanho), 1, arq) == 1
+         && fwrite(self->heap, sizeof(*self->heap), n, arq) == n
+         && fwrite(self->pos, sizeof(*self->pos), n, arq) == n
+         && fwrite(self->chave, sizeof(*self->chave), n, arq) == n;
+}
+
+fprio_t *fprio_restaura(FILE *arq)
+{
+  int capacidade, tamanho;
+  // um tamanho fora da capacidade faria a fila acessar além dos vetores
+  if (fread(&capacidade, sizeof(capacidade), 1, arq) != 1 || capacidade <= 0
+      || fread(&tamanho, sizeof(tamanho), 1, arq) != 1
+      || tamanho < 0 || tamanho > capacidade) {
+    return NULL;
+  }
+  fprio_t *self = fprio_cria(capacidade);
+  size_t n = capacidade;
+  self->tamanho = tamanho;
+  if (fread(self->heap, sizeof(*self->heap), n, arq) != n
+      || fread(self->pos, sizeof(*self->pos), n, arq) != n
+      || fread(self->chave, sizeof(*self->chave), n, arq) != n) {
+    fprio_destroi(self);
+    return NULL;
+  }
+  return self;
+}
@@ -0,0 +1,63 @@
+// fprio.h
+// fila de prioridade indexada (heap binário de mínimo)
+// simulador de computador
+// so25b
+
+#ifndef FPRIO_H
+#define FPRIO_H
+
+// guarda identificadores inteiros entre 0 e a capacidade-1 (no SO, índices na
+//   tabela de processos), cada um com uma chave; o de menor chave é o primeiro
+// empates são decididos pelo menor identificador, o que reproduz a escolha de
+//   uma varredura linear da tabela
+// cada identificador sabe sua posição no heap, por isso alterar a chave ou
+//   retirar um identificador qualquer é O(log n), sem busca
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// tipo opaco que representa a fila
+typedef struct fprio_t fprio_t;
+
+// cria uma fila vazia para identificadores entre 0 e capacidade-1
+// mata o programa em caso de erro (malloc)
+fprio_t *fprio_cria(int capacidade);
+
+// destrói uma fila
+void fprio_destroi(fprio_t *self);
+
+// aumenta a capacidade da fila para 'capacidade' (se for maior que a atual),
+//   mantendo os identificadores que estão nela
+// mata o programa em caso de erro (realloc)
+void fprio_aumenta(fprio_t *self, int capacidade);
+
+// número de identificadores na fila
+int fprio_tamanho(fprio_t *self);
+
+// retorna true se 'id' está na fila
+bool fprio_contem(fprio_t *self, int id);
+
+// insere 'id' com a chave 'chave'; se já estiver na fila, altera a chave
+void fprio_insere(fprio_t *self, int id, double chave);
+
+// retira 'id' da fila, se estiver nela
+void fprio_remove(fprio_t *self, int id);
+
+// retorna o identificador de menor chave, sem retirar, ou -1 se vazia
+int fprio_primeiro(fprio_t *self);
+
+// retira e retorna o identificador de menor chave, ou -1 se vazia
+int fprio_retira_primeiro(fprio_t *self);
+
+// retorna a chave de 'id' (que deve estar na fila)
+double fprio_chave(fprio_t *self, int id);
+
+// grava a fila em 'arq' (checkpoint da máquina)
+// retorna false em caso de erro de escrita
+bool fprio_salva(fprio_t *self, FILE *arq);
+
+// cria uma fila com o conteúdo gravado por fprio_salva
+// retorna NULL em caso de erro de leitura
+fprio_t *fprio_restaura(FILE *arq);
+
+#endif // FPRIO_H
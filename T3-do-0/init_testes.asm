@@ -0,0 +1,98 @@
+; processo inicial alternativo, para rodar os programas de teste
+; cria um processo para cada programa de teste, um de cada vez, e espera ele
+;   terminar antes de criar o próximo; depois se mata
+; só imprime algo se um deles não puder ser criado: cada caractere ocupa uma
+;   palavra, e o que init_testes ocupa da memória secundária falta para os
+;   testes (o que mais usa é teste_sbrk, com a área que ele pede)
+; para usar, troque CONFIG_PROGRAMA_INICIAL para "init_testes.maq" em config.h
+;
+
+; chamadas de sistema (ver so.h)
+SO_ESCR        define 2
+SO_CRIA_PROC   define 7
+SO_MATA_PROC   define 8
+SO_ESPERA_PROC define 9
+
+limpa    define 10
+
+         cargi t_fork
+         chama roda
+
+         cargi t_thread
+         chama roda
+
+         cargi t_arq
+         chama roda
+
+         cargi t_sbrk
+         chama roda
+
+         cargi t_rt
+         chama roda
+
+         cargi t_buf
+         chama roda
+
+         ; o último, porque espera 3 linhas digitadas no terminal dele
+         cargi t_linha
+         chama roda
+
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+msg_erro string 'erro ao criar '
+t_fork   string 'teste_fork.maq'
+t_thread string 'teste_thread.maq'
+t_arq    string 'teste_arq.maq'
+t_sbrk   string 'teste_sbrk.maq'
+t_rt     string 'teste_tempo_real.maq'
+t_buf    string 'teste_escr_buf.maq'
+t_linha  string 'teste_le_linha.maq'
+
+; cria um processo com o programa de nome em A e espera ele terminar
+roda     espaco 1
+         armm roda_nome
+         trax
+         cargi SO_CRIA_PROC
+         chamas
+         desvn roda_erro
+         trax
+         cargi SO_ESPERA_PROC
+         chamas
+         ret roda
+roda_erro
+         cargi msg_erro
+         chama impstr
+         cargm roda_nome
+         chama impstr
+         cargi limpa
+         chama impch
+         ret roda
+roda_nome espaco 1
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         TRAX
+impstr1
+         CARGX 0
+         DESVZ impstrf
+         CHAMA impch
+         INCX
+         DESV impstr1
+impstrf  RET impstr
+
+; função que chama o SO para imprimir o caractere em A
+; retorna em A o código de erro do SO
+; não altera o valor de X
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1 ; para salvar o valor de X
@@ -10,8 +10,8 @@ static char *nomes[N_IRQ] = {
   [IRQ_ERR_CPU] = "Erro de execução",
   [IRQ_SISTEMA] = "Chamada de sistema",
   [IRQ_RELOGIO] = "E/S: relógio",
-  [IRQ_TECLADO] = "E/S: teclado",
-  [IRQ_TELA]    = "E/S: console",
+  [IRQ_TERMINAL] = "E/S: terminal",
+  [IRQ_DISCO] =   "E/S: disco",
 };
 
 // retorna o nome da interrupção
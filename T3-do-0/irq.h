@@ -15,9 +15,9 @@ typedef enum {
   IRQ_SISTEMA,       // chamada de sistema
   // interrupções geradas por dispositivos de E/S
   IRQ_RELOGIO,       // interrupção causada pelo relógio
-  // interrupções de E/S ainda não implementadas
-  IRQ_TECLADO,       // interrupção causada pelo teclado
-  IRQ_TELA,          // interrupção causada pela tela
+  IRQ_TERMINAL,      // um terminal tem entrada ou ficou pronto para saída
+                     //   (quais, e em que sentido, em D_TERM_INTERRUPCAO)
+  IRQ_DISCO,         // o disco terminou uma operação
   N_IRQ              // número de interrupções
 } irq_t;
 
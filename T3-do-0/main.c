@@ -11,9 +11,11 @@
 #include "relogio.h"
 #include "console.h"
 #include "terminal.h"
+#include "disco.h"
 #include "es.h"
 #include "dispositivos.h"
 #include "so.h"
+#include "checkpoint.h"
 #include "config.h"
 
 #include <stdlib.h>
@@ -25,6 +27,7 @@ typedef struct {
   mmu_t *mmu;
   cpu_t *cpu;
   relogio_t *relogio;
+  disco_t *disco;
   console_t *console;
   es_t *es;
   controle_t *controle;
@@ -89,6 +92,11 @@ static void cria_hardware(hardware_t *hw)
   // cria dispositivos de E/S
   hw->console = console_cria();
   hw->relogio = relogio_cria();
+  hw->disco = disco_cria(CONFIG_ARQUIVO_DISCO, CONFIG_DISCO_BLOCOS, CONFIG_DISCO_LATENCIA);
+  if (hw->disco == NULL) {
+    fprintf(stderr, "Erro na abertura do disco ('%s')\n", CONFIG_ARQUIVO_DISCO);
+    exit(1);
+  }
 
   // cria o controlador de E/S e registra os dispositivos
   //   por exemplo, o dispositivo 8 do controlador de E/S (e da CPU) será o
@@ -104,13 +112,20 @@ static void cria_hardware(hardware_t *hw)
   es_registra_dispositivo(hw->es, D_RELOGIO_REAL      , hw->relogio, 1, relogio_leitura, NULL);
   es_registra_dispositivo(hw->es, D_RELOGIO_TIMER     , hw->relogio, 2, relogio_leitura, relogio_escrita);
   es_registra_dispositivo(hw->es, D_RELOGIO_INTERRUPCAO,hw->relogio, 3, relogio_leitura, relogio_escrita);
+  // registra o dispositivo com as interrupções pendentes dos terminais
+  es_registra_dispositivo(hw->es, D_TERM_INTERRUPCAO, hw->console, 0, console_leitura_interrupcao, console_escrita_interrupcao);
+  // registra os 4 dispositivos do disco
+  es_registra_dispositivo(hw->es, D_DISCO_BLOCO,       hw->disco, DISCO_BLOCO,       disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_DADO,        hw->disco, DISCO_DADO,        disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_COMANDO,     hw->disco, DISCO_COMANDO,     disco_leitura, disco_escrita);
+  es_registra_dispositivo(hw->es, D_DISCO_INTERRUPCAO, hw->disco, DISCO_INTERRUPCAO, disco_leitura, disco_escrita);
 
   // cria a unidade de execução e inicializa com a MMU e o controlador de E/S
   hw->cpu = cpu_cria(hw->mmu, hw->es);
 
-  // cria o controlador da CPU e inicializa com a unidade de execução, a console e
-  //   o relógio
-  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio);
+  // cria o controlador da CPU e inicializa com a unidade de execução, a console,
+  //   o relógio e o disco
+  hw->controle = controle_cria(hw->cpu, hw->console, hw->relogio, hw->disco);
 }
 
 static void destroi_hardware(hardware_t *hw)
@@ -118,6 +133,7 @@ static void destroi_hardware(hardware_t *hw)
   controle_destroi(hw->controle);
   cpu_destroi(hw->cpu);
   es_destroi(hw->es);
+  disco_destroi(hw->disco);
   relogio_destroi(hw->relogio);
   console_destroi(hw->console);
   mmu_destroi(hw->mmu);
@@ -128,16 +144,25 @@ int main()
 {
   hardware_t hw;
   so_t *so;
+  checkpoint_t *checkpoint;
 
   // cria o hardware
   cria_hardware(&hw);
   // cria o sistema operacional
   so = so_cria(hw.cpu, hw.mem, hw.mmu, hw.es, hw.console);
 
+  // o checkpoint grava e restaura a máquina inteira, hardware e SO
+  checkpoint = checkpoint_cria(hw.mem, hw.cpu, hw.relogio, hw.disco, hw.console, so);
+  controle_define_checkpoint(hw.controle, checkpoint);
+#ifdef CONFIG_CHECKPOINT_RESTAURA
+  checkpoint_restaura(checkpoint, CONFIG_ARQUIVO_CHECKPOINT);
+#endif
+
   // executa o laço principal do controlador
   controle_laco(hw.controle);
 
   // destroi tudo
+  checkpoint_destroi(checkpoint);
   so_destroi(so);
   destroi_hardware(&hw);
 }
@@ -0,0 +1,60 @@
+// maqbin.h
+// formato binário dos arquivos '.maq'
+// simulador de computador
+// so25b
+
+#ifndef MAQBIN_H
+#define MAQBIN_H
+
+// alternativa ao formato texto ("//MAQ tam carga" seguido de linhas
+//   "[end] = v, v, ..."), gerada pelo montador com a opção -b; o programa
+//   pode ser mapeado na memória e usado sem conversão nenhuma
+//
+// todos os números são inteiros de 32 bits little-endian; o arquivo é:
+//   cabeçalho, com MAQB_TAM_CABECALHO bytes:
+//     MAQB_POS_MAGICO      "MAQB"
+//     MAQB_POS_VERSAO      MAQB_VERSAO
+//     MAQB_POS_TAMANHO     número de palavras do programa
+//     MAQB_POS_CARGA       endereço de carga
+//     MAQB_POS_INICIO      endereço de início da execução
+//     MAQB_POS_NUM_SECOES  número de entradas na tabela de seções
+//   tabela de seções, logo após o cabeçalho, com MAQB_TAM_ENTRADA_SECAO bytes
+//     por entrada: tipo, deslocamento (em bytes, desde o início do arquivo,
+//     múltiplo de 4), tamanho (em bytes) e número de itens da seção
+//   as seções, nos deslocamentos indicados
+//
+// seções:
+//   MAQB_SECAO_CODIGO: obrigatória; uma palavra por posição do programa, a
+//     partir do endereço de carga
+//   MAQB_SECAO_SIMBOLOS: opcional; para cada símbolo, o valor, o tipo
+//     (MAQB_SIMBOLO_*), o número de bytes do nome (com o 0 final e
+//     completado até múltiplo de 4) e o nome
+//   MAQB_SECAO_RELOCACAO: opcional; endereços das palavras do programa que
+//     contêm endereços (referências a rótulos), que precisariam ser
+//     corrigidas se o programa fosse carregado em outro endereço
+
+#define MAQB_MAGICO "MAQB"
+#define MAQB_VERSAO 1
+
+#define MAQB_POS_MAGICO     0
+#define MAQB_POS_VERSAO     4
+#define MAQB_POS_TAMANHO    8
+#define MAQB_POS_CARGA      12
+#define MAQB_POS_INICIO     16
+#define MAQB_POS_NUM_SECOES 20
+#define MAQB_TAM_CABECALHO  24
+
+#define MAQB_TAM_ENTRADA_SECAO 16
+
+typedef enum {
+  MAQB_SECAO_CODIGO = 1,
+  MAQB_SECAO_SIMBOLOS = 2,
+  MAQB_SECAO_RELOCACAO = 3,
+} maqb_tipo_secao_t;
+
+typedef enum {
+  MAQB_SIMBOLO_CONSTANTE = 0,   // definido com DEFINE
+  MAQB_SIMBOLO_ROTULO = 1,      // endereço de uma posição do programa
+} maqb_tipo_simbolo_t;
+
+#endif // MAQBIN_H
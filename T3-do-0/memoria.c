@@ -72,3 +72,16 @@ err_t mem_escreve(mem_t *self, int endereco, int valor)
   }
   return err;
 }
+
+bool mem_salva(mem_t *self, FILE *arq)
+{
+  if (fwrite(&self->tam, sizeof(self->tam), 1, arq) != 1) return false;
+  return fwrite(self->conteudo, sizeof(*self->conteudo), self->tam, arq) == (size_t)self->tam;
+}
+
+bool mem_restaura(mem_t *self, FILE *arq)
+{
+  int tam;
+  if (fread(&tam, sizeof(tam), 1, arq) != 1 || tam != self->tam) return false;
+  return fread(self->conteudo, sizeof(*self->conteudo), self->tam, arq) == (size_t)self->tam;
+}
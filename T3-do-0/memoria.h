@@ -19,6 +19,9 @@
 
 #include "err.h"
 
+#include <stdbool.h>
+#include <stdio.h>
+
 // tipo opaco que representa a memória
 typedef struct mem_t mem_t;
 
@@ -42,4 +45,13 @@ err_t mem_le(mem_t *self, int endereco, int *pvalor);
 // retorna erro ERR_END_INV se endereço inválido
 err_t mem_escreve(mem_t *self, int endereco, int valor);
 
+// grava o tamanho e o conteúdo da memória em 'arq' (checkpoint da máquina)
+// retorna false em caso de erro de escrita
+bool mem_salva(mem_t *self, FILE *arq);
+
+// recupera de 'arq' o conteúdo gravado por mem_salva
+// retorna false em caso de erro de leitura ou se o tamanho gravado não é o
+//   tamanho desta memória
+bool mem_restaura(mem_t *self, FILE *arq);
+
 #endif // MEMORIA_H
@@ -80,6 +80,9 @@ err_t mmu_escreve(mmu_t *self, int endvirt, int valor, cpu_modo_t modo)
   }
   int endfis;
   err_t err = mmu__traduz(self, endvirt, &endfis);
+  if (err == ERR_OK && tabpag_pagina_protegida(self->tabpag, endvirt / TAM_PAGINA)) {
+    err = ERR_PAG_PROTEGIDA;
+  }
   if (err == ERR_OK) {
     err = mem_escreve(self->mem, endfis, valor);
     if (err == ERR_OK) {
@@ -56,7 +56,8 @@ err_t mmu_le(mmu_t *self, int endvirt, int *pvalor, cpu_modo_t modo);
 //   virtual 'endvirt'
 // marca a página como acessada e alterada se o acesso for bem sucedido
 // retorna erro se acesso não for possível, por um erro de tradução
-//   (ver tabpag_traduz) ou de memória (ver mem_escreve)
+//   (ver tabpag_traduz) ou de memória (ver mem_escreve), ou ERR_PAG_PROTEGIDA
+//   se a página estiver protegida contra escrita (ver tabpag_protege_pagina)
 // se o acesso for feito em modo supervisor, ou se a mmu não tiver tabela de
 //   página definida, trata 'endvirt' como endereço físico: repassa o acesso
 //   à memória sem tradução
@@ -8,6 +8,7 @@
 // ---------------------------------------------------------------------
 
 #include "instrucao.h"
+#include "maqbin.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -55,6 +56,7 @@ int mem_min = -1;       // menor endereço preenchido
 int mem_max = -1;       // maior endereço preenchido
 
 char *nome_fonte;   // nome do arquivo fonte a montar
+bool saida_binaria; // gera o formato binário (maqbin.h) em vez do texto
 
 // coloca um valor no final da memória
 void mem_insere(int val)
@@ -100,22 +102,31 @@ void mem_imprime(void)
 struct {
   char *nome;
   int valor;
+  bool rotulo;            // true para labels, false para DEFINE
 } simbolo[SIMB_TAM];
 int simb_num;             // número d símbolos na tabela
 
-// retorna o valor de um símbolo, ou -1 se não existir na tabela
-int simb_valor(char *nome)
+// retorna a posição de um símbolo na tabela, ou -1 se não existir
+int simb_busca(char *nome)
 {
   for (int i=0; i<simb_num; i++) {
     if (strcmp(nome, simbolo[i].nome) == 0) {
-      return simbolo[i].valor;
+      return i;
     }
   }
   return -1;
 }
 
+// retorna o valor de um símbolo, ou -1 se não existir na tabela
+int simb_valor(char *nome)
+{
+  int i = simb_busca(nome);
+  if (i == -1) return -1;
+  return simbolo[i].valor;
+}
+
 // insere um novo símbolo na tabela
-void simb_novo(char *nome, int valor)
+void simb_novo(char *nome, int valor, bool rotulo)
 {
   if (nome == NULL) return;
   if (simb_valor(nome) != -1) {
@@ -127,6 +138,7 @@ void simb_novo(char *nome, int valor)
   }
   simbolo[simb_num].nome = strdup(nome);
   simbolo[simb_num].valor = valor;
+  simbolo[simb_num].rotulo = rotulo;
   simb_num++;
 }
 
@@ -159,6 +171,14 @@ void ref_nova(char *nome, int linha, int endereco)
   ref_num++;
 }
 
+// true se a referência 'i' é a um label (a palavra referenciada contém um
+//   endereço, que deve ser relocado se o programa mudar de lugar)
+bool ref_eh_rotulo(int i)
+{
+  int s = simb_busca(ref[i].nome);
+  return s != -1 && simbolo[s].rotulo;
+}
+
 // resolve as referências -- para cada referência, coloca o valor do símbolo
 //   no endereço onde ele é referenciado
 void ref_resolve(void)
@@ -235,7 +255,7 @@ void monta_define(int linha, char *label, char *arg)
     fprintf(stderr, "ERRO: linha %d 'DEFINE' exige valor numérico\n", linha);
   } else {
     // tudo OK, define o símbolo
-    simb_novo(label, argn);
+    simb_novo(label, argn, false);
   }
 }
 
@@ -252,7 +272,7 @@ void monta_linha(int linha, char *label, char *instrucao, char *arg)
   
   // cria símbolo correspondente ao label, se for o caso
   if (label != NULL) {
-    simb_novo(label, mem_pos);
+    simb_novo(label, mem_pos, true);
   }
   
   // verifica a existência de instrução e número correto de argumentos
@@ -389,6 +409,88 @@ void monta_arquivo(char *nome)
 }
 
 
+
+// ---------------------------------------------------------------------
+// SAÍDA BINÁRIA {{{1
+// ---------------------------------------------------------------------
+
+// escreve um inteiro de 32 bits little-endian na saída
+void escreve_int32(int val)
+{
+  unsigned int u = val;
+  for (int i = 0; i < 4; i++) {
+    putchar((u >> (8 * i)) & 0xff);
+  }
+}
+
+// bytes ocupados pelo nome de um símbolo no formato binário: com o 0 final
+//   e completado até múltiplo de 4
+int tam_nome_binario(char *nome)
+{
+  return (strlen(nome) + 1 + 3) / 4 * 4;
+}
+
+// imprime o conteúdo da memória no formato binário (ver maqbin.h), com as
+//   seções de código, símbolos e relocação
+void mem_imprime_binario(void)
+{
+  int tam = mem_max - mem_min + 1;
+  int num_relocs = 0;
+  for (int i = 0; i < ref_num; i++) {
+    if (ref_eh_rotulo(i)) num_relocs++;
+  }
+  int tam_simbolos = 0;
+  for (int i = 0; i < simb_num; i++) {
+    tam_simbolos += 12 + tam_nome_binario(simbolo[i].nome);
+  }
+  int num_secoes = 3;
+  int desl_codigo = MAQB_TAM_CABECALHO + num_secoes * MAQB_TAM_ENTRADA_SECAO;
+  int desl_simbolos = desl_codigo + 4 * tam;
+  int desl_relocs = desl_simbolos + tam_simbolos;
+
+  // cabeçalho
+  fwrite(MAQB_MAGICO, 1, 4, stdout);
+  escreve_int32(MAQB_VERSAO);
+  escreve_int32(tam);
+  escreve_int32(mem_min);
+  escreve_int32(mem_min);
+  escreve_int32(num_secoes);
+
+  // tabela de seções
+  escreve_int32(MAQB_SECAO_CODIGO);
+  escreve_int32(desl_codigo);
+  escreve_int32(4 * tam);
+  escreve_int32(tam);
+  escreve_int32(MAQB_SECAO_SIMBOLOS);
+  escreve_int32(desl_simbolos);
+  escreve_int32(tam_simbolos);
+  escreve_int32(simb_num);
+  escreve_int32(MAQB_SECAO_RELOCACAO);
+  escreve_int32(desl_relocs);
+  escreve_int32(4 * num_relocs);
+  escreve_int32(num_relocs);
+
+  // seções
+  for (int i = mem_min; i <= mem_max; i++) {
+    escreve_int32(mem[i]);
+  }
+  for (int i = 0; i < simb_num; i++) {
+    int tam_nome = tam_nome_binario(simbolo[i].nome);
+    escreve_int32(simbolo[i].valor);
+    escreve_int32(simbolo[i].rotulo ? MAQB_SIMBOLO_ROTULO : MAQB_SIMBOLO_CONSTANTE);
+    escreve_int32(tam_nome);
+    int n = strlen(simbolo[i].nome);
+    fwrite(simbolo[i].nome, 1, n, stdout);
+    for (int j = n; j < tam_nome; j++) {
+      putchar('\0');
+    }
+  }
+  for (int i = 0; i < ref_num; i++) {
+    if (ref_eh_rotulo(i)) escreve_int32(ref[i].endereco);
+  }
+}
+
+
 // ---------------------------------------------------------------------
 // MAIN {{{1
 // ---------------------------------------------------------------------
@@ -408,12 +510,15 @@ void verifica_args(int argc, char *argv[argc])
         fprintf(stderr, "ERRO: endereço inválido: '%s'\n", argv[argi]);
         exit(1);
       }
+    } else if (strcmp(argv[argi], "-b") == 0) {
+      saida_binaria = true;
     } else {
       nome_fonte = argv[argi];
     }
   }
   if (nome_fonte == NULL) {
-    fprintf(stderr, "ERRO: chame como '%s [-e end.inicial] nome_do_arquivo'\n",
+    fprintf(stderr, "ERRO: chame como '%s [-b] [-e end.inicial] nome_do_arquivo'\n"
+                    "  -b gera o formato binário em vez do texto\n",
             argv[0]);
     exit(1);
   }
@@ -423,7 +528,11 @@ int main(int argc, char *argv[argc])
 {
   verifica_args(argc, argv);
   monta_arquivo(nome_fonte);
-  mem_imprime();
+  if (saida_binaria) {
+    mem_imprime_binario();
+  } else {
+    mem_imprime();
+  }
   return 0;
 }
 
@@ -4,14 +4,28 @@
 // so25b
 
 #include "programa.h"
+#include "maqbin.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 struct programa_t {
   int carga;
+  int inicio;
   int tamanho;
-  int *dados;
+  // os dados estão em 'dados_alocados' (formato texto) ou direto no arquivo
+  //   mapeado em 'mapa' (formato binário)
+  const int *dados;
+  int *dados_alocados;
+  void *mapa;
+  size_t tam_mapa;
 };
 
 // lê os dados do cabeçalho do arquivo (1ª linha)
@@ -22,13 +36,17 @@ static programa_t *pega_cabecalho(char *lin)
   if (sscanf(lin, "//MAQ %d %d", &tam, &carga) != 2) return NULL;
   programa_t *prog = malloc(sizeof(*prog));
   if (prog == NULL) return NULL;
-  prog->dados = calloc(sizeof(int), tam);
-  if (prog->dados == NULL) {
+  prog->dados_alocados = calloc(sizeof(int), tam);
+  if (prog->dados_alocados == NULL) {
     free(prog);
     return NULL;
   }
+  prog->dados = prog->dados_alocados;
+  prog->mapa = NULL;
+  prog->tam_mapa = 0;
   prog->tamanho = tam;
   prog->carga = carga;
+  prog->inicio = carga;
   return prog;
 }
 
@@ -44,15 +62,113 @@ static void pega_dados(programa_t *self, char *lin)
   while (ender >= 0 && ender < self->tamanho) {
     int dado, p;
     if (sscanf(lin+pos, "%d ,%n", &dado, &p) != 1) break;
-    self->dados[ender] = dado;
+    self->dados_alocados[ender] = dado;
     ender++;
     pos += p;
   }
 }
 
+// lê um inteiro de 32 bits little-endian
+static int32_t le_int32(const unsigned char *p)
+{
+  return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+}
+
+static bool hospedeiro_little_endian(void)
+{
+  uint32_t um = 1;
+  return *(unsigned char *)&um == 1;
+}
+
+// cria o programa de um arquivo no formato binário, mapeado em 'mapa' com
+//   'tam' bytes; o mapeamento passa a ser do programa (ou é desfeito, em erro)
+// num hospedeiro little-endian as palavras são usadas onde estão, sem cópia
+static programa_t *prog_cria_binario(unsigned char *mapa, size_t tam)
+{
+  int tam_prog = le_int32(mapa + MAQB_POS_TAMANHO);
+  int num_secoes = le_int32(mapa + MAQB_POS_NUM_SECOES);
+  bool ok = le_int32(mapa + MAQB_POS_VERSAO) == MAQB_VERSAO && tam_prog >= 0
+            && num_secoes >= 0
+            && num_secoes <= (tam - MAQB_TAM_CABECALHO) / MAQB_TAM_ENTRADA_SECAO;
+  const unsigned char *codigo = NULL;
+  for (int i = 0; ok && i < num_secoes; i++) {
+    const unsigned char *entrada = mapa + MAQB_TAM_CABECALHO + i * MAQB_TAM_ENTRADA_SECAO;
+    uint32_t desl = le_int32(entrada + 4);
+    uint32_t tam_secao = le_int32(entrada + 8);
+    if (desl % 4 != 0 || desl > tam || tam_secao > tam - desl) {
+      ok = false;
+    } else if (le_int32(entrada) == MAQB_SECAO_CODIGO) {
+      ok = tam_secao == 4 * (uint32_t)tam_prog;
+      codigo = mapa + desl;
+    }
+  }
+  programa_t *prog = NULL;
+  if (ok && codigo != NULL) {
+    prog = malloc(sizeof(*prog));
+  }
+  if (prog == NULL) {
+    munmap(mapa, tam);
+    return NULL;
+  }
+  prog->tamanho = tam_prog;
+  prog->carga = le_int32(mapa + MAQB_POS_CARGA);
+  prog->inicio = le_int32(mapa + MAQB_POS_INICIO);
+  prog->mapa = mapa;
+  prog->tam_mapa = tam;
+  prog->dados_alocados = NULL;
+  if (hospedeiro_little_endian()) {
+    prog->dados = (const int *)codigo;
+    return prog;
+  }
+  // outros hospedeiros: as palavras são convertidas para uma cópia
+  prog->dados_alocados = malloc(sizeof(int) * (tam_prog > 0 ? tam_prog : 1));
+  if (prog->dados_alocados == NULL) {
+    munmap(mapa, tam);
+    free(prog);
+    return NULL;
+  }
+  for (int i = 0; i < tam_prog; i++) {
+    prog->dados_alocados[i] = le_int32(codigo + 4 * i);
+  }
+  prog->dados = prog->dados_alocados;
+  munmap(mapa, tam);
+  prog->mapa = NULL;
+  prog->tam_mapa = 0;
+  return prog;
+}
+
+// se o arquivo está no formato binário, cria o programa a partir dele, e
+//   retorna true; retorna false se não é binário (*prog fica NULL)
+static bool tenta_binario(char *nome, programa_t **prog)
+{
+  *prog = NULL;
+  int fd = open(nome, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < MAQB_TAM_CABECALHO) {
+    close(fd);
+    return false;
+  }
+  size_t tam = st.st_size;
+  unsigned char *mapa = mmap(NULL, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapa == MAP_FAILED) return false;
+  if (memcmp(mapa + MAQB_POS_MAGICO, MAQB_MAGICO, 4) != 0) {
+    munmap(mapa, tam);
+    return false;
+  }
+  *prog = prog_cria_binario(mapa, tam);
+  return true;
+}
+
 programa_t *prog_cria(char *nome)
 {
   programa_t *prog = NULL;
+  if (tenta_binario(nome, &prog)) {
+    return prog;
+  }
+
+  // formato texto
   FILE *arq = fopen(nome, "r");
   if (arq == NULL) return NULL;
 
@@ -75,7 +191,10 @@ fim:
 
 void prog_destroi(programa_t *self)
 {
-  free(self->dados);
+  if (self->mapa != NULL) {
+    munmap(self->mapa, self->tam_mapa);
+  }
+  free(self->dados_alocados);
   free(self);
 }
 
@@ -91,7 +210,7 @@ int prog_end_carga(programa_t *self)
 
 int prog_end_inicio(programa_t *self)
 {
-  return self->carga;
+  return self->inicio;
 }
 
 int prog_dado(programa_t *self, int ender)
@@ -99,3 +218,8 @@ int prog_dado(programa_t *self, int ender)
   if (ender < self->carga || ender >= self->carga + self->tamanho) return -1;
   return self->dados[ender - self->carga];
 }
+
+const int *prog_dados(programa_t *self)
+{
+  return self->dados;
+}
@@ -7,6 +7,8 @@
 #define PROGRAMA_H
 
 // TAD para representar um programa lido de um arquivo '.maq'
+// o arquivo pode estar no formato texto ou no binário (maqbin.h), que é
+//   mapeado na memória em vez de convertido
 
 typedef struct programa_t programa_t;
 
@@ -31,4 +33,8 @@ int prog_end_inicio(programa_t *self);
 // valor a colocar na posição 'ender' da memória
 int prog_dado(programa_t *self, int ender);
 
+// valores de todas as posições do programa, a partir do endereço de carga
+//   (prog_tamanho valores), para copiar de uma vez
+const int *prog_dados(programa_t *self);
+
 #endif // PROGRAMA_H
@@ -26,6 +26,8 @@ relogio_t *relogio_cria(void)
   assert(self != NULL);
 
   self->agora = 0;
+  self->t_ate_interrupcao = 0;
+  self->interrupcao_ativa = false;
 
   return self;
 }
@@ -86,3 +88,13 @@ err_t relogio_escrita(void *disp, int id, int pvalor)
   }
   return err;
 }
+
+bool relogio_salva(relogio_t *self, FILE *arq)
+{
+  return fwrite(self, sizeof(*self), 1, arq) == 1;
+}
+
+bool relogio_restaura(relogio_t *self, FILE *arq)
+{
+  return fread(self, sizeof(*self), 1, arq) == 1;
+}
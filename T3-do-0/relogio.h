@@ -23,6 +23,9 @@
 
 #include "err.h"
 
+#include <stdbool.h>
+#include <stdio.h>
+
 typedef struct relogio_t relogio_t;
 
 // cria e inicializa um relógio
@@ -45,4 +48,9 @@ void relogio_tictac(relogio_t *self);
 err_t relogio_leitura(void *disp, int id, int *pvalor);
 err_t relogio_escrita(void *disp, int id, int pvalor);
 
+// grava em 'arq' o estado do relógio (checkpoint da máquina), e recupera o
+//   estado gravado; retornam false em caso de erro de escrita ou leitura
+bool relogio_salva(relogio_t *self, FILE *arq);
+bool relogio_restaura(relogio_t *self, FILE *arq);
+
 #endif // RELOGIO_H
@@ -0,0 +1,44 @@
+// sistarq.h
+// formato do sistema de arquivos no disco
+// simulador de computador
+// so25b
+
+#ifndef SISTARQ_H
+#define SISTARQ_H
+
+// o sistema de arquivos é simples: um diretório único, com um número fixo de
+//   entradas, e cada arquivo ocupa blocos contíguos, reservados quando ele é
+//   criado (não cresce além deles)
+// cada caractere de um arquivo texto ocupa uma palavra, como na memória
+//
+// bloco 0: superbloco
+// blocos 1 a FS_BLOCOS_DIR: o diretório, com FS_ENTRADAS_POR_BLOCO entradas
+//   de FS_TAM_ENTRADA palavras em cada bloco
+// blocos seguintes: os dados dos arquivos
+//
+// o formato é usado pelo SO e por cria_disco, que cria a imagem do disco
+//   com os arquivos do hospedeiro
+
+#include "disco.h"
+
+// palavras do superbloco
+#define FS_SB_MAGICO 0 // FS_MAGICO se o disco está formatado
+#define FS_SB_BLOCOS 1 // número de blocos do disco
+#define FS_MAGICO 0x53415131
+
+// o diretório
+#define FS_BLOCOS_DIR 4
+#define FS_TAM_ENTRADA 16
+#define FS_ENTRADAS_POR_BLOCO (DISCO_TAM_BLOCO / FS_TAM_ENTRADA)
+#define FS_NUM_ENTRADAS (FS_BLOCOS_DIR * FS_ENTRADAS_POR_BLOCO)
+#define FS_PRIMEIRO_BLOCO_DADOS (1 + FS_BLOCOS_DIR)
+
+// palavras de uma entrada do diretório; uma entrada com FS_ENT_INICIO 0 está
+//   livre
+#define FS_ENT_NOME    0  // FS_TAM_NOME caracteres, com 0 no fim se menor
+#define FS_ENT_INICIO  12 // primeiro bloco do arquivo
+#define FS_ENT_BLOCOS  13 // número de blocos reservados para o arquivo
+#define FS_ENT_TAMANHO 14 // tamanho do arquivo, em palavras
+#define FS_TAM_NOME    12
+
+#endif // SISTARQ_H
@@ -15,6 +15,10 @@
 #include "tabpag.h"
 #include "programa.h"
 #include "vmem.h"
+#include "fprio.h"
+#include "cacheprog.h"
+#include "disco.h"
+#include "sistarq.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -26,8 +30,19 @@
 
 // intervalo entre interrupções do relógio
 #define INTERVALO_INTERRUPCAO 50   // em instruções executadas
-// mascara usada na aproximacao de LRU por envelhecimento
-#define LRU_MSB_MASK (1UL << (sizeof(unsigned long) * 8 - 1))
+
+// filas de espera dos processos bloqueados
+#define N_TERMINAIS 4              // terminais A a D
+#define RODA_POSICOES 64           // posições da roda de temporização
+#define RODA_GRANULARIDADE 16      // instruções cobertas por cada posição
+
+// o mapa das filas do MLFQ (mlfq_mapa) tem um bit por nível
+#if CONFIG_MLFQ_NIVEIS < 1 || CONFIG_MLFQ_NIVEIS > 32
+#error "CONFIG_MLFQ_NIVEIS deve estar entre 1 e 32"
+#endif
+
+// tabela de processos
+#define PROCESSOS_POR_BLOCO 16     // descritores alocados de cada vez
 
 // Estrutura para métricas globais
 typedef struct {
@@ -37,13 +52,75 @@ typedef struct {
   int num_preempcoes_total;
   int num_irq[N_IRQ];
   long inicio_tempo_ocioso; // Para calcular o tempo ocioso
+  long num_ticks;           // Ticks do relógio contabilizados (com ou sem interrupção)
+  int num_trocas_contexto;  // Despachos de um processo diferente do anterior
+  long escr_buf_chamadas;   // Chamadas SO_ESCR_BUF completadas
+  long escr_buf_caracteres; // Caracteres escritos por elas
+  int escr_buf_bloqueios;   // Bloqueios por buffer de saída cheio
+  long le_buf_chamadas;     // Chamadas SO_LE_LINHA e SO_LE_BUF completadas
+  long le_buf_caracteres;   // Caracteres lidos por elas
+  int le_buf_bloqueios;     // Bloqueios esperando dados no buffer de entrada
+  long cache_acertos;       // Acessos a blocos do disco que estavam na cache
+  long cache_faltas;        //   e que não estavam
+  long cache_absorvidas;    // Alterações em blocos que já esperavam gravação
+  long disco_leituras;      // Operações do disco
+  long disco_gravacoes;
+  int disco_esperas;        // Bloqueios esperando o disco, e tempo total
+  long disco_tempo_espera;  //   bloqueado
 } metricas_globais_t;
 
 typedef struct {
   long falhas_pagina_total;
   long transferencias_paginas;
+  long paginas_zeradas;     // faltas atendidas com quadro zerado, sem leitura da secundária
+  long trocas_espaco;       // despachos que trocaram a tabela de páginas da MMU
+  long processos_fork;      // processos criados com SO_FORK
+  long faltas_protecao;     // escritas em páginas protegidas (cópia na escrita)
+  long copias_escrita;      // páginas copiadas para outro quadro numa dessas escritas
 } metricas_vm_t;
 
+// fila circular de índices na tabela de processos; a capacidade acompanha a
+//   da tabela, então a fila nunca enche (cada processo está nela no máximo
+//   uma vez)
+typedef struct {
+  int *itens;
+  int capacidade;
+  int inicio;
+  int tamanho;
+} fila_proc_t;
+
+// fila circular de caracteres de um terminal, mantida pelo SO
+typedef struct {
+  int itens[CONFIG_TAM_BUF_TERMINAL];
+  int inicio;
+  int tamanho;
+} buf_term_t;
+
+// entrada da cache de blocos do disco
+typedef enum {
+  CACHE_LIVRE,              // sem bloco
+  CACHE_PEDIDO,             // esperando o disco para ser lida
+  CACHE_LENDO,              // sendo lida pelo disco
+  CACHE_VALIDO              // com o conteúdo do bloco
+} estado_cache_t;
+
+typedef struct {
+  int bloco;
+  estado_cache_t estado;
+  bool sujo;                // alterado desde a última gravação
+  int sujo_desde;           // instante da primeira alteração ainda não gravada
+  unsigned long uso;        // carimbo do último acesso (LRU), ou do pedido de leitura
+  int dados[DISCO_TAM_BLOCO];
+} cache_bloco_t;
+
+// lista duplamente encadeada de processos bloqueados; os elos ficam no
+//   descritor (espera_ant/espera_prox), e um processo bloqueado está em no
+//   máximo uma lista, escolhida pelo motivo do bloqueio
+typedef struct {
+  int primeiro;
+  int ultimo;
+} lista_espera_t;
+
 struct so_t {
   cpu_t *cpu;
   mem_t *mem;
@@ -53,9 +130,60 @@ struct so_t {
   bool erro_interno;
 
   vm_estado_t *vm_estado;
-
-  // Estado dos processos
-  processo_t tabela_processos[MAX_PROCESSOS];
+  // envelhecimento preguiçoso das páginas: conta os ticks do relógio; cada
+  //   processo guarda até que tick suas idades estão em dia, e os
+  //   deslocamentos atrasados são aplicados de uma vez quando ele é despachado
+  //   ou quando é preciso escolher uma vítima
+  unsigned long tick_relogio;
+  // instante (em instruções) em que termina o tick do relógio em andamento
+  int proximo_tick;
+  int *vm_quadros_proc;             // área de trabalho para colher os acessos
+  unsigned char *vm_acessos_proc;   //   de um processo, com um item por quadro
+
+  // Tabela de processos: os descritores ficam em blocos de
+  //   PROCESSOS_POR_BLOCO, criados quando não há descritor livre e nunca
+  //   movidos, para que ponteiros para eles continuem valendo quando a tabela
+  //   cresce; o índice de um descritor é bloco * PROCESSOS_POR_BLOCO + posição
+  processo_t **blocos_processos;
+  int capacidade_processos;     // Descritores existentes, em todos os blocos
+  int processos_usados;         // Descritores já usados alguma vez (são os primeiros)
+  int livres_primeiro;          // Pilha dos descritores livres, encadeada em vivo_prox
+  int vivos_primeiro;           // Lista dos descritores em uso, na ordem de criação,
+  int vivos_ultimo;             //   encadeada em vivo_ant/vivo_prox
+  // Índice pid -> descritor: espalhamento por pid % capacidade_processos, com
+  //   as colisões encadeadas em pid_prox
+  int *pid_baldes;
+
+  // Filas de espera dos bloqueados, para que um desbloqueio custe só o
+  //   processo desbloqueado: uma por terminal e sentido (o bit 2*t+sentido de
+  //   espera_term_mapa está ligado se a fila não está vazia), uma por pid
+  //   esperado (por espalhamento) e uma roda de temporização com os prazos
+  //   das transferências de página
+  lista_espera_t espera_term[N_TERMINAIS][2];
+  unsigned int espera_term_mapa;
+  lista_espera_t *espera_pid;   // capacidade_processos listas, como pid_baldes
+  lista_espera_t roda[RODA_POSICOES];
+  // Saída dos terminais com SO_ESCR_BUF: caracteres aceitos e ainda não
+  //   enviados, escoados enquanto o terminal aceitar na chamada que os coloca
+  //   e a cada interrupção de tela
+  buf_term_t saida_term[N_TERMINAIS];
+  // Entrada dos terminais: caracteres já lidos do teclado e ainda não
+  //   entregues a um processo, e quantos deles são '\n'; o teclado é
+  //   esvaziado nas chamadas de leitura e nas interrupções de teclado com
+  //   processos esperando
+  buf_term_t entrada_term[N_TERMINAIS];
+  int entrada_linhas[N_TERMINAIS];
+  // Cache de blocos do disco, com substituição LRU e gravação adiada dos
+  //   blocos alterados; o disco faz uma operação (disco_op, 0 se está livre)
+  //   por vez, sobre a entrada disco_entrada; os processos esperando o disco
+  //   estão em espera_disco
+  cache_bloco_t cache_disco[CONFIG_CACHE_BLOCOS];
+  unsigned long cache_relogio;  // Carimbo do último acesso
+  int disco_op;
+  int disco_entrada;
+  lista_espera_t espera_disco;
+  int roda_num;                 // Quantos processos estão na roda
+  int roda_tempo;               // Instante até o qual a roda já foi processada
   int processo_em_execucao_idx; // Índice na tabela_processos, ou -1 se nenhum
   int proximo_pid;              // Próximo PID a ser alocado
 
@@ -67,27 +195,67 @@ struct so_t {
   // --- Campos de Escalonamento e Métricas (Parte III) ---
 
   // Fila de prontos para Round-Robin
-  int fila_prontos[MAX_PROCESSOS];
-  int fila_prontos_inicio;
-  int fila_prontos_fim;
-  int fila_prontos_tamanho;
+  fila_proc_t fila_prontos;
 
   // Controle do Quantum
   int quantum_total;        // Nº de interrupções de relógio por quantum
+  int quantum_concedido;    // Quantum dado ao processo atual
   int quantum_restante;     // Quantum restante do processo atual
   bool deve_preemptar;      // Flag setada pela IRQ do relógio
 
   // Seleção do Escalonador
   tipo_escalonador_t escalonador_atual;
 
+  // totais sobre os processos prontos, mantidos a cada mudança de estado
+  //   (so_prontos_contabiliza), para que o escalonador não precise percorrer
+  //   os processos vivos: quantos estão em PRONTO, a soma dos pesos do CFS
+  //   dos que estão em PRONTO ou EXECUTANDO, e o total de bilhetes da loteria
+  //   dos prontos fora da classe de tempo real
+  int num_prontos;
+  long cfs_soma_pesos;
+  long loteria_bilhetes;
+
+  // Prontos dos escalonadores de prioridade e CFS, num heap indexado pelo
+  //   índice na tabela de processos; a chave é a prioridade ou o vruntime
+  fprio_t *prontos_prio;
+
+  // Prontos da classe de tempo real (EDF), pela data limite do trabalho, e
+  //   início do trecho de execução ainda não descontado do orçamento
+  fprio_t *prontos_rt;
+  int edf_inicio_contabilizacao;
+
+  // CFS: menor vruntime já visto (só cresce), onde entram os processos novos,
+  //   e início do trecho de execução ainda não contabilizado
+  unsigned long cfs_min_vruntime;
+  int cfs_inicio_contabilizacao;
+
+  // stride: menor passo já visto (só cresce), como cfs_min_vruntime
+  unsigned long stride_passo_minimo;
+  // loteria: estado do gerador de números pseudo-aleatórios
+  unsigned int loteria_semente;
+
+  // Filas do escalonador MLFQ, uma por nível; o bit n de mlfq_mapa está
+  //   ligado se a fila do nível n não está vazia
+  fila_proc_t mlfq_filas[CONFIG_MLFQ_NIVEIS];
+  unsigned int mlfq_mapa;
+  int mlfq_ticks_desde_elevacao;
+
   // Métricas
   metricas_globais_t metricas;
 
   // Controle para evitar spam quando a CPU permanece em HALT
   bool cpu_em_halt;
 
+  // Último processo despachado, para contar as trocas de contexto
+  int ultimo_despachado_idx;
+  // Tabela de páginas em uso pela MMU
+  tabpag_t *tabpag_na_mmu;
+
   // Controle simplificado do tempo de liberacao da memoria secundaria
   int tempo_disponivel_memsec;
+
+  // Programas já lidos, para a criação de processos
+  cacheprog_t *cache_programas;
 };
 
 
@@ -96,10 +264,21 @@ static int so_trata_interrupcao(void *argC, int reg_A);
 
 // funções auxiliares
 static void so_mmu_define_tabpag(so_t *self, tabpag_t *tabpag);
+// tabela de processos
+static processo_t *so_proc(so_t *self, int idx);
+static bool so_proc_aumenta_tabela(so_t *self);
+static int so_proc_aloca(so_t *self);
+static void so_proc_ativa(so_t *self, processo_t *proc, int pid);
+static void so_proc_desativa(so_t *self, processo_t *proc);
 // carrega o programa contido no arquivo na memória do processador; retorna end. inicial
 static int so_carrega_programa(so_t *self, char *nome_do_executavel, processo_t *destino);
 // copia para str da memória do processador, até copiar um 0 (retorna true) ou tam bytes
 static bool copia_str_da_mem(so_t *self, processo_t *proc, int tam, char str[tam], int ender, bool *bloqueou);
+// lê uma palavra da memória do processo; como copia_str_da_mem, atende falta
+//   de página (e retorna false com *bloqueou true)
+static bool so_le_palavra_da_mem(so_t *self, processo_t *proc, int ender, int *valor, bool *bloqueou);
+static bool so_escreve_palavra_na_mem(so_t *self, processo_t *proc, int ender, int valor, bool *bloqueou);
+static void so_trata_erro_acesso_usuario(so_t *self, processo_t *proc, int ender, err_t err, bool *bloqueou);
 // retorna o tempo atual do sistema (número de instruções)
 static int so_get_tempo(so_t *self);
 // inicializa os campos de métricas de um novo processo
@@ -107,13 +286,36 @@ static void so_inicializa_metricas_processo(so_t *self, processo_t *proc, int pi
 // funções da fila de prontos (Round-Robin)
 static void fila_prontos_insere(so_t *self, int idx_proc);
 static int fila_prontos_remove(so_t *self);
+static void fila_proc_retira(fila_proc_t *fila, int idx_proc);
 static void so_insere_em_pronto(so_t *self, int idx_proc);
+static void so_insere_novo_em_pronto(so_t *self, int idx_proc);
+static void so_remove_de_pronto(so_t *self, int idx_proc);
+static void so_prontos_contabiliza(so_t *self, processo_t *proc, estado_processo_t estado, int sinal);
 // atualiza o estado de um processo e registra métricas
 static void so_atualiza_estado(so_t *self, processo_t *proc, estado_processo_t novo_estado);
 static void so_registra_preempcao(so_t *self, processo_t *proc);
-static void so_tenta_desbloquear_processo(so_t *self, int idx_proc);
+static lista_espera_t *so_espera_lista(so_t *self, processo_t *proc);
+static void so_espera_insere(so_t *self, processo_t *proc);
+static void so_espera_retira(so_t *self, processo_t *proc);
+static void so_espera_atende_terminais(so_t *self, unsigned int mapa);
+static void so_roda_avanca(so_t *self, int agora);
+#ifdef CONFIG_RELOGIO_SEM_TICK
+static int so_roda_proximo_prazo(so_t *self);
+#endif
 static void so_tenta_desbloquear_leitura(so_t *self, processo_t *proc, int idx_proc);
 static void so_tenta_desbloquear_escrita(so_t *self, processo_t *proc, int idx_proc);
+static int so_terminal_indice(int term);
+static bool so_saida_insere(so_t *self, int t, int dado);
+static void so_saida_escoa(so_t *self, int t);
+static void so_entrada_enche(so_t *self, int t);
+static int so_entrada_retira(so_t *self, int t);
+static bool so_entrada_pronta(so_t *self, int t, bool linha);
+static bool so_bloqueado_por_es(processo_t *proc);
+static void so_disco_inicia(so_t *self);
+#ifdef CONFIG_RELOGIO_SEM_TICK
+static int so_disco_proxima_gravacao(so_t *self);
+#endif
+static void so_arq_fecha(so_t *self, processo_t *proc, int fd);
 static void so_registra_saida_ociosidade(so_t *self);
 static void so_registra_entrada_ociosidade(so_t *self);
 static processo_t *so_rr_trata_preempcao(so_t *self, processo_t *proc_atual);
@@ -122,11 +324,49 @@ static void so_rr_escolhe_novo_processo(so_t *self);
 static processo_t *so_prio_trata_processo_atual(so_t *self, processo_t *proc_atual);
 static void so_prio_escolhe_melhor(so_t *self);
 static int so_prio_encontra_melhor(so_t *self);
-static int so_proc_encontra_slot_livre(so_t *self);
-static bool so_proc_le_nome_programa(so_t *self, processo_t *criador, char nome[], int tam, bool *bloqueou);
+static int so_mlfq_quantum(int nivel);
+static void so_mlfq_insere(so_t *self, int idx_proc);
+static int so_mlfq_remove(so_t *self);
+static void so_mlfq_retira(so_t *self, int idx_proc);
+static void so_mlfq_eleva_todos(so_t *self);
+static void so_mlfq_fim_de_quantum(so_t *self, processo_t *proc);
+static processo_t *so_mlfq_trata_processo_atual(so_t *self, processo_t *proc_atual);
+static void so_mlfq_escolhe_novo_processo(so_t *self);
+static bool so_usa_heap_prontos(so_t *self);
+static double so_chave_pronto(so_t *self, processo_t *proc);
+static int so_mem_taxa_faltas(processo_t *proc);
+#ifdef CONFIG_ESCALONAMENTO_MEMORIA
+static double so_mem_penalidade(so_t *self, processo_t *proc);
+#endif
+static int so_cfs_peso(processo_t *proc);
+static void so_cfs_contabiliza(so_t *self, processo_t *proc);
+static void so_cfs_atualiza_min_vruntime(so_t *self, processo_t *proc_atual);
+static void so_cfs_posiciona_acordado(so_t *self, processo_t *proc);
+static int so_cfs_fatia(so_t *self, processo_t *proc);
+static processo_t *so_cfs_trata_processo_atual(so_t *self, processo_t *proc_atual);
+static void so_cfs_escolhe_novo_processo(so_t *self);
+static unsigned long so_stride_tamanho_passo(processo_t *proc);
+static void so_stride_contabiliza(so_t *self, processo_t *proc);
+static void so_stride_atualiza_passo_minimo(so_t *self, processo_t *proc_atual);
+static void so_stride_posiciona_acordado(so_t *self, processo_t *proc);
+static processo_t *so_prop_trata_processo_atual(so_t *self, processo_t *proc_atual);
+static void so_prop_executa(so_t *self, int idx, const char *politica);
+static int so_loteria_sorteia(so_t *self);
+static bool so_edf_trata_processo_atual(so_t *self);
+static bool so_edf_escolhe(so_t *self);
+static void so_edf_devolve_atual(so_t *self);
+static void so_edf_contabiliza(so_t *self, processo_t *proc);
+static void so_edf_inicia_periodo(processo_t *proc, int inicio);
+static void so_edf_proximo_periodo(processo_t *proc);
+static void so_edf_espera_periodo(so_t *self, processo_t *proc);
+static bool so_edf_admite(so_t *self, processo_t *proc, int orcamento, int prazo);
+static void so_edf_registra_fim_trabalho(processo_t *proc, int agora);
+static bool so_espera_na_roda(processo_t *proc);
+static bool so_proc_le_nome_programa(so_t *self, processo_t *criador, int ender, char nome[], int tam, bool *bloqueou);
 static void so_proc_configura_novo(so_t *self, processo_t *novo_proc, int ender_carga, int idx_tabela, int pid);
 static void so_proc_inicializa_vm(so_t *self, processo_t *proc);
 static void so_proc_liberacao_recursos(so_t *self, processo_t *proc);
+static void so_proc_libera_heap(so_t *self, processo_t *proc);
 static int so_proc_busca_idx(so_t *self, int pid);
 static bool so_proc_desbloqueia_esperando(so_t *self, processo_t *proc_alvo);
 static void so_relatorio_atualiza_ociosidade_final(so_t *self, int tempo_final);
@@ -134,13 +374,27 @@ static void so_relatorio_imprime_globais(so_t *self, int tempo_final);
 static void so_relatorio_imprime_irq(so_t *self);
 static void so_relatorio_imprime_processos(so_t *self, int tempo_final);
 static void so_relatorio_imprime_processo(so_t *self, processo_t *proc, int tempo_final, const char *estado_nome[]);
+static int so_relatorio_tempo_executando(processo_t *proc, int tempo_final);
+static void so_relatorio_imprime_parte_cpu(so_t *self, processo_t *proc, int tempo_final);
 static bool so_endereco_valido_para_processo(processo_t *proc, int endereco);
+static processo_t *so_vm_espaco(so_t *self, processo_t *proc);
+static void so_thread_termina_todas(so_t *self, processo_t *lider);
 static bool so_atende_falta_pagina(so_t *self, processo_t *proc);
+static bool so_atende_protecao_pagina(so_t *self, processo_t *proc);
+static void so_vm_bloqueia_transferencia(so_t *self, processo_t *proc, int tempo_atual, int transferencias);
+static int so_vm_mapeador(so_t *self, int i, int pagina_virtual, int indice_quadro);
+static void so_vm_solta_quadros(so_t *self, processo_t *proc);
+static bool so_vm_separa_slots_imagem(processo_t *proc);
+static void so_vm_libera_slots_imagem(so_t *self, processo_t *proc);
 static bool so_vm_salva_quadro(so_t *self, int indice_quadro, int *transferencias);
-static bool so_vm_carrega_pagina(so_t *self, processo_t *proc, int pagina_virtual, int indice_quadro, int tempo_carimbo);
+static bool so_vm_carrega_pagina(so_t *self, processo_t *proc, int pagina_virtual, int indice_quadro, int tempo_carimbo, int *transferencias);
+static int so_vm_slot_da_pagina(processo_t *proc, int pagina_virtual);
 static int so_vm_escolhe_quadro_para_carregar(so_t *self);
 static int so_vm_agenda_transferencia(so_t *self, int tempo_atual, int transferencias);
-static void so_vm_atualiza_idade_quadros(so_t *self);
+static void so_vm_envelhece_processo(so_t *self, processo_t *proc, bool executou);
+static void so_vm_envelhece_todos(so_t *self);
+static void so_vm_atualiza_idade_quadros(so_t *self, int ticks);
+static void so_vm_configura_mem_sec(so_t *self, int tam_sec);
 
 
 // ---------------------------------------------------------------------
@@ -164,6 +418,7 @@ static void so_mmu_define_tabpag(so_t *self, tabpag_t *tabpag)
     return;
   }
   mmu_define_tabpag(self->mmu, tabpag);
+  self->tabpag_na_mmu = tabpag;
 }
 
 
@@ -183,35 +438,89 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu, es_t *es, console_t *console)
   self->console = console;
   self->erro_interno = false;
   self->vm_estado = NULL;
+  self->tick_relogio = 0;
+  self->proximo_tick = INTERVALO_INTERRUPCAO;
+  self->vm_quadros_proc = NULL;
+  self->vm_acessos_proc = NULL;
   self->algoritmo_substituicao = CONFIG_ALGORITMO_SUBSTITUICAO;
   self->tempo_transferencia_pagina = CONFIG_TEMPO_TRANSFERENCIA_PAGINA;
   self->metricas_vm.falhas_pagina_total = 0;
   self->metricas_vm.transferencias_paginas = 0;
+  self->metricas_vm.paginas_zeradas = 0;
+  self->metricas_vm.trocas_espaco = 0;
+  self->metricas_vm.processos_fork = 0;
+  self->metricas_vm.faltas_protecao = 0;
+  self->metricas_vm.copias_escrita = 0;
   self->tempo_disponivel_memsec = 0;
+  self->cache_programas = cacheprog_cria(CONFIG_CACHE_PROGRAMAS);
+  if (self->cache_programas == NULL) {
+    self->erro_interno = true;
+  }
 
   // Inicializa controle de processos
   self->processo_em_execucao_idx = -1;
   self->proximo_pid = 1;
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    self->tabela_processos[i].estado = LIVRE;
-    self->tabela_processos[i].tabela_paginas = NULL;
-    self->tabela_processos[i].falhas_pagina = 0;
-    self->tabela_processos[i].indices_pagsec = NULL;
-    self->tabela_processos[i].num_paginas_secundarias = 0;
-    self->tabela_processos[i].tamanho_programa = 0;
-    self->tabela_processos[i].end_virtual_base = 0;
-    self->tabela_processos[i].tempo_desbloqueio = 0;
+  self->blocos_processos = NULL;
+  self->capacidade_processos = 0;
+  self->processos_usados = 0;
+  self->livres_primeiro = -1;
+  self->vivos_primeiro = -1;
+  self->vivos_ultimo = -1;
+  self->pid_baldes = NULL;
+  self->espera_pid = NULL;
+
+  // Inicializa as filas de espera
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    for (int sentido = 0; sentido < 2; sentido++) {
+      self->espera_term[t][sentido] = (lista_espera_t){ -1, -1 };
+    }
+  }
+  self->espera_term_mapa = 0;
+  for (int p = 0; p < RODA_POSICOES; p++) {
+    self->roda[p] = (lista_espera_t){ -1, -1 };
+  }
+  self->roda_num = 0;
+  self->roda_tempo = 0;
+  for (int t = 0; t < N_TERMINAIS; t++) {
+    self->saida_term[t].inicio = 0;
+    self->saida_term[t].tamanho = 0;
+    self->entrada_term[t].inicio = 0;
+    self->entrada_term[t].tamanho = 0;
+    self->entrada_linhas[t] = 0;
+  }
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    self->cache_disco[e].estado = CACHE_LIVRE;
   }
+  self->cache_relogio = 0;
+  self->disco_op = 0;
+  self->disco_entrada = -1;
+  self->espera_disco = (lista_espera_t){ -1, -1 };
 
   // Inicializa fila de prontos (RR)
-  self->fila_prontos_inicio = 0;
-  self->fila_prontos_fim = 0;
-  self->fila_prontos_tamanho = 0;
+  self->fila_prontos = (fila_proc_t){ NULL, 0, 0, 0 };
 
   // Inicializa escalonador (Padrão: RR com Quantum 3)
-  self->escalonador_atual = ESCAL_PRIORIDADE; // Mude para ESCAL_PRIORIDADE para testar o outro
+  self->escalonador_atual = CONFIG_ESCALONADOR; // escolhido em config.h
+  self->num_prontos = 0;
+  self->cfs_soma_pesos = 0;
+  self->loteria_bilhetes = 0;
+  self->prontos_prio = fprio_cria(PROCESSOS_POR_BLOCO);
+  self->prontos_rt = fprio_cria(PROCESSOS_POR_BLOCO);
+  self->edf_inicio_contabilizacao = 0;
+  self->cfs_min_vruntime = 0;
+  self->cfs_inicio_contabilizacao = 0;
+  self->stride_passo_minimo = 0;
+  self->loteria_semente = CONFIG_LOTERIA_SEMENTE;
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    self->mlfq_filas[n] = (fila_proc_t){ NULL, 0, 0, 0 };
+  }
+  self->mlfq_mapa = 0;
+  self->mlfq_ticks_desde_elevacao = 0;
   self->quantum_total = 3; // Quantum = 3 interrupções de relógio
+  self->quantum_concedido = self->quantum_total;
   self->quantum_restante = 0;
+  self->ultimo_despachado_idx = -1;
+  self->tabpag_na_mmu = NULL;
   self->deve_preemptar = false;
 
   // Inicializa métricas
@@ -220,12 +529,32 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu, es_t *es, console_t *console)
   self->metricas.num_processos_criados = 0;
   self->metricas.num_preempcoes_total = 0;
   self->metricas.inicio_tempo_ocioso = 0;
+  self->metricas.num_ticks = 0;
+  self->metricas.num_trocas_contexto = 0;
+  self->metricas.escr_buf_chamadas = 0;
+  self->metricas.escr_buf_caracteres = 0;
+  self->metricas.escr_buf_bloqueios = 0;
+  self->metricas.le_buf_chamadas = 0;
+  self->metricas.le_buf_caracteres = 0;
+  self->metricas.le_buf_bloqueios = 0;
+  self->metricas.cache_acertos = 0;
+  self->metricas.cache_faltas = 0;
+  self->metricas.cache_absorvidas = 0;
+  self->metricas.disco_leituras = 0;
+  self->metricas.disco_gravacoes = 0;
+  self->metricas.disco_esperas = 0;
+  self->metricas.disco_tempo_espera = 0;
   for (int i = 0; i < N_IRQ; i++) {
     self->metricas.num_irq[i] = 0;
   }
 
   self->cpu_em_halt = false;
 
+  // cria o primeiro bloco da tabela de processos (e as filas do seu tamanho)
+  if (!so_proc_aumenta_tabela(self)) {
+    self->erro_interno = true;
+  }
+
   int tam_mem = mem_tam(self->mem);
   int num_quadros = tam_mem / TAM_PAGINA;
   if (num_quadros <= 0) {
@@ -234,9 +563,15 @@ so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu, es_t *es, console_t *console)
   } else {
     int num_paginas_sec = num_quadros * CONFIG_FATOR_MEM_SECUNDARIA;
     self->vm_estado = vm_estado_cria(num_quadros, num_paginas_sec);
+    self->vm_quadros_proc = malloc(num_quadros * sizeof(*self->vm_quadros_proc));
+    self->vm_acessos_proc = malloc(num_quadros * sizeof(*self->vm_acessos_proc));
+    if (self->vm_quadros_proc == NULL || self->vm_acessos_proc == NULL) {
+      console_printf("SO: sem memória para o envelhecimento de páginas");
+      self->erro_interno = true;
+    }
     if (self->vm_estado != NULL) {
       int tam_sec = num_paginas_sec * TAM_PAGINA;
-      vm_estado_configura_mem_sec(self->vm_estado, tam_sec);
+      so_vm_configura_mem_sec(self, tam_sec);
       int quadros_reservados = (CPU_END_FIM_PROT + 1 + TAM_PAGINA - 1) / TAM_PAGINA;
       int total_quadros = vm_estado_num_quadros(self->vm_estado);
       if (quadros_reservados > total_quadros) {
@@ -262,22 +597,263 @@ void so_destroi(so_t *self)
 {
   so_mmu_define_tabpag(self, NULL);
   if (self->vm_estado != NULL) {
-    for (int i = 0; i < MAX_PROCESSOS; i++) {
-      so_proc_liberacao_recursos(self, &self->tabela_processos[i]);
+    for (int i = 0; i < self->processos_usados; i++) {
+      so_proc_liberacao_recursos(self, so_proc(self, i));
     }
   }
   vm_estado_destroi(self->vm_estado);
+  free(self->vm_quadros_proc);
+  free(self->vm_acessos_proc);
+  fprio_destroi(self->prontos_prio);
+  fprio_destroi(self->prontos_rt);
+  free(self->fila_prontos.itens);
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    free(self->mlfq_filas[n].itens);
+  }
+  for (int b = 0; b < self->capacidade_processos / PROCESSOS_POR_BLOCO; b++) {
+    free(self->blocos_processos[b]);
+  }
+  free(self->blocos_processos);
+  free(self->pid_baldes);
+  free(self->espera_pid);
+  cacheprog_destroi(self->cache_programas);
   cpu_define_chamaC(self->cpu, NULL, NULL);
   free(self);
 }
 
 
+// ---------------------------------------------------------------------
+// TABELA DE PROCESSOS {{{1
+// ---------------------------------------------------------------------
+
+// descritor de índice 'idx' (entre 0 e capacidade_processos-1)
+static processo_t *so_proc(so_t *self, int idx)
+{
+  return &self->blocos_processos[idx / PROCESSOS_POR_BLOCO][idx % PROCESSOS_POR_BLOCO];
+}
+
+// estado de um descritor recém-criado, livre
+static void so_proc_inicializa_descritor(processo_t *proc, int idx)
+{
+  proc->idx = idx;
+  proc->pid = 0;
+  proc->estado = LIVRE;
+  proc->tabela_paginas = NULL;
+  proc->falhas_pagina = 0;
+  proc->base_pagsec = -1;
+  proc->num_paginas_secundarias = 0;
+  proc->tamanho_programa = 0;
+  proc->programa = NULL;
+  proc->end_virtual_base = 0;
+  proc->fim_heap = 0;
+  proc->slots_imagem = NULL;
+  proc->slots_heap = NULL;
+  proc->num_paginas_heap = 0;
+  proc->tempo_desbloqueio = 0;
+  proc->es_buf_feitos = 0;
+  for (int fd = 0; fd < CONFIG_ARQUIVOS_POR_PROCESSO; fd++) {
+    proc->arquivos[fd].entrada = -1;
+  }
+  proc->arq_entrada = -1;
+  proc->arq_saida = -1;
+  proc->espera_ant = -1;
+  proc->espera_prox = -1;
+  proc->em_espera = false;
+  proc->tempo_real = false;
+  proc->lider_idx = -1;
+  proc->num_threads = 0;
+  proc->em_uso = false;
+  proc->vivo_ant = -1;
+  proc->vivo_prox = -1;
+  proc->pid_prox = -1;
+}
+
+// aumenta uma fila circular para 'capacidade' itens, desenrolando-a
+static bool fila_proc_aumenta(fila_proc_t *fila, int capacidade)
+{
+  int *itens = malloc(capacidade * sizeof(*itens));
+  if (itens == NULL) {
+    return false;
+  }
+  for (int i = 0; i < fila->tamanho; i++) {
+    itens[i] = fila->itens[(fila->inicio + i) % fila->capacidade];
+  }
+  free(fila->itens);
+  fila->itens = itens;
+  fila->capacidade = capacidade;
+  fila->inicio = 0;
+  return true;
+}
+
+// põe 'proc' no balde do seu pid
+static void so_proc_indexa_pid(so_t *self, processo_t *proc)
+{
+  int *balde = &self->pid_baldes[proc->pid % self->capacidade_processos];
+  proc->pid_prox = *balde;
+  *balde = proc->idx;
+}
+
+static void so_proc_desindexa_pid(so_t *self, processo_t *proc)
+{
+  int *elo = &self->pid_baldes[proc->pid % self->capacidade_processos];
+  while (*elo != -1 && *elo != proc->idx) {
+    elo = &so_proc(self, *elo)->pid_prox;
+  }
+  if (*elo == proc->idx) {
+    *elo = proc->pid_prox;
+  }
+  proc->pid_prox = -1;
+}
+
+// refaz o índice de pids e as listas dos que esperam um pid, que são
+//   espalhados pela capacidade da tabela, depois que ela cresceu; as listas
+//   antigas são percorridas na ordem, para que os que esperam o mesmo pid
+//   continuem na ordem em que bloquearam
+static void so_proc_redistribui_pids(so_t *self, int *pid_baldes, lista_espera_t *espera_pid, int num_antigo)
+{
+  lista_espera_t *espera_antiga = self->espera_pid;
+  free(self->pid_baldes);
+  self->pid_baldes = pid_baldes;
+  self->espera_pid = espera_pid;
+  for (int b = 0; b < self->capacidade_processos; b++) {
+    pid_baldes[b] = -1;
+    espera_pid[b] = (lista_espera_t){ -1, -1 };
+  }
+  for (int i = self->vivos_primeiro; i != -1; i = so_proc(self, i)->vivo_prox) {
+    so_proc_indexa_pid(self, so_proc(self, i));
+  }
+  for (int b = 0; b < num_antigo; b++) {
+    int i = espera_antiga[b].primeiro;
+    while (i != -1) {
+      processo_t *proc = so_proc(self, i);
+      i = proc->espera_prox;
+      proc->em_espera = false;
+      so_espera_insere(self, proc);
+    }
+  }
+  free(espera_antiga);
+}
+
+// cria mais um bloco de descritores, livres, e aumenta na mesma medida o que
+//   é indexado pelos descritores (filas e heaps de prontos) ou espalhado por
+//   pid; retorna false se a tabela já tem MAX_PROCESSOS descritores ou se
+//   falta memória
+static bool so_proc_aumenta_tabela(so_t *self)
+{
+  int antiga = self->capacidade_processos;
+  int nova = antiga + PROCESSOS_POR_BLOCO;
+  if (nova > MAX_PROCESSOS) {
+    return false;
+  }
+  int num_blocos = nova / PROCESSOS_POR_BLOCO;
+  processo_t **blocos = realloc(self->blocos_processos, num_blocos * sizeof(*blocos));
+  if (blocos == NULL) {
+    console_printf("SO: sem memória para aumentar a tabela de processos");
+    return false;
+  }
+  self->blocos_processos = blocos;
+  processo_t *bloco = malloc(PROCESSOS_POR_BLOCO * sizeof(*bloco));
+  int *pid_baldes = malloc(nova * sizeof(*pid_baldes));
+  lista_espera_t *espera_pid = malloc(nova * sizeof(*espera_pid));
+  bool filas_ok = fila_proc_aumenta(&self->fila_prontos, nova);
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    filas_ok = filas_ok && fila_proc_aumenta(&self->mlfq_filas[n], nova);
+  }
+  if (bloco == NULL || pid_baldes == NULL || espera_pid == NULL || !filas_ok) {
+    free(bloco);
+    free(pid_baldes);
+    free(espera_pid);
+    console_printf("SO: sem memória para aumentar a tabela de processos");
+    return false;
+  }
+  blocos[num_blocos - 1] = bloco;
+  self->capacidade_processos = nova;
+  fprio_aumenta(self->prontos_prio, nova);
+  fprio_aumenta(self->prontos_rt, nova);
+
+  // os descritores novos são empilhados do último para o primeiro, para
+  //   serem usados na ordem da tabela
+  for (int i = nova - 1; i >= antiga; i--) {
+    processo_t *proc = so_proc(self, i);
+    so_proc_inicializa_descritor(proc, i);
+    proc->vivo_prox = self->livres_primeiro;
+    self->livres_primeiro = i;
+  }
+  so_proc_redistribui_pids(self, pid_baldes, espera_pid, antiga);
+  if (antiga > 0) {
+    console_printf("SO: tabela de processos aumentada para %d descritores", nova);
+  }
+  return true;
+}
+
+// tira um descritor da pilha de livres, aumentando a tabela se ela está
+//   vazia; retorna o índice, ou -1 se não é possível criar mais processos
+static int so_proc_aloca(so_t *self)
+{
+  if (self->livres_primeiro == -1 && !so_proc_aumenta_tabela(self)) {
+    return -1;
+  }
+  int idx = self->livres_primeiro;
+  processo_t *proc = so_proc(self, idx);
+  self->livres_primeiro = proc->vivo_prox;
+  proc->vivo_prox = -1;
+  if (idx >= self->processos_usados) {
+    self->processos_usados = idx + 1;
+  }
+  return idx;
+}
+
+// passa a usar o descritor alocado 'proc' para o processo 'pid': ele entra
+//   no fim da lista de vivos e no índice de pids
+static void so_proc_ativa(so_t *self, processo_t *proc, int pid)
+{
+  proc->pid = pid;
+  proc->em_uso = true;
+  proc->vivo_ant = self->vivos_ultimo;
+  proc->vivo_prox = -1;
+  if (self->vivos_ultimo == -1) {
+    self->vivos_primeiro = proc->idx;
+  } else {
+    so_proc(self, self->vivos_ultimo)->vivo_prox = proc->idx;
+  }
+  self->vivos_ultimo = proc->idx;
+  so_proc_indexa_pid(self, proc);
+}
+
+// devolve à pilha de livres o descritor de um processo que acabou (ou que
+//   não chegou a ser criado); o pid e as métricas ficam, para o relatório,
+//   até o descritor ser reusado
+static void so_proc_desativa(so_t *self, processo_t *proc)
+{
+  if (!proc->em_uso) {
+    return;
+  }
+  so_proc_desindexa_pid(self, proc);
+  if (proc->vivo_ant == -1) {
+    self->vivos_primeiro = proc->vivo_prox;
+  } else {
+    so_proc(self, proc->vivo_ant)->vivo_prox = proc->vivo_prox;
+  }
+  if (proc->vivo_prox == -1) {
+    self->vivos_ultimo = proc->vivo_ant;
+  } else {
+    so_proc(self, proc->vivo_prox)->vivo_ant = proc->vivo_ant;
+  }
+  proc->em_uso = false;
+  proc->vivo_ant = -1;
+  proc->vivo_prox = self->livres_primeiro;
+  self->livres_primeiro = proc->idx;
+}
+
+
 // ---------------------------------------------------------------------
 // TRATAMENTO DE INTERRUPÇÃO {{{1
 // ---------------------------------------------------------------------
 
 // funções auxiliares para o tratamento de interrupção
 static void so_salva_estado_da_cpu(so_t *self);
+static void so_relogio_contabiliza_ticks(so_t *self);
+static void so_relogio_programa(so_t *self);
 static void so_trata_irq(so_t *self, int irq);
 static void so_trata_pendencias(so_t *self);
 static void fila_prontos_insere(so_t *self, int idx_proc);
@@ -287,7 +863,13 @@ static void so_registra_preempcao(so_t *self, processo_t *proc);
 static void so_calcula_prioridade(so_t *self, processo_t *proc);
 static void so_escalona_rr(so_t *self);
 static void so_escalona_prio(so_t *self);
+static void so_escalona_mlfq(so_t *self);
+static void so_escalona_cfs(so_t *self);
+static void so_escalona_stride(so_t *self);
+static void so_escalona_loteria(so_t *self);
 static void so_escalona(so_t *self);
+static void so_adapta_quantum(so_t *self);
+static void so_concede_quantum(so_t *self, processo_t *proc);
 static int so_despacha(so_t *self);
 static void so_imprime_relatorio_final(so_t *self);
 
@@ -315,6 +897,8 @@ static int so_trata_interrupcao(void *argC, int reg_A)
   }
   // salva o estado da cpu no descritor do processo que foi interrompido
   so_salva_estado_da_cpu(self);
+  // contabiliza os ticks do relógio que passaram, para o processo interrompido
+  so_relogio_contabiliza_ticks(self);
   // faz o atendimento da interrupção
   so_trata_irq(self, irq);
   // faz o processamento independente da interrupção
@@ -326,6 +910,8 @@ static int so_trata_interrupcao(void *argC, int reg_A)
   if (self->processo_em_execucao_idx == -1) {
     so_mmu_define_tabpag(self, NULL);
   }
+  // programa o timer para o próximo evento
+  so_relogio_programa(self);
   return retorno;
 }
 
@@ -337,7 +923,7 @@ static void so_salva_estado_da_cpu(so_t *self)
   }
 
   // Obtém o ponteiro para o PCB do processo atual
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
 
   // Salva os registradores da memória para o PCB
   if (mem_le(self->mem, CPU_END_A, &proc->estado_cpu.regA) != ERR_OK
@@ -350,48 +936,227 @@ static void so_salva_estado_da_cpu(so_t *self)
   }
 }
 
+// desbloqueia os processos cujo prazo venceu; só são visitadas as posições
+//   da roda entre a última entrada no SO e agora (os processos esperando
+//   terminais ou o disco são desbloqueados na interrupção do dispositivo)
+// inicia a gravação dos blocos da cache cujo atraso terminou, se o disco
+//   está livre
 static void so_trata_pendencias(so_t *self)
 {
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    processo_t *proc = &self->tabela_processos[i];
-    if (proc->estado != BLOQUEADO) {
-      continue;
-    }
-    so_tenta_desbloquear_processo(self, i);
-  }
+  so_roda_avanca(self, so_get_tempo(self));
+  so_disco_inicia(self);
 }
 
-static void so_tenta_desbloquear_processo(so_t *self, int idx_proc)
-{
-  processo_t *proc = &self->tabela_processos[idx_proc];
+// ---------------------------------------------------------------------
+// FILAS DE ESPERA {{{1
+// ---------------------------------------------------------------------
 
+// lista em que deve estar um processo bloqueado, conforme o motivo
+static lista_espera_t *so_espera_lista(so_t *self, processo_t *proc)
+{
   switch (proc->motivo_bloqueio) {
     case BLOQUEIO_IO_LE:
-      so_tenta_desbloquear_leitura(self, proc, idx_proc);
-      break;
     case BLOQUEIO_IO_ESCR:
-      so_tenta_desbloquear_escrita(self, proc, idx_proc);
-      break;
-    case BLOQUEIO_PAGINA: {
-      int tempo_atual = so_get_tempo(self);
-      if (tempo_atual < proc->tempo_desbloqueio) {
+    case BLOQUEIO_BUF_ESCR:
+    case BLOQUEIO_BUF_LE: {
+      int t = so_terminal_indice(proc->dispositivo_esperado);
+      int sentido = proc->motivo_bloqueio == BLOQUEIO_IO_LE
+                    || proc->motivo_bloqueio == BLOQUEIO_BUF_LE ? 0 : 1;
+      return &self->espera_term[t][sentido];
+    }
+    case BLOQUEIO_PID:
+      return &self->espera_pid[proc->pid_esperado % self->capacidade_processos];
+    case BLOQUEIO_PAGINA:
+    case BLOQUEIO_PERIODO:
+      return &self->roda[(proc->tempo_desbloqueio / RODA_GRANULARIDADE) % RODA_POSICOES];
+    case BLOQUEIO_DISCO:
+      return &self->espera_disco;
+    default:
+      return NULL;
+  }
+}
+
+// true se o processo espera um prazo (está na roda de temporização)
+static bool so_espera_na_roda(processo_t *proc)
+{
+  return proc->motivo_bloqueio == BLOQUEIO_PAGINA || proc->motivo_bloqueio == BLOQUEIO_PERIODO;
+}
+
+// encadeia no fim da sua lista um processo que acabou de bloquear; o motivo
+//   (e o terminal, pid ou prazo) não pode mudar até ele ser retirado
+static void so_espera_insere(so_t *self, processo_t *proc)
+{
+  lista_espera_t *lista = so_espera_lista(self, proc);
+  if (lista == NULL || proc->em_espera) {
+    return;
+  }
+  int idx_proc = proc->idx;
+  proc->espera_ant = lista->ultimo;
+  proc->espera_prox = -1;
+  if (lista->ultimo == -1) {
+    lista->primeiro = idx_proc;
+  } else {
+    so_proc(self, lista->ultimo)->espera_prox = idx_proc;
+  }
+  lista->ultimo = idx_proc;
+  proc->em_espera = true;
+
+  if (so_espera_na_roda(proc)) {
+    self->roda_num++;
+  } else if (proc->motivo_bloqueio != BLOQUEIO_PID && proc->motivo_bloqueio != BLOQUEIO_DISCO) {
+    self->espera_term_mapa |= 1u << (lista - &self->espera_term[0][0]);
+  }
+}
+
+// desencadeia um processo que deixa de estar bloqueado (foi desbloqueado ou
+//   morto); chamada por so_atualiza_estado
+static void so_espera_retira(so_t *self, processo_t *proc)
+{
+  if (!proc->em_espera) {
+    return;
+  }
+  lista_espera_t *lista = so_espera_lista(self, proc);
+  if (proc->espera_ant == -1) {
+    lista->primeiro = proc->espera_prox;
+  } else {
+    so_proc(self, proc->espera_ant)->espera_prox = proc->espera_prox;
+  }
+  if (proc->espera_prox == -1) {
+    lista->ultimo = proc->espera_ant;
+  } else {
+    so_proc(self, proc->espera_prox)->espera_ant = proc->espera_ant;
+  }
+  proc->espera_ant = -1;
+  proc->espera_prox = -1;
+  proc->em_espera = false;
+
+  if (so_espera_na_roda(proc)) {
+    self->roda_num--;
+  } else if (proc->motivo_bloqueio != BLOQUEIO_PID && proc->motivo_bloqueio != BLOQUEIO_DISCO
+             && lista->primeiro == -1) {
+    self->espera_term_mapa &= ~(1u << (lista - &self->espera_term[0][0]));
+  }
+}
+
+// atende as filas de espera de terminal com bit ligado em 'mapa' (bit 2*t+sentido,
+//   como em espera_term_mapa); de cada fila, o primeiro é consultado e os
+//   seguintes são atendidos enquanto o dispositivo estiver pronto
+static void so_espera_atende_terminais(so_t *self, unsigned int mapa)
+{
+  mapa &= self->espera_term_mapa;
+  while (mapa != 0) {
+    int bit = __builtin_ctz(mapa);
+    mapa &= mapa - 1;
+    lista_espera_t *lista = &self->espera_term[bit / 2][bit % 2];
+    while (lista->primeiro != -1) {
+      int idx_proc = lista->primeiro;
+      processo_t *proc = so_proc(self, idx_proc);
+      if (bit % 2 == 0) {
+        so_tenta_desbloquear_leitura(self, proc, idx_proc);
+      } else {
+        so_tenta_desbloquear_escrita(self, proc, idx_proc);
+      }
+      if (lista->primeiro == idx_proc) {
+        break; // o terminal não está pronto
+      }
+    }
+  }
+}
+
+// desbloqueia os processos com prazo (fim de transferência de página ou
+//   início de período de tempo real) até 'agora', visitando
+//   só as posições da roda entre o último instante processado e 'agora'; os
+//   processos numa dessas posições com prazo numa volta futura continuam lá
+static void so_roda_avanca(so_t *self, int agora)
+{
+  if (self->roda_num > 0 && agora >= self->roda_tempo) {
+    int primeira = self->roda_tempo / RODA_GRANULARIDADE;
+    int ultima = agora / RODA_GRANULARIDADE;
+    if (ultima - primeira >= RODA_POSICOES) {
+      ultima = primeira + RODA_POSICOES - 1; // uma volta visita todas
+    }
+    for (int p = primeira; p <= ultima && self->roda_num > 0; p++) {
+      int idx_proc = self->roda[p % RODA_POSICOES].primeiro;
+      while (idx_proc != -1) {
+        processo_t *proc = so_proc(self, idx_proc);
+        int proximo = proc->espera_prox;
+        if (proc->tempo_desbloqueio <= agora) {
+          if (proc->motivo_bloqueio == BLOQUEIO_PERIODO) {
+            console_printf("SO: EDF: começa um período do processo %d", proc->pid);
+            so_edf_proximo_periodo(proc);
+          } else {
+            console_printf("SO: Processo %d desbloqueado apos transferencia de pagina", proc->pid);
+          }
+          so_atualiza_estado(self, proc, PRONTO);
+          proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+          proc->tempo_desbloqueio = 0;
+          so_insere_em_pronto(self, idx_proc);
+        }
+        idx_proc = proximo;
+      }
+    }
+  }
+  self->roda_tempo = agora;
+}
+
+#ifdef CONFIG_RELOGIO_SEM_TICK
+// menor prazo na roda, ou -1 se ela está vazia; a primeira posição, a partir
+//   da atual, que tem um prazo desta volta contém o menor; se todos os prazos
+//   estão a mais de uma volta, todas as posições são consultadas
+static int so_roda_proximo_prazo(so_t *self)
+{
+  if (self->roda_num == 0) {
+    return -1;
+  }
+  int menor = -1;
+  int atual = self->roda_tempo / RODA_GRANULARIDADE;
+  for (int volta = 0; volta < 2 && menor == -1; volta++) {
+    for (int p = atual; p < atual + RODA_POSICOES; p++) {
+      int idx_proc = self->roda[p % RODA_POSICOES].primeiro;
+      for (; idx_proc != -1; idx_proc = so_proc(self, idx_proc)->espera_prox) {
+        int prazo = so_proc(self, idx_proc)->tempo_desbloqueio;
+        if (volta == 0 && prazo / RODA_GRANULARIDADE > p) {
+          continue;
+        }
+        if (menor == -1 || prazo < menor) menor = prazo;
+      }
+      if (menor != -1 && volta == 0) {
         break;
       }
-      console_printf("SO: Processo %d desbloqueado apos transferencia de pagina", proc->pid);
-      so_atualiza_estado(self, proc, PRONTO);
-      proc->motivo_bloqueio = BLOQUEIO_NENHUM;
-      proc->tempo_desbloqueio = 0;
-      so_insere_em_pronto(self, idx_proc);
-      break;
     }
-    default:
-      break;
   }
+  return menor;
 }
+#endif
 
 static void so_tenta_desbloquear_leitura(so_t *self, processo_t *proc, int idx_proc)
 {
   int term = proc->dispositivo_esperado;
+  int t = so_terminal_indice(term);
+
+  if (proc->motivo_bloqueio == BLOQUEIO_BUF_LE) {
+    // o PC aponta para o CHAMAS e A ainda tem o número da chamada, que é
+    //   refeita quando o buffer tiver o que ela espera
+    so_entrada_enche(self, t);
+    if (!so_entrada_pronta(self, t, proc->estado_cpu.regA == SO_LE_LINHA)) {
+      return;
+    }
+    so_atualiza_estado(self, proc, PRONTO);
+    proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+    so_insere_em_pronto(self, idx_proc);
+    console_printf("SO: Processo %d desbloqueado por E/S (buffer de entrada)", proc->pid);
+    return;
+  }
+  if (self->entrada_term[t].tamanho > 0) {
+    // caracteres já lidos do teclado vêm antes dos que estão nele
+    proc->estado_cpu.regA = so_entrada_retira(self, t);
+    so_atualiza_estado(self, proc, PRONTO);
+    proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+    so_insere_em_pronto(self, idx_proc);
+    console_printf("SO: Processo %d desbloqueado por E/S (leitura)", proc->pid);
+    return;
+  }
+
   int estado;
   if (es_le(self->es, term + TERM_TECLADO_OK, &estado) != ERR_OK) {
     console_printf("SO (pend): erro ao ler estado teclado (proc %d)", proc->pid);
@@ -422,6 +1187,35 @@ static void so_tenta_desbloquear_leitura(so_t *self, processo_t *proc, int idx_p
 static void so_tenta_desbloquear_escrita(so_t *self, processo_t *proc, int idx_proc)
 {
   int term = proc->dispositivo_esperado;
+  int t = so_terminal_indice(term);
+  buf_term_t *saida = &self->saida_term[t];
+
+  if (proc->motivo_bloqueio == BLOQUEIO_BUF_ESCR) {
+    // o PC aponta para o CHAMAS, e a chamada continua de onde parou; só
+    //   acorda quando o buffer esvaziou até a metade, para não acordar o
+    //   processo a cada caractere que a tela aceita
+    if (saida->tamanho > CONFIG_TAM_BUF_TERMINAL / 2) {
+      return;
+    }
+    so_atualiza_estado(self, proc, PRONTO);
+    proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+    so_insere_em_pronto(self, idx_proc);
+    console_printf("SO: Processo %d desbloqueado por E/S (buffer de saída)", proc->pid);
+    return;
+  }
+  if (saida->tamanho > 0) {
+    // há caracteres de SO_ESCR_BUF na frente deste, que vai para o buffer
+    if (!so_saida_insere(self, t, proc->estado_cpu.regX)) {
+      return;
+    }
+    proc->estado_cpu.regA = 0;
+    so_atualiza_estado(self, proc, PRONTO);
+    proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+    so_insere_em_pronto(self, idx_proc);
+    console_printf("SO: Processo %d desbloqueado por E/S (escrita)", proc->pid);
+    return;
+  }
+
   int estado;
   if (es_le(self->es, term + TERM_TELA_OK, &estado) != ERR_OK) {
     console_printf("SO (pend): erro ao ler estado tela (proc %d)", proc->pid);
@@ -449,37 +1243,261 @@ static void so_tenta_desbloquear_escrita(so_t *self, processo_t *proc, int idx_p
   console_printf("SO: Processo %d desbloqueado por E/S (escrita)", proc->pid);
 }
 
+// true se o processo acabou de bloquear esperando um terminal ou o disco
+//   (conta como processo limitado por E/S para o MLFQ e o quantum adaptativo)
+static bool so_bloqueado_por_es(processo_t *proc)
+{
+  return proc->estado == BLOQUEADO
+         && (proc->motivo_bloqueio == BLOQUEIO_IO_LE
+             || proc->motivo_bloqueio == BLOQUEIO_IO_ESCR
+             || proc->motivo_bloqueio == BLOQUEIO_BUF_ESCR
+             || proc->motivo_bloqueio == BLOQUEIO_BUF_LE
+             || proc->motivo_bloqueio == BLOQUEIO_DISCO);
+}
+
+// --- Buffers de saída dos terminais (SO_ESCR_BUF) ---
+
+// índice (0 para o terminal A) do terminal cujo primeiro dispositivo é 'term'
+static int so_terminal_indice(int term)
+{
+  return (term - D_TERM_A) / (D_TERM_B - D_TERM_A);
+}
+
+// põe um caractere no fim do buffer de saída do terminal 't'; retorna false
+//   se o buffer está cheio
+static bool so_saida_insere(so_t *self, int t, int dado)
+{
+  buf_term_t *saida = &self->saida_term[t];
+  if (saida->tamanho == CONFIG_TAM_BUF_TERMINAL) {
+    return false;
+  }
+  saida->itens[(saida->inicio + saida->tamanho) % CONFIG_TAM_BUF_TERMINAL] = dado;
+  saida->tamanho++;
+  return true;
+}
+
+// envia ao terminal 't' os caracteres do buffer de saída enquanto ele aceitar
+static void so_saida_escoa(so_t *self, int t)
+{
+  buf_term_t *saida = &self->saida_term[t];
+  int term = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  while (saida->tamanho > 0) {
+    int estado;
+    if (es_le(self->es, term + TERM_TELA_OK, &estado) != ERR_OK
+        || (estado != 0 && es_escreve(self->es, term + TERM_TELA, saida->itens[saida->inicio]) != ERR_OK)) {
+      console_printf("SO: problema no acesso à tela do terminal %d", t);
+      self->erro_interno = true;
+      return;
+    }
+    if (estado == 0) {
+      return;
+    }
+    saida->inicio = (saida->inicio + 1) % CONFIG_TAM_BUF_TERMINAL;
+    saida->tamanho--;
+  }
+}
+
+// --- Buffers de entrada dos terminais (SO_LE_LINHA, SO_LE_BUF) ---
+
+// passa para o buffer de entrada do terminal 't' os caracteres disponíveis
+//   no teclado, enquanto couberem
+static void so_entrada_enche(so_t *self, int t)
+{
+  buf_term_t *entrada = &self->entrada_term[t];
+  int term = D_TERM_A + t * (D_TERM_B - D_TERM_A);
+  while (entrada->tamanho < CONFIG_TAM_BUF_TERMINAL) {
+    int estado, dado;
+    if (es_le(self->es, term + TERM_TECLADO_OK, &estado) != ERR_OK
+        || (estado != 0 && es_le(self->es, term + TERM_TECLADO, &dado) != ERR_OK)) {
+      console_printf("SO: problema no acesso ao teclado do terminal %d", t);
+      self->erro_interno = true;
+      return;
+    }
+    if (estado == 0) {
+      return;
+    }
+    entrada->itens[(entrada->inicio + entrada->tamanho) % CONFIG_TAM_BUF_TERMINAL] = dado;
+    entrada->tamanho++;
+    if (dado == '\n') self->entrada_linhas[t]++;
+  }
+}
+
+// retira o primeiro caractere do buffer de entrada do terminal 't', que não
+//   pode estar vazio
+static int so_entrada_retira(so_t *self, int t)
+{
+  buf_term_t *entrada = &self->entrada_term[t];
+  int dado = entrada->itens[entrada->inicio];
+  entrada->inicio = (entrada->inicio + 1) % CONFIG_TAM_BUF_TERMINAL;
+  entrada->tamanho--;
+  if (dado == '\n') self->entrada_linhas[t]--;
+  return dado;
+}
+
+// true se o buffer de entrada do terminal 't' tem o que uma leitura espera:
+//   uma linha inteira (ou o buffer cheio) para SO_LE_LINHA, algum caractere
+//   para SO_LE_BUF
+static bool so_entrada_pronta(so_t *self, int t, bool linha)
+{
+  buf_term_t *entrada = &self->entrada_term[t];
+  if (!linha) {
+    return entrada->tamanho > 0;
+  }
+  return self->entrada_linhas[t] > 0 || entrada->tamanho == CONFIG_TAM_BUF_TERMINAL;
+}
+
 // --- Helpers da Fila de Prontos (RR) ---
 static void fila_prontos_insere(so_t *self, int idx_proc)
 {
-  if (self->fila_prontos_tamanho == MAX_PROCESSOS) {
+  fila_proc_t *fila = &self->fila_prontos;
+  if (fila->tamanho == fila->capacidade) {
     console_printf("SO: Fila de prontos cheia!");
-    return; // ou erro fatal
+    self->erro_interno = true; // a fila tem lugar para todos os processos
+    return;
   }
-  self->fila_prontos[self->fila_prontos_fim] = idx_proc;
-  self->fila_prontos_fim = (self->fila_prontos_fim + 1) % MAX_PROCESSOS;
-  self->fila_prontos_tamanho++;
+  fila->itens[(fila->inicio + fila->tamanho) % fila->capacidade] = idx_proc;
+  fila->tamanho++;
 }
 
 static int fila_prontos_remove(so_t *self)
 {
-  if (self->fila_prontos_tamanho == 0) {
+  fila_proc_t *fila = &self->fila_prontos;
+  if (fila->tamanho == 0) {
     return -1; // Fila vazia
   }
-  int idx_proc = self->fila_prontos[self->fila_prontos_inicio];
-  self->fila_prontos_inicio = (self->fila_prontos_inicio + 1) % MAX_PROCESSOS;
-  self->fila_prontos_tamanho--;
+  int idx_proc = fila->itens[fila->inicio];
+  fila->inicio = (fila->inicio + 1) % fila->capacidade;
+  fila->tamanho--;
   return idx_proc;
 }
+
+// retira 'idx_proc' de qualquer posição da fila, mantendo a ordem dos outros
+static void fila_proc_retira(fila_proc_t *fila, int idx_proc)
+{
+  int mantidos = 0;
+  for (int i = 0; i < fila->tamanho; i++) {
+    int item = fila->itens[(fila->inicio + i) % fila->capacidade];
+    if (item != idx_proc) {
+      fila->itens[(fila->inicio + mantidos) % fila->capacidade] = item;
+      mantidos++;
+    }
+  }
+  fila->tamanho = mantidos;
+}
 // --- Fim Helpers Fila ---
 
 // Insere processo na estrutura de PRONTOS de acordo com o onador
 static void so_insere_em_pronto(so_t *self, int idx_proc)
 {
+  if (so_proc(self, idx_proc)->tempo_real) {
+    return; // o heap de tempo real acompanha o estado (so_atualiza_estado)
+  }
   if (self->escalonador_atual == ESCAL_CIRCULAR) {
     fila_prontos_insere(self, idx_proc);
+  } else if (self->escalonador_atual == ESCAL_MLFQ) {
+    so_mlfq_insere(self, idx_proc);
+  } else if (so_usa_heap_prontos(self)) {
+    fprio_insere(self->prontos_prio, idx_proc, so_chave_pronto(self, so_proc(self, idx_proc)));
+  }
+}
+
+// um processo recém-criado já nasce PRONTO (so_inicializa_metricas_processo),
+//   sem passar por so_atualiza_estado: entra nos totais dos prontos e na
+//   estrutura do escalonador, depois de herdar os atributos do criador
+static void so_insere_novo_em_pronto(so_t *self, int idx_proc)
+{
+  so_prontos_contabiliza(self, so_proc(self, idx_proc), PRONTO, 1);
+  so_insere_em_pronto(self, idx_proc);
+}
+
+// atualiza os totais sobre os prontos quando 'proc' entra (sinal 1) ou sai
+//   (sinal -1) do estado 'estado'
+static void so_prontos_contabiliza(so_t *self, processo_t *proc, estado_processo_t estado, int sinal)
+{
+  if (estado == PRONTO) {
+    self->num_prontos += sinal;
+    if (!proc->tempo_real) {
+      self->loteria_bilhetes += sinal * proc->bilhetes;
+    }
+  }
+  if (estado == PRONTO || estado == EXECUTANDO) {
+    self->cfs_soma_pesos += sinal * so_cfs_peso(proc);
+  }
+}
+
+// Retira da estrutura de PRONTOS um processo que deixa de estar pronto sem
+//   ter sido escolhido pelo escalonador (foi morto)
+static void so_remove_de_pronto(so_t *self, int idx_proc)
+{
+  if (so_proc(self, idx_proc)->tempo_real) {
+    fprio_remove(self->prontos_rt, idx_proc);
+  } else if (self->escalonador_atual == ESCAL_CIRCULAR) {
+    fila_proc_retira(&self->fila_prontos, idx_proc);
+  } else if (self->escalonador_atual == ESCAL_MLFQ) {
+    so_mlfq_retira(self, idx_proc);
+  } else if (so_usa_heap_prontos(self)) {
+    fprio_remove(self->prontos_prio, idx_proc);
+  }
+}
+
+// true se o escalonador atual mantém os prontos no heap indexado
+static bool so_usa_heap_prontos(so_t *self)
+{
+  return self->escalonador_atual == ESCAL_PRIORIDADE
+         || self->escalonador_atual == ESCAL_CFS
+         || self->escalonador_atual == ESCAL_STRIDE;
+}
+
+// chave de um processo no heap de prontos (o de menor chave é o escolhido)
+static double so_chave_pronto(so_t *self, processo_t *proc)
+{
+  if (self->escalonador_atual == ESCAL_CFS) {
+    return (double)proc->vruntime;
+  }
+  if (self->escalonador_atual == ESCAL_STRIDE) {
+    return (double)proc->passo;
+  }
+#ifdef CONFIG_ESCALONAMENTO_MEMORIA
+  return proc->prioridade + so_mem_penalidade(self, proc);
+#else
+  return proc->prioridade;
+#endif
+}
+
+// taxa recente de faltas de página do processo, em faltas por 1000 instruções
+static int so_mem_taxa_faltas(processo_t *proc)
+{
+  int instrucoes = proc->instrucoes_recentes;
+  if (instrucoes < INTERVALO_INTERRUPCAO) {
+    instrucoes = INTERVALO_INTERRUPCAO; // pouca execução ainda não dá uma taxa
+  }
+  return proc->faltas_recentes * 1000 / instrucoes;
+}
+
+#ifdef CONFIG_ESCALONAMENTO_MEMORIA
+// acréscimo à chave de prioridade por causa da memória; só há acréscimo com a
+//   memória principal cheia, quando executar um processo tira páginas de outro
+// - acima do limite de taxa de faltas, o processo é segurado: o acréscimo passa
+//   de qualquer prioridade, e ele só é escolhido se não houver outro pronto
+// - abaixo, o acréscimo é a parte do conjunto de trabalho (os quadros que ele
+//   ocupava ao deixar a CPU) que foi tirada da memória desde então, para que
+//   quem ainda tem suas páginas carregadas execute antes
+static double so_mem_penalidade(so_t *self, processo_t *proc)
+{
+  if (self->vm_estado == NULL || vm_estado_num_quadros_livres(self->vm_estado) > 0) {
+    return 0.0;
+  }
+  proc = so_vm_espaco(self, proc);
+  if (so_mem_taxa_faltas(proc) > CONFIG_LIMITE_TAXA_FALTAS) {
+    return 2.0;
   }
+  int conjunto = proc->conjunto_trabalho;
+  if (conjunto <= 0 || proc->quadros_residentes >= conjunto) {
+    return 0.0;
+  }
+  return (double)(conjunto - proc->quadros_residentes) / conjunto;
 }
+#endif
 
 // Atualiza o estado de um processo e registra as métricas de tempo
 static void so_atualiza_estado(so_t *self, processo_t *proc, estado_processo_t novo_estado)
@@ -496,16 +1514,60 @@ static void so_atualiza_estado(so_t *self, processo_t *proc, estado_processo_t n
   }
 
   // Atualiza para o novo estado
+  so_prontos_contabiliza(self, proc, estado_antigo, -1);
+  so_prontos_contabiliza(self, proc, novo_estado, 1);
   proc->estado = novo_estado;
   proc->contagem_estado[novo_estado]++;
   proc->ultimo_tempo_mudanca_estado = tempo_agora;
 
+  if (estado_antigo == BLOQUEADO) {
+    so_espera_retira(self, proc);
+  }
+
   // Se entrou em PRONTO, marca o tempo
   if (novo_estado == PRONTO) {
     proc->ultimo_tempo_pronto = tempo_agora;
   }
 
-  // Se saiu de PRONTO para EXECUTANDO, calcula o tempo de resposta
+  // Os escalonadores de prioridade e CFS não têm fila explícita: o heap de
+  //   prontos acompanha as transições de e para PRONTO; o mesmo vale para o
+  //   heap dos processos de tempo real, ordenado pela data limite
+  if (proc->tempo_real) {
+    int idx_proc = proc->idx;
+    if (novo_estado == PRONTO) {
+      fprio_insere(self->prontos_rt, idx_proc, (double)proc->rt_prazo_abs);
+    } else if (estado_antigo == PRONTO) {
+      fprio_remove(self->prontos_rt, idx_proc);
+    }
+  } else if (so_usa_heap_prontos(self)) {
+    int idx_proc = proc->idx;
+    if (novo_estado == PRONTO) {
+      if (self->escalonador_atual == ESCAL_CFS && estado_antigo == BLOQUEADO) {
+        so_cfs_posiciona_acordado(self, proc);
+      } else if (self->escalonador_atual == ESCAL_STRIDE && estado_antigo == BLOQUEADO) {
+        so_stride_posiciona_acordado(self, proc);
+      }
+      fprio_insere(self->prontos_prio, idx_proc, so_chave_pronto(self, proc));
+    } else if (estado_antigo == PRONTO) {
+      fprio_remove(self->prontos_prio, idx_proc);
+    }
+  }
+
+  if (novo_estado == EXECUTANDO) {
+    proc->inicio_rajada = tempo_agora;
+  }
+  if (estado_antigo == EXECUTANDO) {
+    // as faltas de página são contadas no dono do espaço de endereçamento
+    processo_t *espaco = so_vm_espaco(self, proc);
+    espaco->conjunto_trabalho = espaco->quadros_residentes;
+    espaco->instrucoes_recentes += tempo_agora - proc->inicio_rajada;
+    while (espaco->instrucoes_recentes > CONFIG_JANELA_FALTAS) {
+      espaco->instrucoes_recentes /= 2;
+      espaco->faltas_recentes /= 2;
+    }
+  }
+
+  // Se saiu de PRONTO para EXECUTANDO, calcula o tempo de resposta
   if (estado_antigo == PRONTO && novo_estado == EXECUTANDO) {
     proc->tempo_total_pronto += (tempo_agora - proc->ultimo_tempo_pronto);
   }
@@ -513,6 +1575,11 @@ static void so_atualiza_estado(so_t *self, processo_t *proc, estado_processo_t n
   if ((novo_estado == TERMINADO || novo_estado == LIVRE) && proc->tempo_termino < 0 && estado_antigo != LIVRE) {
     proc->tempo_termino = tempo_agora;
   }
+
+  // o descritor de um processo que acabou volta para a pilha de livres
+  if (novo_estado == LIVRE) {
+    so_proc_desativa(self, proc);
+  }
 }
 
 static void so_registra_preempcao(so_t *self, processo_t *proc)
@@ -528,12 +1595,18 @@ static void so_registra_preempcao(so_t *self, processo_t *proc)
 static void so_calcula_prioridade(so_t *self, processo_t *proc)
 {
   // prio = (prio + t_exec/t_quantum) / 2
-  int t_exec = self->quantum_total - self->quantum_restante;
+  int t_exec = self->quantum_concedido - self->quantum_restante;
   if (t_exec < 0) t_exec = 0; // Caso tenha bloqueado antes do quantum começar
 
-  float percentual_usado = (float)t_exec / (float)self->quantum_total;
+  float percentual_usado = (float)t_exec / (float)self->quantum_concedido;
   proc->prioridade = (proc->prioridade + percentual_usado) / 2.0;
 
+  // se está entre os prontos, reposiciona no heap
+  int idx_proc = proc->idx;
+  if (fprio_contem(self->prontos_prio, idx_proc)) {
+    fprio_insere(self->prontos_prio, idx_proc, so_chave_pronto(self, proc));
+  }
+
   console_printf("SO: Nova prioridade do proc %d: %.2f", proc->pid, proc->prioridade);
 }
 
@@ -541,7 +1614,7 @@ static void so_calcula_prioridade(so_t *self, processo_t *proc)
 static void so_escalona_rr(so_t *self)
 {
   processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
-                             ? &self->tabela_processos[self->processo_em_execucao_idx]
+                             ? so_proc(self, self->processo_em_execucao_idx)
                              : NULL;
 
   proc_atual = so_rr_trata_preempcao(self, proc_atual);
@@ -557,7 +1630,9 @@ static void so_escalona_rr(so_t *self)
 
 static processo_t *so_rr_trata_preempcao(so_t *self, processo_t *proc_atual)
 {
-  if (proc_atual == NULL || !self->deve_preemptar) {
+  // o quantum pode ter acabado na mesma entrada em que o processo bloqueou
+  //   ou morreu; então ele não volta para a fila
+  if (proc_atual == NULL || !self->deve_preemptar || proc_atual->estado != EXECUTANDO) {
     return proc_atual;
   }
 
@@ -586,7 +1661,14 @@ static processo_t *so_rr_verifica_processo_atual(so_t *self, processo_t *proc_at
 
 static void so_rr_escolhe_novo_processo(so_t *self)
 {
+  // uma entrada de quem não está mais pronto (não deveria haver) é descartada,
+  //   para não executar um descritor morto
   int proximo_idx = fila_prontos_remove(self);
+  while (proximo_idx != -1 && so_proc(self, proximo_idx)->estado != PRONTO) {
+    console_printf("SO: RR: descartado da fila o processo %d, que não está pronto",
+                   so_proc(self, proximo_idx)->pid);
+    proximo_idx = fila_prontos_remove(self);
+  }
   if (proximo_idx == -1) {
     self->processo_em_execucao_idx = -1;
     so_registra_entrada_ociosidade(self);
@@ -595,10 +1677,10 @@ static void so_rr_escolhe_novo_processo(so_t *self)
 
   so_registra_saida_ociosidade(self);
 
-  processo_t *proximo_proc = &self->tabela_processos[proximo_idx];
+  processo_t *proximo_proc = so_proc(self, proximo_idx);
   so_atualiza_estado(self, proximo_proc, EXECUTANDO);
   self->processo_em_execucao_idx = proximo_idx;
-  self->quantum_restante = self->quantum_total;
+  so_concede_quantum(self, proximo_proc);
   console_printf("SO: Escalonou %d (RR)", proximo_proc->pid);
 }
 
@@ -627,7 +1709,7 @@ static void so_registra_entrada_ociosidade(so_t *self)
 static void so_escalona_prio(so_t *self)
 {
   processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
-                              ? &self->tabela_processos[self->processo_em_execucao_idx]
+                              ? so_proc(self, self->processo_em_execucao_idx)
                               : NULL;
 
   proc_atual = so_prio_trata_processo_atual(self, proc_atual);
@@ -678,1097 +1760,3486 @@ static void so_prio_escolhe_melhor(so_t *self)
 
   so_registra_saida_ociosidade(self);
 
-  processo_t *novo_proc = &self->tabela_processos[melhor_idx];
+  processo_t *novo_proc = so_proc(self, melhor_idx);
   so_atualiza_estado(self, novo_proc, EXECUTANDO);
   self->processo_em_execucao_idx = melhor_idx;
-  self->quantum_restante = self->quantum_total;
+  so_concede_quantum(self, novo_proc);
   console_printf("SO: Processo %d selecionado para execução (prioridade: %.2f)",
                  novo_proc->pid, novo_proc->prioridade);
 }
 
+// o melhor pronto é o primeiro do heap (menor prioridade, e entre iguais o
+//   de menor índice na tabela, como na varredura da tabela)
 static int so_prio_encontra_melhor(so_t *self)
 {
-  int melhor_idx = -1;
-  float melhor_prio = 1e9f;
+  return fprio_primeiro(self->prontos_prio);
+}
+
+// Escalonador 3: Filas multinível com realimentação (MLFQ)
+// cada nível tem uma fila circular e um quantum que dobra a cada nível; quem
+//   gasta o quantum desce um nível, quem bloqueia para E/S sobe um nível, e
+//   periodicamente todos voltam ao nível 0
+static void so_escalona_mlfq(so_t *self)
+{
+  processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
+                             ? so_proc(self, self->processo_em_execucao_idx)
+                             : NULL;
 
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    processo_t *p = &self->tabela_processos[i];
-    if (p->estado != PRONTO) {
-      continue;
-    }
-    if (p->prioridade < melhor_prio) {
-      melhor_prio = p->prioridade;
-      melhor_idx = i;
-    }
+  proc_atual = so_mlfq_trata_processo_atual(self, proc_atual);
+  self->deve_preemptar = false;
+
+  if (proc_atual != NULL) {
+    return;
   }
 
-  return melhor_idx;
+  so_mlfq_escolhe_novo_processo(self);
 }
 
-static void so_escalona(so_t *self)
+// quantum do nível: dobra a cada nível, até CONFIG_MLFQ_QUANTUM_MAXIMO (um
+//   deslocamento direto estouraria o int bem antes do último nível)
+static int so_mlfq_quantum(int nivel)
 {
-  // Despacha para o escalonador configurado
-  if (self->escalonador_atual == ESCAL_CIRCULAR) {
-    so_escalona_rr(self);
-  } else {
-    // ESCAL_PRIORIDADE
-    so_escalona_prio(self);
+  int quantum = CONFIG_MLFQ_QUANTUM_INICIAL;
+  for (int n = 0; n < nivel && quantum < CONFIG_MLFQ_QUANTUM_MAXIMO; n++) {
+    quantum *= 2;
   }
+  return quantum < CONFIG_MLFQ_QUANTUM_MAXIMO ? quantum : CONFIG_MLFQ_QUANTUM_MAXIMO;
 }
 
-static int so_despacha(so_t *self)
+static void so_mlfq_insere(so_t *self, int idx_proc)
 {
-  // Se não houver processo para executar, retorna 1 (HALT)
-  if (self->processo_em_execucao_idx == -1) {
-    if (!self->cpu_em_halt) {
-      console_printf("SO: Nenhum processo pronto. CPU em HALT.");
-      self->cpu_em_halt = true;
-    }
-    return 1; // Diz ao trata_int.asm para executar PARA
+  int nivel = so_proc(self, idx_proc)->nivel_mlfq;
+  fila_proc_t *fila = &self->mlfq_filas[nivel];
+  if (fila->tamanho == fila->capacidade) {
+    console_printf("SO: Fila MLFQ do nível %d cheia!", nivel);
+    self->erro_interno = true; // a fila tem lugar para todos os processos
+    return;
   }
+  fila->itens[(fila->inicio + fila->tamanho) % fila->capacidade] = idx_proc;
+  fila->tamanho++;
+  self->mlfq_mapa |= 1u << nivel;
+}
 
-  // Obtém o ponteiro para o PCB do processo que vai executar
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
-
-  self->cpu_em_halt = false;
-
-  // Escreve os registradores do PCB para a memória
-  if (mem_escreve(self->mem, CPU_END_A, proc->estado_cpu.regA) != ERR_OK
-      || mem_escreve(self->mem, CPU_END_PC, proc->estado_cpu.regPC) != ERR_OK
-      || mem_escreve(self->mem, CPU_END_erro, proc->estado_cpu.regERRO) != ERR_OK
-      || mem_escreve(self->mem, 59, proc->estado_cpu.regX) != ERR_OK
-      || mem_escreve(self->mem, CPU_END_complemento, proc->estado_cpu.complemento) != ERR_OK) {
-    console_printf("SO: erro na escrita dos registradores do PCB");
-    self->erro_interno = true;
-    return 1; // Erro, melhor parar
+// retira o primeiro processo da fila não vazia de maior prioridade; o nível
+//   é encontrado em tempo constante pelo primeiro bit ligado do mapa
+static int so_mlfq_remove(so_t *self)
+{
+  if (self->mlfq_mapa == 0) {
+    return -1;
   }
+  int nivel = __builtin_ctz(self->mlfq_mapa);
+  fila_proc_t *fila = &self->mlfq_filas[nivel];
+  int idx_proc = fila->itens[fila->inicio];
+  fila->inicio = (fila->inicio + 1) % fila->capacidade;
+  fila->tamanho--;
+  if (fila->tamanho == 0) {
+    self->mlfq_mapa &= ~(1u << nivel);
+  }
+  return idx_proc;
+}
 
-  // define a tabela de páginas para o processo atual
-  so_mmu_define_tabpag(self, proc->tabela_paginas);
+// retira 'idx_proc' do meio da fila do seu nível, mantendo a ordem dos demais
+static void so_mlfq_retira(so_t *self, int idx_proc)
+{
+  int nivel = so_proc(self, idx_proc)->nivel_mlfq;
+  fila_proc_t *fila = &self->mlfq_filas[nivel];
+  fila_proc_retira(fila, idx_proc);
+  if (fila->tamanho == 0) {
+    self->mlfq_mapa &= ~(1u << nivel);
+  }
+}
 
-  return 0; // Diz ao trata_int.asm para executar RETI
+// leva todos os processos ao nível 0; os prontos entram na fila do nível 0
+//   na ordem dos níveis de onde vieram
+static void so_mlfq_eleva_todos(so_t *self)
+{
+  console_printf("SO: MLFQ: elevação periódica de todos os processos ao nível 0");
+  fila_proc_t *topo = &self->mlfq_filas[0];
+  for (int nivel = 1; nivel < CONFIG_MLFQ_NIVEIS; nivel++) {
+    fila_proc_t *fila = &self->mlfq_filas[nivel];
+    for (int i = 0; i < fila->tamanho && topo->tamanho < topo->capacidade; i++) {
+      topo->itens[(topo->inicio + topo->tamanho) % topo->capacidade] =
+        fila->itens[(fila->inicio + i) % fila->capacidade];
+      topo->tamanho++;
+    }
+    fila->tamanho = 0;
+  }
+  self->mlfq_mapa = topo->tamanho > 0 ? 1u : 0u;
+  for (int i = self->vivos_primeiro; i != -1; i = so_proc(self, i)->vivo_prox) {
+    so_proc(self, i)->nivel_mlfq = 0;
+  }
 }
 
+// chamada pelo tratador do relógio quando o processo em execução gasta o quantum
+static void so_mlfq_fim_de_quantum(so_t *self, processo_t *proc)
+{
+  if (proc->nivel_mlfq < CONFIG_MLFQ_NIVEIS - 1) {
+    proc->nivel_mlfq++;
+    console_printf("SO: MLFQ: processo %d desce para o nível %d", proc->pid, proc->nivel_mlfq);
+  }
+}
 
-// ---------------------------------------------------------------------
-// TRATAMENTO DE UMA IRQ {{{1
-// ---------------------------------------------------------------------
+static processo_t *so_mlfq_trata_processo_atual(so_t *self, processo_t *proc_atual)
+{
+  if (proc_atual == NULL) {
+    return NULL;
+  }
 
-// funções auxiliares para tratar cada tipo de interrupção
-static void so_trata_reset(so_t *self);
-static void so_trata_irq_chamada_sistema(so_t *self);
-static void so_trata_irq_err_cpu(so_t *self);
-static void so_trata_irq_relogio(so_t *self);
-static void so_trata_irq_desconhecida(so_t *self, int irq);
+  int idx_atual = self->processo_em_execucao_idx;
 
-static void so_trata_irq(so_t *self, int irq)
-{
-  // --- Métricas (Parte III) ---
-  if (irq >= 0 && irq < N_IRQ) {
-    self->metricas.num_irq[irq]++;
+  if (proc_atual->estado != EXECUTANDO) {
+    bool bloqueou_es = so_bloqueado_por_es(proc_atual);
+    if (bloqueou_es && proc_atual->nivel_mlfq > 0) {
+      proc_atual->nivel_mlfq--;
+      console_printf("SO: MLFQ: processo %d sobe para o nível %d", proc_atual->pid, proc_atual->nivel_mlfq);
+    }
+    self->processo_em_execucao_idx = -1;
+    return NULL;
   }
-  // --- Fim Métricas ---
 
-  // verifica o tipo de interrupção que está acontecendo, e atende de acordo
-  switch (irq) {
-    case IRQ_RESET:
-      so_trata_reset(self);
-      break;
-    case IRQ_SISTEMA:
-      so_trata_irq_chamada_sistema(self);
-      break;
-    case IRQ_ERR_CPU:
-      so_trata_irq_err_cpu(self);
-      break;
-    case IRQ_RELOGIO:
-      so_trata_irq_relogio(self);
-      break;
-    default:
-      so_trata_irq_desconhecida(self, irq);
+  // preempção por fim de quantum, ou porque ficou pronto um processo de
+  //   nível mais prioritário que o atual
+  unsigned int mais_prioritarios = self->mlfq_mapa & ((1u << proc_atual->nivel_mlfq) - 1);
+  if (!self->deve_preemptar && mais_prioritarios == 0) {
+    return proc_atual;
   }
+
+  console_printf("SO: Preempção MLFQ do processo %d (nível %d)", proc_atual->pid, proc_atual->nivel_mlfq);
+  so_registra_preempcao(self, proc_atual);
+  so_atualiza_estado(self, proc_atual, PRONTO);
+  so_mlfq_insere(self, idx_atual);
+  self->processo_em_execucao_idx = -1;
+  return NULL;
 }
 
-// chamada uma única vez, quando a CPU inicializa
-static void so_trata_reset(so_t *self)
+static void so_mlfq_escolhe_novo_processo(so_t *self)
 {
-  // coloca o tratador de interrupção na memória
-  // quando a CPU aceita uma interrupção, passa para modo supervisor,
-  //   salva seu estado à partir do endereço CPU_END_PC, e desvia para o
-  //   endereço CPU_END_TRATADOR
-  // colocamos no endereço CPU_END_TRATADOR o programa de tratamento
-  //   de interrupção (escrito em asm). esse programa deve conter a
-  //   instrução CHAMAC, que vai chamar so_trata_interrupcao (como
-  //   foi definido na inicialização do SO)
-  int ender = so_carrega_programa(self, "trata_int.maq", NULL);
-  if (ender != CPU_END_TRATADOR) {
-    console_printf("SO: problema na carga do programa de tratamento de interrupcao");
-    self->erro_interno = true;
+  int proximo_idx = so_mlfq_remove(self);
+  if (proximo_idx == -1) {
+    self->processo_em_execucao_idx = -1;
+    so_registra_entrada_ociosidade(self);
+    return;
   }
 
-  // programa o relógio para gerar uma interrupção após INTERVALO_INTERRUPCAO
-  if (es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO) != ERR_OK) {
-    console_printf("SO: problema na programação do timer");
-    self->erro_interno = true;
-  }
+  so_registra_saida_ociosidade(self);
 
-  // coloca o programa init na memória
-  int pid_init = self->proximo_pid;
-  processo_t *proc_init = &self->tabela_processos[0];
-  so_proc_inicializa_vm(self, proc_init);
-  proc_init->pid = pid_init;
+  processo_t *proximo_proc = so_proc(self, proximo_idx);
+  so_atualiza_estado(self, proximo_proc, EXECUTANDO);
+  self->processo_em_execucao_idx = proximo_idx;
+  self->quantum_restante = so_mlfq_quantum(proximo_proc->nivel_mlfq);
+  console_printf("SO: Escalonou %d (MLFQ, nível %d, quantum %d)",
+                 proximo_proc->pid, proximo_proc->nivel_mlfq, self->quantum_restante);
+}
 
-  ender = so_carrega_programa(self, "init.maq", proc_init);
-  if (ender < 0) {
-    console_printf("SO: problema na carga do programa inicial");
-    self->erro_interno = true;
+// Escalonador 4: Justo (CFS)
+// cada processo acumula tempo virtual de execução (vruntime), o tempo real
+//   dividido pelo seu peso; executa sempre o pronto de menor vruntime, por uma
+//   fatia que é a parte da latência alvo proporcional ao seu peso
+static void so_escalona_cfs(so_t *self)
+{
+  processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
+                             ? so_proc(self, self->processo_em_execucao_idx)
+                             : NULL;
+
+  if (proc_atual != NULL) {
+    so_cfs_contabiliza(self, proc_atual);
+  }
+  proc_atual = so_cfs_trata_processo_atual(self, proc_atual);
+  self->deve_preemptar = false;
+
+  if (proc_atual != NULL) {
     return;
   }
 
-  // Cria o primeiro processo (init)
-  so_inicializa_metricas_processo(self, proc_init, pid_init, ender);
-  self->proximo_pid = pid_init + 1;
-  proc_init->terminal = D_TERM_A; // Processo 0 usa o Terminal A
+  so_cfs_escolhe_novo_processo(self);
+}
 
-  // Adiciona na fila de prontos (para RR)
-  // (Implementaremos a fila no próximo prompt, por enquanto só adicionamos)
-  so_insere_em_pronto(self, 0);
+// pesos por nice, de -20 a 19, os mesmos do CFS do Linux: cada nível de nice
+//   muda em cerca de 10% a parte da CPU que cabe ao processo
+#define CFS_PESO_NICE_0 1024
+static const int cfs_peso_por_nice[40] = {
+  88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+   9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+   1024,   820,   655,   526,   423,   335,   272,   215,   172,   137,
+    110,    87,    70,    56,    45,    36,    29,    23,    18,    15,
+};
 
-  // A interrupção do BIOS não define um processo_em_execucao_idx.
-  // O escalonador será chamado pela primeira vez ao fim de
-  // so_trata_interrupcao e vai selecionar este processo.
+static int so_cfs_peso(processo_t *proc)
+{
+  int nice = proc->nice;
+  if (nice < -20) nice = -20;
+  if (nice > 19) nice = 19;
+  return cfs_peso_por_nice[nice + 20];
 }
 
-// interrupção gerada quando a CPU identifica um erro
-static void so_trata_irq_err_cpu(so_t *self)
+// soma ao vruntime do processo em execução o tempo desde a última contabilização
+static void so_cfs_contabiliza(so_t *self, processo_t *proc)
 {
-  if (self->processo_em_execucao_idx == -1) {
-    // Erro de CPU sem processo (ex: durante o boot, antes do init)
-    // Isso é um erro fatal do sistema.
-    console_printf("SO: IRQ de erro fatal na CPU (sem processo corrente)!");
-    self->erro_interno = true; // Para a simulação
+  int agora = so_get_tempo(self);
+  int delta = agora - self->cfs_inicio_contabilizacao;
+  self->cfs_inicio_contabilizacao = agora;
+  if (delta <= 0) {
     return;
   }
+  proc->vruntime += (unsigned long)delta * CFS_PESO_NICE_0 / so_cfs_peso(proc);
+  so_cfs_atualiza_min_vruntime(self, proc);
+}
 
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
-  err_t err = proc->estado_cpu.regERRO;
+// o mínimo acompanha o menor vruntime entre o processo em execução e os
+//   prontos, mas nunca diminui
+static void so_cfs_atualiza_min_vruntime(so_t *self, processo_t *proc_atual)
+{
+  unsigned long menor = 0;
+  bool tem = false;
+  if (proc_atual != NULL && proc_atual->estado == EXECUTANDO) {
+    menor = proc_atual->vruntime;
+    tem = true;
+  }
+  int primeiro = fprio_primeiro(self->prontos_prio);
+  if (primeiro != -1) {
+    unsigned long v = so_proc(self, primeiro)->vruntime;
+    if (!tem || v < menor) menor = v;
+    tem = true;
+  }
+  if (tem && menor > self->cfs_min_vruntime) {
+    self->cfs_min_vruntime = menor;
+  }
+}
 
-  if (err == ERR_PAG_AUSENTE) {
-    if (so_atende_falta_pagina(self, proc)) {
-      return;
-    }
-    console_printf("SO: Processo %d acessou endereco virtual invalido (%d). Processo terminado.",
-                   proc->pid, proc->estado_cpu.complemento);
-  } else if (err == ERR_END_INV) {
-    console_printf("SO: Erro interno: endereco fisico invalido durante traducao (proc %d, complemento %d)",
-                   proc->pid, proc->estado_cpu.complemento);
-    self->erro_interno = true;
-  } else {
-    console_printf("SO: Erro na CPU (processo %d): %s. Processo terminado.",
-                   proc->pid, err_nome(err));
+// um processo que passou muito tempo bloqueado não pode voltar com um
+//   vruntime tão baixo que monopolize a CPU: entra no máximo meia latência
+//   antes do mínimo atual
+static void so_cfs_posiciona_acordado(so_t *self, processo_t *proc)
+{
+  unsigned long credito = (unsigned long)CONFIG_CFS_LATENCIA * INTERVALO_INTERRUPCAO / 2;
+  unsigned long piso = self->cfs_min_vruntime > credito ? self->cfs_min_vruntime - credito : 0;
+  if (proc->vruntime < piso) {
+    proc->vruntime = piso;
   }
+}
 
-  so_atualiza_estado(self, proc, LIVRE); // Marca para reutilização
-  so_proc_liberacao_recursos(self, proc);
+// fatia de tempo (em interrupções de relógio) do processo: a parte da
+//   latência alvo proporcional ao seu peso entre os processos executáveis
+static int so_cfs_fatia(so_t *self, processo_t *proc)
+{
+  long soma_pesos = self->cfs_soma_pesos;
+  if (soma_pesos <= 0) {
+    return CONFIG_CFS_LATENCIA;
+  }
+  int fatia = (int)((long)CONFIG_CFS_LATENCIA * so_cfs_peso(proc) / soma_pesos);
+  return fatia < CONFIG_CFS_FATIA_MINIMA ? CONFIG_CFS_FATIA_MINIMA : fatia;
 }
 
-// interrupção gerada quando o timer expira
-static void so_trata_irq_relogio(so_t *self)
+static processo_t *so_cfs_trata_processo_atual(so_t *self, processo_t *proc_atual)
 {
-  // rearma o interruptor do relógio e reinicializa o timer para a próxima interrupção
-  err_t e1, e2;
-  e1 = es_escreve(self->es, D_RELOGIO_INTERRUPCAO, 0); // desliga o sinalizador de interrupção
-  e2 = es_escreve(self->es, D_RELOGIO_TIMER, INTERVALO_INTERRUPCAO);
-  if (e1 != ERR_OK || e2 != ERR_OK) {
-    console_printf("SO: problema da reinicialização do timer");
-    self->erro_interno = true;
+  if (proc_atual == NULL) {
+    return NULL;
   }
 
-  // --- Lógica de Quantum (Parte III) ---
-  if (self->processo_em_execucao_idx != -1) {
-    self->quantum_restante--;
-    if (self->quantum_restante == 0) {
-      processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
+  if (proc_atual->estado != EXECUTANDO) {
+    self->processo_em_execucao_idx = -1;
+    return NULL;
+  }
 
-      console_printf("SO: Quantum do processo %d estourou (Preempção)", proc->pid);
-      self->deve_preemptar = true;
-    }
+  if (!self->deve_preemptar) {
+    return proc_atual;
   }
 
-  if (self->vm_estado != NULL) {
-    so_vm_atualiza_idade_quadros(self);
+  // fim da fatia, mas sem ninguém com vruntime menor: continua com outra fatia
+  int primeiro = fprio_primeiro(self->prontos_prio);
+  if (primeiro == -1 || so_proc(self, primeiro)->vruntime >= proc_atual->vruntime) {
+    self->quantum_restante = so_cfs_fatia(self, proc_atual);
+    return proc_atual;
   }
+
+  console_printf("SO: Preempção CFS do processo %d (vruntime %lu)", proc_atual->pid, proc_atual->vruntime);
+  so_registra_preempcao(self, proc_atual);
+  so_atualiza_estado(self, proc_atual, PRONTO);
+  self->processo_em_execucao_idx = -1;
+  return NULL;
 }
 
-// foi gerada uma interrupção para a qual o SO não está preparado
-static void so_trata_irq_desconhecida(so_t *self, int irq)
+static void so_cfs_escolhe_novo_processo(so_t *self)
 {
-  console_printf("SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
-  self->erro_interno = true;
-}
+  int proximo_idx = fprio_primeiro(self->prontos_prio);
+  if (proximo_idx == -1) {
+    self->processo_em_execucao_idx = -1;
+    so_registra_entrada_ociosidade(self);
+    return;
+  }
 
+  so_registra_saida_ociosidade(self);
 
-// ---------------------------------------------------------------------
-// CHAMADAS DE SISTEMA {{{1
-// ---------------------------------------------------------------------
+  processo_t *proximo_proc = so_proc(self, proximo_idx);
+  so_atualiza_estado(self, proximo_proc, EXECUTANDO);
+  self->processo_em_execucao_idx = proximo_idx;
+  self->quantum_restante = so_cfs_fatia(self, proximo_proc);
+  self->cfs_inicio_contabilizacao = so_get_tempo(self);
+  so_cfs_atualiza_min_vruntime(self, proximo_proc);
+  console_printf("SO: Escalonou %d (CFS, vruntime %lu, fatia %d)",
+                 proximo_proc->pid, proximo_proc->vruntime, self->quantum_restante);
+}
 
-// funções auxiliares para cada chamada de sistema
-static void so_chamada_le(so_t *self);
-static void so_chamada_escr(so_t *self);
-static void so_chamada_cria_proc(so_t *self);
-static void so_chamada_mata_proc(so_t *self);
-static void so_chamada_espera_proc(so_t *self);
+// Escalonadores 5 e 6: Divisão proporcional (stride e loteria)
+// cada processo tem direito a uma parte da CPU proporcional aos seus bilhetes
+// no stride, cada processo tem um passo que avança, a cada instrução executada,
+//   um tamanho inversamente proporcional aos bilhetes; executa o de menor
+//   passo, que fica no heap de prontos
+// na loteria, a cada quantum é sorteado um bilhete entre os dos prontos
 
-static void so_trata_irq_chamada_sistema(so_t *self)
+// tamanho do passo de quem tem um só bilhete; quanto maior, menor o erro de
+//   arredondamento na divisão pelos bilhetes
+#define STRIDE_PASSO_UNITARIO (1UL << 20)
+
+static void so_escalona_stride(so_t *self)
 {
-  // a identificação da chamada está no registrador A
-  // t2: com processos, o reg A deve estar no descritor do processo corrente
-  
-  if (self->processo_em_execucao_idx == -1) {
-    console_printf("SO: chamada de sistema sem processo em execução");
-    self->erro_interno = true;
-    return;
-  }
-  
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
-  int id_chamada = proc->estado_cpu.regA;
-  console_printf("SO: chamada de sistema %d", id_chamada);
-  switch (id_chamada) {
-    case SO_LE:
-      so_chamada_le(self);
+  processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
+                             ? so_proc(self, self->processo_em_execucao_idx)
+                             : NULL;
+
+  if (proc_atual != NULL) {
+    so_stride_contabiliza(self, proc_atual);
+  }
+  proc_atual = so_prop_trata_processo_atual(self, proc_atual);
+  self->deve_preemptar = false;
+
+  if (proc_atual != NULL) {
+    return;
+  }
+
+  int proximo_idx = fprio_primeiro(self->prontos_prio);
+  so_prop_executa(self, proximo_idx, "stride");
+  if (proximo_idx != -1) {
+    so_stride_atualiza_passo_minimo(self, so_proc(self, proximo_idx));
+  }
+}
+
+static void so_escalona_loteria(so_t *self)
+{
+  processo_t *proc_atual = (self->processo_em_execucao_idx != -1)
+                             ? so_proc(self, self->processo_em_execucao_idx)
+                             : NULL;
+
+  if (proc_atual != NULL) {
+    // conta o tempo para o relatório de parte da CPU, como no stride
+    so_stride_contabiliza(self, proc_atual);
+  }
+  proc_atual = so_prop_trata_processo_atual(self, proc_atual);
+  self->deve_preemptar = false;
+
+  if (proc_atual != NULL) {
+    return;
+  }
+
+  so_prop_executa(self, so_loteria_sorteia(self), "loteria");
+}
+
+static unsigned long so_stride_tamanho_passo(processo_t *proc)
+{
+  int bilhetes = proc->bilhetes > 0 ? proc->bilhetes : 1;
+  return STRIDE_PASSO_UNITARIO / bilhetes;
+}
+
+// avança o passo do processo em execução pelas instruções executadas desde a
+//   última contabilização
+static void so_stride_contabiliza(so_t *self, processo_t *proc)
+{
+  int agora = so_get_tempo(self);
+  int delta = agora - self->cfs_inicio_contabilizacao;
+  self->cfs_inicio_contabilizacao = agora;
+  if (delta <= 0) {
+    return;
+  }
+  proc->passo += (unsigned long)delta * so_stride_tamanho_passo(proc) / INTERVALO_INTERRUPCAO;
+  so_stride_atualiza_passo_minimo(self, proc);
+}
+
+static void so_stride_atualiza_passo_minimo(so_t *self, processo_t *proc_atual)
+{
+  unsigned long menor = 0;
+  bool tem = false;
+  if (proc_atual != NULL && proc_atual->estado == EXECUTANDO) {
+    menor = proc_atual->passo;
+    tem = true;
+  }
+  int primeiro = fprio_primeiro(self->prontos_prio);
+  if (primeiro != -1) {
+    unsigned long p = so_proc(self, primeiro)->passo;
+    if (!tem || p < menor) menor = p;
+    tem = true;
+  }
+  if (tem && menor > self->stride_passo_minimo) {
+    self->stride_passo_minimo = menor;
+  }
+}
+
+// quem esteve bloqueado não acumula crédito: volta no mínimo no passo mínimo
+//   atual, senão monopolizaria a CPU até alcançar os outros
+static void so_stride_posiciona_acordado(so_t *self, processo_t *proc)
+{
+  if (proc->passo < self->stride_passo_minimo) {
+    proc->passo = self->stride_passo_minimo;
+  }
+}
+
+// tratamento do processo atual comum aos dois: só perde a CPU ao bloquear ou
+//   no fim do quantum
+static processo_t *so_prop_trata_processo_atual(so_t *self, processo_t *proc_atual)
+{
+  if (proc_atual == NULL) {
+    return NULL;
+  }
+
+  if (proc_atual->estado != EXECUTANDO) {
+    self->processo_em_execucao_idx = -1;
+    return NULL;
+  }
+
+  if (!self->deve_preemptar) {
+    return proc_atual;
+  }
+
+  so_registra_preempcao(self, proc_atual);
+  so_atualiza_estado(self, proc_atual, PRONTO);
+  self->processo_em_execucao_idx = -1;
+  return NULL;
+}
+
+// coloca em execução o processo 'idx' (ou entra em ociosidade se -1)
+static void so_prop_executa(so_t *self, int idx, const char *politica)
+{
+  if (idx == -1) {
+    self->processo_em_execucao_idx = -1;
+    so_registra_entrada_ociosidade(self);
+    return;
+  }
+
+  so_registra_saida_ociosidade(self);
+
+  processo_t *proc = so_proc(self, idx);
+  so_atualiza_estado(self, proc, EXECUTANDO);
+  self->processo_em_execucao_idx = idx;
+  so_concede_quantum(self, proc);
+  self->cfs_inicio_contabilizacao = so_get_tempo(self);
+  console_printf("SO: Escalonou %d (%s, %d bilhetes)", proc->pid, politica, proc->bilhetes);
+}
+
+// sorteia um bilhete entre os dos processos prontos; retorna o índice do dono
+//   ou -1 se não há prontos
+static int so_loteria_sorteia(so_t *self)
+{
+  long total = self->loteria_bilhetes;
+  if (total <= 0) {
+    return -1;
+  }
+  long sorteado = rand_r(&self->loteria_semente) % total;
+  for (int i = self->vivos_primeiro; i != -1; i = so_proc(self, i)->vivo_prox) {
+    processo_t *p = so_proc(self, i);
+    if (p->estado != PRONTO || p->tempo_real) continue;
+    if (sorteado < p->bilhetes) return i;
+    sorteado -= p->bilhetes;
+  }
+  return -1;
+}
+
+// Classe de tempo real: EDF (prazo mais cedo primeiro)
+// os processos que declararam período, orçamento e prazo com SO_TEMPO_REAL
+//   ficam fora da classe do escalonador configurado: executam antes de
+//   qualquer outro, o de data limite mais cedo primeiro, e em cada período só
+//   têm direito ao seu orçamento de CPU; quem gasta o orçamento antes de
+//   terminar o trabalho espera o período seguinte
+
+// trata o processo de tempo real que estava em execução; retorna true se ele
+//   continua executando
+static bool so_edf_trata_processo_atual(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) {
+    return false;
+  }
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  if (!proc->tempo_real) {
+    return false;
+  }
+
+  if (proc->estado == EXECUTANDO) {
+    int primeiro = fprio_primeiro(self->prontos_rt);
+    if (proc->rt_restante <= 0) {
+      console_printf("SO: EDF: processo %d gastou o orçamento do período", proc->pid);
+      proc->rt_esgotamentos++;
+      so_edf_espera_periodo(self, proc);
+    } else if (primeiro != -1 && so_proc(self, primeiro)->rt_prazo_abs < proc->rt_prazo_abs) {
+      console_printf("SO: EDF: processo %d preemptado pelo %d, de prazo mais cedo",
+                     proc->pid, so_proc(self, primeiro)->pid);
+      so_registra_preempcao(self, proc);
+      so_atualiza_estado(self, proc, PRONTO);
+    } else {
+      self->deve_preemptar = false;
+      return true;
+    }
+  }
+
+  self->processo_em_execucao_idx = -1;
+  self->deve_preemptar = false;
+  return false;
+}
+
+// coloca em execução o processo de tempo real pronto de prazo mais cedo, no
+//   lugar do processo normal que estiver em execução; retorna false se não há
+//   nenhum pronto
+static bool so_edf_escolhe(so_t *self)
+{
+  int idx = fprio_primeiro(self->prontos_rt);
+  if (idx == -1) {
+    return false;
+  }
+  if (self->processo_em_execucao_idx != -1) {
+    so_edf_devolve_atual(self);
+  }
+
+  so_registra_saida_ociosidade(self);
+
+  processo_t *proc = so_proc(self, idx);
+  so_atualiza_estado(self, proc, EXECUTANDO);
+  self->processo_em_execucao_idx = idx;
+  // o orçamento faz o papel do quantum
+  self->quantum_concedido = 1;
+  self->quantum_restante = 0;
+  self->edf_inicio_contabilizacao = so_get_tempo(self);
+  console_printf("SO: Escalonou %d (EDF, prazo %d, orçamento restante %d)",
+                 proc->pid, proc->rt_prazo_abs, proc->rt_restante);
+  return true;
+}
+
+// tira da CPU o processo normal que estava em execução (ou que acabou de sair
+//   dela), para dar lugar a um de tempo real; a classe dele faz a sua
+//   contabilidade como num fim de quantum
+static void so_edf_devolve_atual(so_t *self)
+{
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  processo_t *continua;
+  self->deve_preemptar = proc->estado == EXECUTANDO;
+  switch (self->escalonador_atual) {
+    case ESCAL_CIRCULAR:
+      continua = so_rr_verifica_processo_atual(self, so_rr_trata_preempcao(self, proc));
       break;
-    case SO_ESCR:
-      so_chamada_escr(self);
+    case ESCAL_MLFQ:
+      continua = so_mlfq_trata_processo_atual(self, proc);
       break;
-    case SO_CRIA_PROC:
-      so_chamada_cria_proc(self);
+    case ESCAL_CFS:
+      so_cfs_contabiliza(self, proc);
+      continua = so_cfs_trata_processo_atual(self, proc);
       break;
-    case SO_MATA_PROC:
-      so_chamada_mata_proc(self);
+    case ESCAL_STRIDE:
+    case ESCAL_LOTERIA:
+      so_stride_contabiliza(self, proc);
+      continua = so_prop_trata_processo_atual(self, proc);
       break;
-    case SO_ESPERA_PROC:
-      so_chamada_espera_proc(self);
+    case ESCAL_PRIORIDADE:
+    default:
+      continua = so_prio_trata_processo_atual(self, proc);
+      break;
+  }
+  // o CFS mantém o processo se não há outro com vruntime menor
+  if (continua != NULL) {
+    so_registra_preempcao(self, proc);
+    so_atualiza_estado(self, proc, PRONTO);
+  }
+  if (proc->estado == PRONTO) {
+    console_printf("SO: EDF: processo %d preemptado por processo de tempo real", proc->pid);
+  }
+  self->processo_em_execucao_idx = -1;
+  self->deve_preemptar = false;
+}
+
+// desconta do orçamento o que o processo de tempo real em execução gastou
+//   desde a última contabilização
+static void so_edf_contabiliza(so_t *self, processo_t *proc)
+{
+  int agora = so_get_tempo(self);
+  proc->rt_restante -= agora - self->edf_inicio_contabilizacao;
+  self->edf_inicio_contabilizacao = agora;
+}
+
+// começa, em 'inicio', o período e o trabalho seguintes
+static void so_edf_inicia_periodo(processo_t *proc, int inicio)
+{
+  proc->rt_liberacao = inicio;
+  proc->rt_prazo_abs = inicio + proc->rt_prazo;
+  proc->rt_restante = proc->rt_orcamento;
+}
+
+// passa ao período seguinte, com o orçamento renovado; se o trabalho anterior
+//   terminou começa outro, se não ele continua, com a data limite que tinha
+static void so_edf_proximo_periodo(processo_t *proc)
+{
+  if (proc->rt_prazo_abs == -1) {
+    so_edf_inicia_periodo(proc, proc->rt_liberacao + proc->rt_periodo);
+  } else {
+    proc->rt_liberacao += proc->rt_periodo;
+    proc->rt_restante = proc->rt_orcamento;
+  }
+}
+
+// bloqueia o processo até o início do seu próximo período
+static void so_edf_espera_periodo(so_t *self, processo_t *proc)
+{
+  proc->motivo_bloqueio = BLOQUEIO_PERIODO;
+  proc->tempo_desbloqueio = proc->rt_liberacao + proc->rt_periodo;
+  proc->pid_esperado = -1;
+  proc->dispositivo_esperado = -1;
+  so_atualiza_estado(self, proc, BLOQUEADO);
+  so_espera_insere(self, proc);
+}
+
+// teste de admissão: a soma das densidades (orçamento / prazo) dos processos
+//   de tempo real, com o pedido novo no lugar do atual de 'proc', não pode
+//   passar de CONFIG_EDF_UTILIZACAO_MAXIMA; com prazos iguais aos períodos é a
+//   condição exata para o EDF cumprir todos os prazos, com prazos menores é
+//   suficiente
+static bool so_edf_admite(so_t *self, processo_t *proc, int orcamento, int prazo)
+{
+  long soma = (long)orcamento * 1000 / prazo;
+  for (int i = self->vivos_primeiro; i != -1; i = so_proc(self, i)->vivo_prox) {
+    processo_t *p = so_proc(self, i);
+    if (p == proc || !p->tempo_real || p->estado == LIVRE || p->estado == TERMINADO) {
+      continue;
+    }
+    soma += (long)p->rt_orcamento * 1000 / p->rt_prazo;
+  }
+  return soma <= CONFIG_EDF_UTILIZACAO_MAXIMA * 10;
+}
+
+// contabiliza um trabalho terminado em 'agora': conta a perda de prazo e põe
+//   o atraso (em ticks, arredondado para cima) na sua faixa do histograma
+static void so_edf_registra_fim_trabalho(processo_t *proc, int agora)
+{
+  int atraso = agora - proc->rt_prazo_abs;
+  int faixa = 0;
+  proc->rt_trabalhos++;
+  if (atraso > 0) {
+    proc->rt_perdas++;
+    int ticks = (atraso + INTERVALO_INTERRUPCAO - 1) / INTERVALO_INTERRUPCAO;
+    faixa = 1;
+    while (ticks > 1 && faixa < RT_FAIXAS_ATRASO - 1) {
+      ticks /= 2;
+      faixa++;
+    }
+  }
+  proc->rt_atrasos[faixa]++;
+}
+
+// Quantum adaptativo
+// observa como o processo que está saindo da CPU usou o quantum: quem gasta o
+//   quantum inteiro (limitado pela CPU) recebe o dobro, para trocar menos de
+//   contexto; quem bloqueia para E/S antes recebe um quantum perto da sua
+//   rajada média, e como usa pouco do quantum tem prioridade melhor
+static void so_adapta_quantum(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) {
+    return;
+  }
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  bool preemptado = proc->estado == EXECUTANDO && self->deve_preemptar;
+  bool bloqueou_es = so_bloqueado_por_es(proc);
+  if (!preemptado && !bloqueou_es) {
+    return;
+  }
+  int rajada = so_get_tempo(self) - proc->inicio_rajada;
+  proc->rajada_media = (proc->rajada_media + rajada) / 2;
+#ifdef CONFIG_QUANTUM_ADAPTATIVO
+  int quantum;
+  if (preemptado) {
+    quantum = proc->quantum * 2;
+  } else {
+    quantum = proc->rajada_media / INTERVALO_INTERRUPCAO + 1;
+  }
+  if (quantum < CONFIG_QUANTUM_MINIMO) quantum = CONFIG_QUANTUM_MINIMO;
+  if (quantum > CONFIG_QUANTUM_MAXIMO) quantum = CONFIG_QUANTUM_MAXIMO;
+  if (quantum != proc->quantum) {
+    console_printf("SO: Quantum do processo %d passa de %d para %d", proc->pid, proc->quantum, quantum);
+    proc->quantum = quantum;
+  }
+#endif
+}
+
+// quantum a dar ao processo que vai executar: o dele, limitado para que cada
+//   um dos outros prontos espere no máximo CONFIG_ALVO_RESPOSTA
+static void so_concede_quantum(so_t *self, processo_t *proc)
+{
+  int quantum = self->quantum_total;
+#ifdef CONFIG_QUANTUM_ADAPTATIVO
+  quantum = proc->quantum;
+  int outros_prontos = self->num_prontos;
+  if (outros_prontos > 0) {
+    int limite = CONFIG_ALVO_RESPOSTA / outros_prontos;
+    if (limite < CONFIG_QUANTUM_MINIMO) limite = CONFIG_QUANTUM_MINIMO;
+    if (quantum > limite) quantum = limite;
+  }
+#endif
+  self->quantum_concedido = quantum;
+  self->quantum_restante = quantum;
+  proc->soma_quanta += quantum;
+}
+
+static void so_escalona(so_t *self)
+{
+  so_adapta_quantum(self);
+
+  // a classe de tempo real tem precedência sobre a do escalonador configurado
+  if (so_edf_trata_processo_atual(self) || so_edf_escolhe(self)) {
+    return;
+  }
+
+  // Despacha para o escalonador configurado
+  switch (self->escalonador_atual) {
+    case ESCAL_CIRCULAR:
+      so_escalona_rr(self);
       break;
+    case ESCAL_MLFQ:
+      so_escalona_mlfq(self);
+      break;
+    case ESCAL_CFS:
+      so_escalona_cfs(self);
+      break;
+    case ESCAL_STRIDE:
+      so_escalona_stride(self);
+      break;
+    case ESCAL_LOTERIA:
+      so_escalona_loteria(self);
+      break;
+    case ESCAL_PRIORIDADE:
     default:
-      console_printf("SO: Processo %d fez chamada de sistema desconhecida (%d). Processo será terminado.",
-                     proc->pid, id_chamada);
-      // Mata o processo por chamada inválida
-      so_atualiza_estado(self, proc, TERMINADO); // ou LIVRE, se preferir
-      so_proc_liberacao_recursos(self, proc);
-      // Nota: Não podemos chamar so_chamada_mata_proc() daqui
-      // porque ela pode acordar outros processos, e o chamador
-      // (proc) já está sendo "morto" de forma especial.
-      // O escalonador vai tirar ele de execução.
-      break; // Sai do switch
+      so_escalona_prio(self);
+      break;
+  }
+}
+
+static int so_despacha(so_t *self)
+{
+  // Se não houver processo para executar, retorna 1 (HALT)
+  if (self->processo_em_execucao_idx == -1) {
+    if (!self->cpu_em_halt) {
+      console_printf("SO: Nenhum processo pronto. CPU em HALT.");
+      self->cpu_em_halt = true;
+    }
+    return 1; // Diz ao trata_int.asm para executar PARA
+  }
+
+  // Obtém o ponteiro para o PCB do processo que vai executar
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+
+  self->cpu_em_halt = false;
+  if (self->processo_em_execucao_idx != self->ultimo_despachado_idx) {
+    self->metricas.num_trocas_contexto++;
+    self->ultimo_despachado_idx = self->processo_em_execucao_idx;
+  }
+
+  // Escreve os registradores do PCB para a memória
+  if (mem_escreve(self->mem, CPU_END_A, proc->estado_cpu.regA) != ERR_OK
+      || mem_escreve(self->mem, CPU_END_PC, proc->estado_cpu.regPC) != ERR_OK
+      || mem_escreve(self->mem, CPU_END_erro, proc->estado_cpu.regERRO) != ERR_OK
+      || mem_escreve(self->mem, 59, proc->estado_cpu.regX) != ERR_OK
+      || mem_escreve(self->mem, CPU_END_complemento, proc->estado_cpu.complemento) != ERR_OK) {
+    console_printf("SO: erro na escrita dos registradores do PCB");
+    self->erro_interno = true;
+    return 1; // Erro, melhor parar
+  }
+
+  // põe em dia as idades das páginas do processo, que não foram envelhecidas
+  //   enquanto ele não executava
+  processo_t *espaco = so_vm_espaco(self, proc);
+  so_vm_envelhece_processo(self, espaco, false);
+
+  // define a tabela de páginas para o processo atual; entre threads do mesmo
+  //   processo a tabela é a mesma, e a MMU não precisa ser alterada
+  if (espaco->tabela_paginas != self->tabpag_na_mmu) {
+    so_mmu_define_tabpag(self, espaco->tabela_paginas);
+    self->metricas_vm.trocas_espaco++;
+  }
+
+  return 0; // Diz ao trata_int.asm para executar RETI
+}
+
+
+// ---------------------------------------------------------------------
+// TRATAMENTO DE UMA IRQ {{{1
+// ---------------------------------------------------------------------
+
+// funções auxiliares para tratar cada tipo de interrupção
+static void so_trata_reset(so_t *self);
+static void so_trata_irq_chamada_sistema(so_t *self);
+static void so_trata_irq_err_cpu(so_t *self);
+static void so_trata_irq_relogio(so_t *self);
+static void so_trata_irq_terminal(so_t *self);
+static void so_trata_irq_disco(so_t *self);
+static void so_trata_irq_desconhecida(so_t *self, int irq);
+
+static void so_trata_irq(so_t *self, int irq)
+{
+  // --- Métricas (Parte III) ---
+  if (irq >= 0 && irq < N_IRQ) {
+    self->metricas.num_irq[irq]++;
+  }
+  // --- Fim Métricas ---
+
+  // verifica o tipo de interrupção que está acontecendo, e atende de acordo
+  switch (irq) {
+    case IRQ_RESET:
+      so_trata_reset(self);
+      break;
+    case IRQ_SISTEMA:
+      so_trata_irq_chamada_sistema(self);
+      break;
+    case IRQ_ERR_CPU:
+      so_trata_irq_err_cpu(self);
+      break;
+    case IRQ_RELOGIO:
+      so_trata_irq_relogio(self);
+      break;
+    case IRQ_TERMINAL:
+      so_trata_irq_terminal(self);
+      break;
+    case IRQ_DISCO:
+      so_trata_irq_disco(self);
+      break;
+    default:
+      so_trata_irq_desconhecida(self, irq);
+  }
+}
+
+// chamada uma única vez, quando a CPU inicializa
+static void so_trata_reset(so_t *self)
+{
+  // coloca o tratador de interrupção na memória
+  // quando a CPU aceita uma interrupção, passa para modo supervisor,
+  //   salva seu estado à partir do endereço CPU_END_PC, e desvia para o
+  //   endereço CPU_END_TRATADOR
+  // colocamos no endereço CPU_END_TRATADOR o programa de tratamento
+  //   de interrupção (escrito em asm). esse programa deve conter a
+  //   instrução CHAMAC, que vai chamar so_trata_interrupcao (como
+  //   foi definido na inicialização do SO)
+  int ender = so_carrega_programa(self, "trata_int.maq", NULL);
+  if (ender != CPU_END_TRATADOR) {
+    console_printf("SO: problema na carga do programa de tratamento de interrupcao");
+    self->erro_interno = true;
+  }
+
+  // o primeiro tick é após INTERVALO_INTERRUPCAO; o timer é programado na
+  //   saída do SO (so_relogio_programa)
+  self->proximo_tick = so_get_tempo(self) + INTERVALO_INTERRUPCAO;
+
+  // coloca o programa init na memória
+  int pid_init = self->proximo_pid;
+  int idx_init = so_proc_aloca(self);
+  if (idx_init < 0) {
+    console_printf("SO: sem descritor para o processo inicial");
+    self->erro_interno = true;
+    return;
+  }
+  processo_t *proc_init = so_proc(self, idx_init);
+  so_proc_inicializa_vm(self, proc_init);
+  so_proc_ativa(self, proc_init, pid_init);
+
+  ender = so_carrega_programa(self, CONFIG_PROGRAMA_INICIAL, proc_init);
+  if (ender < 0) {
+    console_printf("SO: problema na carga do programa inicial '%s'", CONFIG_PROGRAMA_INICIAL);
+    self->erro_interno = true;
+    return;
+  }
+
+  // Cria o primeiro processo (init)
+  so_inicializa_metricas_processo(self, proc_init, pid_init, ender);
+  self->proximo_pid = pid_init + 1;
+  proc_init->terminal = D_TERM_A; // Processo 0 usa o Terminal A
+
+  // Adiciona na fila de prontos (para RR)
+  // (Implementaremos a fila no próximo prompt, por enquanto só adicionamos)
+  so_insere_novo_em_pronto(self, idx_init);
+
+  // A interrupção do BIOS não define um processo_em_execucao_idx.
+  // O escalonador será chamado pela primeira vez ao fim de
+  // so_trata_interrupcao e vai selecionar este processo.
+}
+
+// interrupção gerada quando a CPU identifica um erro
+static void so_trata_irq_err_cpu(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) {
+    // Erro de CPU sem processo (ex: durante o boot, antes do init)
+    // Isso é um erro fatal do sistema.
+    console_printf("SO: IRQ de erro fatal na CPU (sem processo corrente)!");
+    self->erro_interno = true; // Para a simulação
+    return;
+  }
+
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  err_t err = proc->estado_cpu.regERRO;
+
+  if (err == ERR_PAG_AUSENTE) {
+    if (so_atende_falta_pagina(self, proc)) {
+      return;
+    }
+    console_printf("SO: Processo %d acessou endereco virtual invalido (%d). Processo terminado.",
+                   proc->pid, proc->estado_cpu.complemento);
+  } else if (err == ERR_PAG_PROTEGIDA) {
+    if (so_atende_protecao_pagina(self, proc)) {
+      return;
+    }
+    console_printf("SO: Processo %d escreveu em página protegida (%d). Processo terminado.",
+                   proc->pid, proc->estado_cpu.complemento);
+  } else if (err == ERR_END_INV) {
+    console_printf("SO: Erro interno: endereco fisico invalido durante traducao (proc %d, complemento %d)",
+                   proc->pid, proc->estado_cpu.complemento);
+    self->erro_interno = true;
+  } else {
+    console_printf("SO: Erro na CPU (processo %d): %s. Processo terminado.",
+                   proc->pid, err_nome(err));
+  }
+
+  so_atualiza_estado(self, proc, LIVRE); // Marca para reutilização
+  so_proc_liberacao_recursos(self, proc);
+}
+
+// interrupção gerada por um terminal que recebeu entrada ou ficou pronto para
+//   saída: só os terminais e sentidos que pediram a interrupção são atendidos
+//   (o buffer de saída escoado, e a fila de espera correspondente consultada)
+static void so_trata_irq_terminal(so_t *self)
+{
+  int pendentes;
+  if (es_le(self->es, D_TERM_INTERRUPCAO, &pendentes) != ERR_OK
+      || es_escreve(self->es, D_TERM_INTERRUPCAO, pendentes) != ERR_OK) {
+    console_printf("SO: problema no acesso às interrupções dos terminais");
+    self->erro_interno = true;
+    return;
+  }
+  unsigned int mapa = pendentes;
+  while (mapa != 0) {
+    int bit = __builtin_ctz(mapa);
+    mapa &= mapa - 1;
+    if (bit % 2 == 1) {
+      so_saida_escoa(self, bit / 2);
+    }
+  }
+  so_espera_atende_terminais(self, pendentes);
+}
+
+// interrupção gerada pelo disco no fim de uma operação: o bloco lido é
+//   copiado para a cache, os processos que esperavam por ele (ou por uma
+//   entrada da cache) são desbloqueados, e a próxima operação é iniciada
+static void so_trata_irq_disco(so_t *self)
+{
+  int estado;
+  if (es_escreve(self->es, D_DISCO_INTERRUPCAO, 0) != ERR_OK
+      || es_le(self->es, D_DISCO_COMANDO, &estado) != ERR_OK) {
+    console_printf("SO: problema no acesso ao disco");
+    self->erro_interno = true;
+    return;
+  }
+  if (self->disco_op == 0) {
+    return;
+  }
+  cache_bloco_t *ent = &self->cache_disco[self->disco_entrada];
+  int bloco = -1;
+  if (self->disco_op == DISCO_LE) {
+    bloco = ent->bloco;
+    for (int i = 0; i < DISCO_TAM_BLOCO; i++) {
+      if (es_le(self->es, D_DISCO_DADO, &ent->dados[i]) != ERR_OK) {
+        estado = -1;
+        break;
+      }
+    }
+    ent->estado = CACHE_VALIDO;
+    self->metricas.disco_leituras++;
+  } else {
+    // a entrada pode já ter sido reusada: o conteúdo foi para o disco no
+    //   início da gravação
+    self->metricas.disco_gravacoes++;
+  }
+  if (estado < 0) {
+    console_printf("SO: erro do disco na %s de um bloco",
+                   self->disco_op == DISCO_LE ? "leitura" : "gravação");
+    self->erro_interno = true;
+  }
+  self->disco_op = 0;
+  self->disco_entrada = -1;
+
+  int agora = so_get_tempo(self);
+  int idx_proc = self->espera_disco.primeiro;
+  while (idx_proc != -1) {
+    processo_t *proc = so_proc(self, idx_proc);
+    int proximo = proc->espera_prox;
+    if (proc->dispositivo_esperado == bloco || proc->dispositivo_esperado == -1) {
+      int espera = agora - proc->disco_inicio_espera;
+      proc->disco_esperas++;
+      proc->disco_tempo_espera += espera;
+      self->metricas.disco_esperas++;
+      self->metricas.disco_tempo_espera += espera;
+      so_atualiza_estado(self, proc, PRONTO);
+      proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+      so_insere_em_pronto(self, idx_proc);
+      console_printf("SO: Processo %d desbloqueado pelo disco", proc->pid);
+    }
+    idx_proc = proximo;
+  }
+
+  so_disco_inicia(self);
+}
+
+// interrupção gerada quando o timer expira
+static void so_trata_irq_relogio(so_t *self)
+{
+  // desliga o sinalizador de interrupção; os ticks que passaram já foram
+  //   contabilizados na entrada do SO, e o timer é reprogramado na saída
+  if (es_escreve(self->es, D_RELOGIO_INTERRUPCAO, 0) != ERR_OK) {
+    console_printf("SO: problema da reinicialização do timer");
+    self->erro_interno = true;
+  }
+}
+
+// o SO trabalha com ticks de INTERVALO_INTERRUPCAO instruções (quantum,
+//   envelhecimento, elevação do MLFQ), mas o timer não é programado para
+//   interromper a cada tick: os ticks que passaram desde a última entrada no
+//   SO são contabilizados aqui, de uma vez, em qualquer interrupção
+static void so_relogio_contabiliza_ticks(so_t *self)
+{
+  // o orçamento de um processo de tempo real é descontado em qualquer
+  //   interrupção, não só nos ticks
+  if (self->processo_em_execucao_idx != -1
+      && so_proc(self, self->processo_em_execucao_idx)->tempo_real) {
+    so_edf_contabiliza(self, so_proc(self, self->processo_em_execucao_idx));
+  }
+
+  int agora = so_get_tempo(self);
+  if (agora < self->proximo_tick) {
+    return;
+  }
+  int ticks = (agora - self->proximo_tick) / INTERVALO_INTERRUPCAO + 1;
+  self->proximo_tick += ticks * INTERVALO_INTERRUPCAO;
+  self->metricas.num_ticks += ticks;
+
+  // --- Lógica de Quantum (Parte III) ---
+  if (self->processo_em_execucao_idx != -1 && self->quantum_restante > 0) {
+    self->quantum_restante -= ticks;
+    if (self->quantum_restante <= 0) {
+      self->quantum_restante = 0;
+      processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+
+      console_printf("SO: Quantum do processo %d estourou (Preempção)", proc->pid);
+      self->deve_preemptar = true;
+      if (self->escalonador_atual == ESCAL_MLFQ) {
+        so_mlfq_fim_de_quantum(self, proc);
+      }
+    }
+  }
+
+  if (self->escalonador_atual == ESCAL_MLFQ) {
+    self->mlfq_ticks_desde_elevacao += ticks;
+    if (self->mlfq_ticks_desde_elevacao >= CONFIG_MLFQ_INTERVALO_ELEVACAO) {
+      self->mlfq_ticks_desde_elevacao = 0;
+      so_mlfq_eleva_todos(self);
+    }
+  }
+
+  so_vm_atualiza_idade_quadros(self, ticks);
+}
+
+// programa o timer para o próximo evento que precisa do SO
+// sem CONFIG_RELOGIO_SEM_TICK, é sempre o próximo tick; com, é o primeiro entre:
+// - fim do quantum do processo em execução, se há outro pronto para executar
+// - prazo de envelhecimento das páginas do processo em execução
+// - elevação periódica do MLFQ
+// - o menor prazo na roda de temporização (transferências de página e início
+//   de períodos de tempo real)
+// - fim do orçamento do processo de tempo real em execução
+// - fim do atraso da gravação de um bloco alterado na cache, com o disco livre
+// os terminais e o disco avisam por interrupção, e não precisam do timer
+// sem nenhum evento, o timer fica desligado
+static void so_relogio_programa(so_t *self)
+{
+  int agora = so_get_tempo(self);
+  int alvo = -1;
+#ifndef CONFIG_RELOGIO_SEM_TICK
+  alvo = self->proximo_tick;
+#else
+  int ultimo_tick = self->proximo_tick - INTERVALO_INTERRUPCAO;
+  bool executando = self->processo_em_execucao_idx != -1;
+  bool tem_pronto = self->num_prontos > 0;
+  alvo = so_roda_proximo_prazo(self);
+  int ticks_ate = -1; // em ticks a partir do último, o evento de tick mais próximo
+  if (executando && tem_pronto && self->quantum_restante > 0
+      && (ticks_ate == -1 || self->quantum_restante < ticks_ate)) {
+    ticks_ate = self->quantum_restante;
+  }
+  if (executando && (ticks_ate == -1 || CONFIG_RELOGIO_TICKS_ENVELHECIMENTO < ticks_ate)) {
+    ticks_ate = CONFIG_RELOGIO_TICKS_ENVELHECIMENTO;
+  }
+  if (self->escalonador_atual == ESCAL_MLFQ && (executando || tem_pronto)) {
+    int faltam = CONFIG_MLFQ_INTERVALO_ELEVACAO - self->mlfq_ticks_desde_elevacao;
+    if (ticks_ate == -1 || faltam < ticks_ate) ticks_ate = faltam;
+  }
+  if (ticks_ate != -1) {
+    int t = ultimo_tick + ticks_ate * INTERVALO_INTERRUPCAO;
+    if (alvo == -1 || t < alvo) alvo = t;
+  }
+  if (executando && so_proc(self, self->processo_em_execucao_idx)->tempo_real) {
+    int t = agora + so_proc(self, self->processo_em_execucao_idx)->rt_restante;
+    if (alvo == -1 || t < alvo) alvo = t;
+  }
+  int gravacao = so_disco_proxima_gravacao(self);
+  if (gravacao != -1 && (alvo == -1 || gravacao < alvo)) alvo = gravacao;
+#endif
+  int intervalo = 0; // 0 desliga o timer
+  if (alvo != -1) {
+    intervalo = alvo > agora ? alvo - agora : 1;
+  }
+  if (es_escreve(self->es, D_RELOGIO_TIMER, intervalo) != ERR_OK) {
+    console_printf("SO: problema na programação do timer");
+    self->erro_interno = true;
+  }
+}
+
+// foi gerada uma interrupção para a qual o SO não está preparado
+static void so_trata_irq_desconhecida(so_t *self, int irq)
+{
+  console_printf("SO: não sei tratar IRQ %d (%s)", irq, irq_nome(irq));
+  self->erro_interno = true;
+}
+
+
+// ---------------------------------------------------------------------
+// CHAMADAS DE SISTEMA {{{1
+// ---------------------------------------------------------------------
+
+// funções auxiliares para cada chamada de sistema
+static void so_chamada_le(so_t *self);
+static void so_chamada_escr(so_t *self);
+static void so_chamada_escr_buf(so_t *self);
+static void so_chamada_le_buf(so_t *self, bool linha);
+static void so_chamada_abre(so_t *self);
+static void so_chamada_fecha(so_t *self);
+static void so_chamada_sel(so_t *self, bool entrada);
+static void so_arq_chamada_le(so_t *self, processo_t *proc);
+static void so_arq_chamada_escr(so_t *self, processo_t *proc);
+static void so_arq_chamada_escr_buf(so_t *self, processo_t *proc, int ender, int tam);
+static void so_arq_chamada_le_buf(so_t *self, processo_t *proc, int ender, int max, bool linha);
+static void so_chamada_cria_proc(so_t *self, bool com_bilhetes);
+static void so_chamada_mata_proc(so_t *self);
+static void so_chamada_espera_proc(so_t *self);
+static void so_chamada_sbrk(so_t *self);
+static void so_chamada_tempo_real(so_t *self);
+static void so_chamada_fim_periodo(so_t *self);
+static void so_chamada_fork(so_t *self);
+static void so_chamada_cria_thread(so_t *self);
+
+static void so_trata_irq_chamada_sistema(so_t *self)
+{
+  // a identificação da chamada está no registrador A
+  // t2: com processos, o reg A deve estar no descritor do processo corrente
+  
+  if (self->processo_em_execucao_idx == -1) {
+    console_printf("SO: chamada de sistema sem processo em execução");
+    self->erro_interno = true;
+    return;
+  }
+  
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int id_chamada = proc->estado_cpu.regA;
+  console_printf("SO: chamada de sistema %d", id_chamada);
+  switch (id_chamada) {
+    case SO_LE:
+      so_chamada_le(self);
+      break;
+    case SO_ESCR:
+      so_chamada_escr(self);
+      break;
+    case SO_ESCR_BUF:
+      so_chamada_escr_buf(self);
+      break;
+    case SO_LE_LINHA:
+      so_chamada_le_buf(self, true);
+      break;
+    case SO_LE_BUF:
+      so_chamada_le_buf(self, false);
+      break;
+    case SO_ABRE:
+      so_chamada_abre(self);
+      break;
+    case SO_FECHA:
+      so_chamada_fecha(self);
+      break;
+    case SO_SEL_LE:
+      so_chamada_sel(self, true);
+      break;
+    case SO_SEL_ESCR:
+      so_chamada_sel(self, false);
+      break;
+    case SO_CRIA_PROC:
+      so_chamada_cria_proc(self, false);
+      break;
+    case SO_CRIA_PROC_BILH:
+      so_chamada_cria_proc(self, true);
+      break;
+    case SO_MATA_PROC:
+      so_chamada_mata_proc(self);
+      break;
+    case SO_ESPERA_PROC:
+      so_chamada_espera_proc(self);
+      break;
+    case SO_SBRK:
+      so_chamada_sbrk(self);
+      break;
+    case SO_TEMPO_REAL:
+      so_chamada_tempo_real(self);
+      break;
+    case SO_FIM_PERIODO:
+      so_chamada_fim_periodo(self);
+      break;
+    case SO_FORK:
+      so_chamada_fork(self);
+      break;
+    case SO_CRIA_THREAD:
+      so_chamada_cria_thread(self);
+      break;
+    default:
+      console_printf("SO: Processo %d fez chamada de sistema desconhecida (%d). Processo será terminado.",
+                     proc->pid, id_chamada);
+      // Mata o processo por chamada inválida
+      so_atualiza_estado(self, proc, TERMINADO); // ou LIVRE, se preferir
+      so_proc_liberacao_recursos(self, proc);
+      // Nota: Não podemos chamar so_chamada_mata_proc() daqui
+      // porque ela pode acordar outros processos, e o chamador
+      // (proc) já está sendo "morto" de forma especial.
+      // O escalonador vai tirar ele de execução.
+      break; // Sai do switch
+  }
+}
+
+// implementação da chamada se sistema SO_LE
+// faz a leitura de um dado da entrada corrente do processo, coloca o dado no reg A
+static void so_chamada_le(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int term = proc->terminal;
+
+  if (proc->arq_entrada >= 0) {
+    so_arq_chamada_le(self, proc);
+    return;
+  }
+
+  // caracteres já lidos do teclado por SO_LE_LINHA/SO_LE_BUF vêm primeiro
+  int t = so_terminal_indice(term);
+  if (self->entrada_term[t].tamanho > 0) {
+    proc->estado_cpu.regA = so_entrada_retira(self, t);
+    return;
+  }
+
+  // Verifica o estado do dispositivo UMA VEZ
+  int estado;
+  if (es_le(self->es, term + TERM_TECLADO_OK, &estado) != ERR_OK) {
+    console_printf("SO: problema no acesso ao estado do teclado (proc %d)", proc->pid);
+    self->erro_interno = true;
+    so_atualiza_estado(self, proc, LIVRE); // Mata o processo
+    so_proc_liberacao_recursos(self, proc);
+    return;
+  }
+
+  if (estado != 0) {
+    // --- Caminho Rápido (Dispositivo Pronto) ---
+    int dado;
+    if (es_le(self->es, term + TERM_TECLADO, &dado) != ERR_OK) {
+      console_printf("SO: problema no acesso ao teclado (proc %d)", proc->pid);
+      self->erro_interno = true;
+      so_atualiza_estado(self, proc, LIVRE); // Mata o processo
+      so_proc_liberacao_recursos(self, proc);
+      return;
+    }
+    proc->estado_cpu.regA = dado;
+    // Processo continua PRONTO (escalonador vai rodá-lo)
+
+  } else {
+    // --- Caminho Lento (Bloqueio) ---
+    console_printf("SO: Processo %d bloqueado esperando por E/S (leitura)", proc->pid);
+    so_atualiza_estado(self, proc, BLOQUEADO);
+    proc->motivo_bloqueio = BLOQUEIO_IO_LE;
+    proc->dispositivo_esperado = term; // Armazena o terminal base
+    so_espera_insere(self, proc);
+    // regA será preenchido em so_trata_pendencias
+  }
+
+  // A gambiarra console_tictac(self->console) foi removida.
+}
+
+// implementação da chamada se sistema SO_ESCR
+// escreve o valor do reg X na saída corrente do processo
+static void so_chamada_escr(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int term = proc->terminal;
+
+  if (proc->arq_saida >= 0) {
+    so_arq_chamada_escr(self, proc);
+    return;
+  }
+
+  // se há caracteres de SO_ESCR_BUF esperando a tela, este vai depois deles
+  int t = so_terminal_indice(term);
+  if (self->saida_term[t].tamanho > 0) {
+    if (so_saida_insere(self, t, proc->estado_cpu.regX)) {
+      so_saida_escoa(self, t);
+      proc->estado_cpu.regA = 0;
+      return;
+    }
+    console_printf("SO: Processo %d bloqueado esperando por E/S (escrita)", proc->pid);
+    so_atualiza_estado(self, proc, BLOQUEADO);
+    proc->motivo_bloqueio = BLOQUEIO_IO_ESCR;
+    proc->dispositivo_esperado = term;
+    so_espera_insere(self, proc);
+    return;
+  }
+
+  // Verifica o estado do dispositivo UMA VEZ
+  int estado;
+  if (es_le(self->es, term + TERM_TELA_OK, &estado) != ERR_OK) {
+    console_printf("SO: problema no acesso ao estado da tela (proc %d)", proc->pid);
+    self->erro_interno = true;
+    so_atualiza_estado(self, proc, LIVRE); // Mata o processo
+    so_proc_liberacao_recursos(self, proc);
+    return;
+  }
+
+  if (estado != 0) {
+    // --- Caminho Rápido (Dispositivo Pronto) ---
+    int dado = proc->estado_cpu.regX;
+    if (es_escreve(self->es, term + TERM_TELA, dado) != ERR_OK) {
+      console_printf("SO: problema no acesso à tela (proc %d)", proc->pid);
+      self->erro_interno = true;
+      so_atualiza_estado(self, proc, LIVRE); // Mata o processo
+      so_proc_liberacao_recursos(self, proc);
+      return;
+    }
+    proc->estado_cpu.regA = 0; // Sucesso
+    // Processo continua PRONTO (escalonador vai rodá-lo)
+
+  } else {
+    // --- Caminho Lento (Bloqueio) ---
+    console_printf("SO: Processo %d bloqueado esperando por E/S (escrita)", proc->pid);
+    so_atualiza_estado(self, proc, BLOQUEADO);
+    proc->motivo_bloqueio = BLOQUEIO_IO_ESCR;
+    proc->dispositivo_esperado = term; // Armazena o terminal base
+    so_espera_insere(self, proc);
+    // regA será preenchido em so_trata_pendencias
+  }
+
+  // A gambiarra console_tictac(self->console) foi removida.
+}
+
+// implementação da chamada de sistema SO_ESCR_BUF
+// copia os caracteres da memória do processo para o buffer de saída do
+//   terminal; se o buffer encher, o processo bloqueia com o PC no CHAMAS, e
+//   a chamada é refeita a partir de es_buf_feitos quando houver espaço (como
+//   depois de uma falta de página na cópia)
+static void so_chamada_escr_buf(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int ender = proc->estado_cpu.regX;
+  int t = so_terminal_indice(proc->terminal);
+  bool bloqueou = false;
+
+  int tam;
+  if (!so_le_palavra_da_mem(self, proc, ender, &tam, &bloqueou)) {
+    if (!bloqueou) {
+      console_printf("SO: Processo %d passou endereço inválido para SO_ESCR_BUF", proc->pid);
+      proc->estado_cpu.regA = -1;
+    }
+    return;
+  }
+  if (tam < 0) {
+    proc->estado_cpu.regA = -1;
+    return;
+  }
+  if (proc->arq_saida >= 0) {
+    so_arq_chamada_escr_buf(self, proc, ender, tam);
+    return;
+  }
+
+  while (proc->es_buf_feitos < tam) {
+    if (self->saida_term[t].tamanho == CONFIG_TAM_BUF_TERMINAL) {
+      so_saida_escoa(self, t);
+    }
+    if (self->saida_term[t].tamanho == CONFIG_TAM_BUF_TERMINAL) {
+      console_printf("SO: Processo %d bloqueado esperando por E/S (buffer de saída cheio)", proc->pid);
+      so_atualiza_estado(self, proc, BLOQUEADO);
+      proc->motivo_bloqueio = BLOQUEIO_BUF_ESCR;
+      proc->dispositivo_esperado = proc->terminal;
+      proc->estado_cpu.regPC -= 1;
+      so_espera_insere(self, proc);
+      self->metricas.escr_buf_bloqueios++;
+      return;
+    }
+    int dado;
+    if (!so_le_palavra_da_mem(self, proc, ender + 1 + proc->es_buf_feitos, &dado, &bloqueou)) {
+      if (!bloqueou) {
+        console_printf("SO: Processo %d passou endereço inválido para SO_ESCR_BUF", proc->pid);
+        proc->estado_cpu.regA = -1;
+        proc->es_buf_feitos = 0;
+      }
+      return;
+    }
+    so_saida_insere(self, t, dado);
+    proc->es_buf_feitos++;
+  }
+
+  // o terminal pode estar pronto, e aí não vai interromper para pedir mais
+  so_saida_escoa(self, t);
+  proc->estado_cpu.regA = tam;
+  proc->es_buf_feitos = 0;
+  self->metricas.escr_buf_chamadas++;
+  self->metricas.escr_buf_caracteres += tam;
+}
+
+// implementação das chamadas de sistema SO_LE_LINHA ('linha' true) e SO_LE_BUF
+// copia os caracteres do buffer de entrada do terminal para a memória do
+//   processo; se o buffer ainda não tem o que a chamada espera, o processo
+//   bloqueia com o PC no CHAMAS, e a chamada é refeita quando tiver (só uma
+//   vez por linha, não uma por caractere, como com SO_LE)
+// o '\n' só sai do buffer depois que o tamanho foi escrito em X, para que uma
+//   falta de página no meio da cópia não perca o fim da linha
+static void so_chamada_le_buf(so_t *self, bool linha)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int ender = proc->estado_cpu.regX;
+  int t = so_terminal_indice(proc->terminal);
+  buf_term_t *entrada = &self->entrada_term[t];
+  bool bloqueou = false;
+
+  int max;
+  if (!so_le_palavra_da_mem(self, proc, ender, &max, &bloqueou)) {
+    if (!bloqueou) {
+      console_printf("SO: Processo %d passou endereço inválido para leitura bufferizada", proc->pid);
+      proc->estado_cpu.regA = -1;
+      proc->es_buf_feitos = 0;
+    }
+    return;
+  }
+  if (max <= 0) {
+    proc->estado_cpu.regA = -1;
+    return;
+  }
+  if (proc->arq_entrada >= 0) {
+    so_arq_chamada_le_buf(self, proc, ender, max, linha);
+    return;
+  }
+
+  so_entrada_enche(self, t);
+  if (proc->es_buf_feitos == 0 && !so_entrada_pronta(self, t, linha)) {
+    console_printf("SO: Processo %d bloqueado esperando por E/S (buffer de entrada)", proc->pid);
+    so_atualiza_estado(self, proc, BLOQUEADO);
+    proc->motivo_bloqueio = BLOQUEIO_BUF_LE;
+    proc->dispositivo_esperado = proc->terminal;
+    proc->estado_cpu.regPC -= 1;
+    so_espera_insere(self, proc);
+    self->metricas.le_buf_bloqueios++;
+    return;
+  }
+
+  while (proc->es_buf_feitos < max && entrada->tamanho > 0) {
+    int dado = entrada->itens[entrada->inicio];
+    if (linha && dado == '\n') {
+      break;
+    }
+    if (!so_escreve_palavra_na_mem(self, proc, ender + 1 + proc->es_buf_feitos, dado, &bloqueou)) {
+      if (!bloqueou) {
+        console_printf("SO: Processo %d passou endereço inválido para leitura bufferizada", proc->pid);
+        proc->estado_cpu.regA = -1;
+        proc->es_buf_feitos = 0;
+      }
+      return;
+    }
+    so_entrada_retira(self, t);
+    proc->es_buf_feitos++;
+  }
+
+  int lidos = proc->es_buf_feitos;
+  if (!so_escreve_palavra_na_mem(self, proc, ender, lidos, &bloqueou)) {
+    if (!bloqueou) {
+      proc->estado_cpu.regA = -1;
+      proc->es_buf_feitos = 0;
+    }
+    return;
+  }
+  if (linha && entrada->tamanho > 0 && entrada->itens[entrada->inicio] == '\n') {
+    so_entrada_retira(self, t);
+  }
+
+  proc->estado_cpu.regA = lidos;
+  proc->es_buf_feitos = 0;
+  self->metricas.le_buf_chamadas++;
+  self->metricas.le_buf_caracteres += lidos;
+}
+
+// Inicializa os campos de métricas de um novo processo
+static void so_inicializa_metricas_processo(so_t *self, processo_t *proc, int pid, int ender_carga)
+{
+  int tempo_agora = so_get_tempo(self);
+
+  proc->pid = pid;
+  proc->estado = PRONTO; // Começa como PRONTO
+  proc->prioridade = 0.5; // Padrão para escalonador de prioridade
+  proc->nivel_mlfq = 0;   // Novos processos começam no nível mais prioritário
+  proc->nice = 0;
+  proc->vruntime = self->cfs_min_vruntime; // Entra junto com os que menos executaram
+  proc->bilhetes = CONFIG_BILHETES_PADRAO;
+  proc->passo = self->stride_passo_minimo;
+  proc->tempo_real = false;
+  proc->rt_prazo_abs = -1;
+  proc->rt_trabalhos = 0;
+  proc->rt_perdas = 0;
+  proc->rt_esgotamentos = 0;
+  for (int i = 0; i < RT_FAIXAS_ATRASO; i++) {
+    proc->rt_atrasos[i] = 0;
+  }
+
+  // Metricas
+  proc->tempo_criacao = tempo_agora;
+  proc->tempo_termino = -1;
+  proc->num_preempcoes = 0;
+  proc->quantum = self->quantum_total;
+  proc->inicio_rajada = tempo_agora;
+  proc->rajada_media = 0;
+  proc->soma_quanta = 0;
+  proc->tempo_total_pronto = 0;
+  proc->ultimo_tempo_pronto = tempo_agora;
+  proc->ultimo_tempo_mudanca_estado = tempo_agora;
+
+  for (int i = 0; i < 5; i++) {
+    proc->contagem_estado[i] = 0;
+    proc->tempo_total_estado[i] = 0;
+  }
+  proc->contagem_estado[PRONTO] = 1; // Começa em PRONTO
+
+  // Estado CPU
+  proc->estado_cpu.regPC = ender_carga;
+  proc->estado_cpu.regA = 0;
+  proc->estado_cpu.regX = 0;
+  proc->estado_cpu.regERRO = 0;
+  proc->estado_cpu.complemento = 0;
+  proc->falhas_pagina = 0;
+
+  // Bloqueio
+  proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+  proc->pid_esperado = -1;
+  proc->dispositivo_esperado = -1;
+  proc->tempo_desbloqueio = 0;
+  proc->es_buf_feitos = 0;
+
+  // Arquivos: nenhum aberto, entrada e saída no terminal
+  for (int fd = 0; fd < CONFIG_ARQUIVOS_POR_PROCESSO; fd++) {
+    proc->arquivos[fd].entrada = -1;
+  }
+  proc->arq_entrada = -1;
+  proc->arq_saida = -1;
+  proc->disco_refaz = false;
+  proc->disco_esperas = 0;
+  proc->disco_tempo_espera = 0;
+
+  self->metricas.num_processos_criados++;
+}
+
+// implementação da chamada se sistema SO_CRIA_PROC
+// cria um processo
+static void so_chamada_cria_proc(so_t *self, bool com_bilhetes)
+{
+  // Obtém o processo criador
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *criador = so_proc(self, self->processo_em_execucao_idx);
+
+  // com SO_CRIA_PROC_BILH, X aponta para os bilhetes, seguidos pelo nome
+  int ender_nome = criador->estado_cpu.regX;
+  int bilhetes = criador->bilhetes;
+  bool bloqueou_mem = false;
+  if (com_bilhetes) {
+    if (!so_le_palavra_da_mem(self, criador, ender_nome, &bilhetes, &bloqueou_mem)) {
+      if (bloqueou_mem) {
+        return;
+      }
+      console_printf("SO: Erro ao ler bilhetes para criar processo.");
+      criador->estado_cpu.regA = -1;
+      return;
+    }
+    if (bilhetes <= 0) {
+      console_printf("SO: Número de bilhetes inválido (%d).", bilhetes);
+      criador->estado_cpu.regA = -1;
+      return;
+    }
+    ender_nome++;
+  }
+
+  char nome[100];
+  if (!so_proc_le_nome_programa(self, criador, ender_nome, nome, (int)sizeof(nome), &bloqueou_mem)) {
+    if (bloqueou_mem) {
+      return;
+    }
+    console_printf("SO: Erro ao ler nome do programa para criar processo.");
+    criador->estado_cpu.regA = -1;
+    return;
+  }
+
+  // o descritor só é alocado depois de lido o nome, porque a leitura pode
+  //   bloquear o criador numa falta de página e ser refeita
+  int novo_idx = so_proc_aloca(self);
+  if (novo_idx == -1) {
+    console_printf("SO: Limite de processos atingido.");
+    criador->estado_cpu.regA = -1; // Retorna erro
+    return;
+  }
+  processo_t *novo_proc = so_proc(self, novo_idx);
+  so_proc_inicializa_vm(self, novo_proc);
+
+  int pid_novo = self->proximo_pid;
+  so_proc_ativa(self, novo_proc, pid_novo);
+
+  int ender_carga = so_carrega_programa(self, nome, novo_proc);
+  if (ender_carga < 0) {
+    console_printf("SO: Erro ao carregar programa '%s'.", nome);
+    so_proc_liberacao_recursos(self, novo_proc);
+    so_proc_desativa(self, novo_proc);
+    novo_proc->estado = LIVRE;
+    novo_proc->pid = 0;
+    criador->estado_cpu.regA = -1;
+    return;
+  }
+
+  so_proc_configura_novo(self, novo_proc, ender_carga, novo_idx, pid_novo);
+  novo_proc->nice = criador->nice;
+  novo_proc->bilhetes = bilhetes;
+  self->proximo_pid = pid_novo + 1;
+  so_insere_novo_em_pronto(self, novo_idx);
+
+  criador->estado_cpu.regA = novo_proc->pid;
+}
+
+// implementação da chamada de sistema SO_FORK
+// cria uma cópia do processo corrente; a memória não é copiada, os quadros e
+//   os slots da secundária passam a ser compartilhados, e cada página só é
+//   copiada quando um dos dois escreve nela (so_atende_protecao_pagina)
+// o custo da criação é proporcional ao número de páginas, não ao conteúdo
+static void so_chamada_fork(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *pai = so_proc(self, self->processo_em_execucao_idx);
+  // se o chamador é uma thread, é copiado o espaço de endereçamento dela
+  processo_t *espaco = so_vm_espaco(self, pai);
+
+  if (self->vm_estado == NULL || espaco->base_pagsec < 0 || espaco->tabela_paginas == NULL) {
+    console_printf("SO: Processo %d não pode ser copiado (SO_FORK).", pai->pid);
+    pai->estado_cpu.regA = -1;
+    return;
+  }
+
+  // os dois processos passam a ter um slot por página da imagem, porque cada
+  //   um pode vir a gravar uma página num slot só seu
+  int *slots_imagem = malloc(sizeof(int) * espaco->num_paginas_secundarias);
+  int *slots_heap = NULL;
+  if (espaco->num_paginas_heap > 0) {
+    slots_heap = malloc(sizeof(int) * espaco->num_paginas_heap);
+  }
+  if (slots_imagem == NULL || (espaco->num_paginas_heap > 0 && slots_heap == NULL)
+      || !so_vm_separa_slots_imagem(espaco)) {
+    free(slots_imagem);
+    free(slots_heap);
+    pai->estado_cpu.regA = -1;
+    return;
+  }
+
+  int idx_filho = so_proc_aloca(self);
+  if (idx_filho == -1) {
+    console_printf("SO: Limite de processos atingido.");
+    free(slots_imagem);
+    free(slots_heap);
+    pai->estado_cpu.regA = -1;
+    return;
+  }
+  processo_t *filho = so_proc(self, idx_filho);
+  so_proc_inicializa_vm(self, filho);
+
+  int pid_filho = self->proximo_pid;
+  so_proc_ativa(self, filho, pid_filho);
+  so_inicializa_metricas_processo(self, filho, pid_filho, pai->estado_cpu.regPC);
+  self->proximo_pid = pid_filho + 1;
+  filho->estado_cpu = pai->estado_cpu;
+  filho->estado_cpu.regA = 0;
+  filho->terminal = pai->terminal;
+  // os arquivos abertos são copiados, cada um com a sua posição
+  for (int fd = 0; fd < CONFIG_ARQUIVOS_POR_PROCESSO; fd++) {
+    filho->arquivos[fd] = pai->arquivos[fd];
+  }
+  filho->arq_entrada = pai->arq_entrada;
+  filho->arq_saida = pai->arq_saida;
+  filho->nice = pai->nice;
+  filho->bilhetes = pai->bilhetes;
+
+  // tabela de páginas com os mesmos quadros, protegidos nas duas tabelas
+  tabpag_destroi(filho->tabela_paginas);
+  filho->tabela_paginas = tabpag_duplica_protegida(espaco->tabela_paginas);
+  int num_paginas = espaco->num_paginas_secundarias + espaco->num_paginas_heap;
+  for (int pagina = 0; pagina < num_paginas; pagina++) {
+    int quadro;
+    if (tabpag_traduz(filho->tabela_paginas, pagina, &quadro) == ERR_OK) {
+      vm_estado_retem_quadro(self->vm_estado, quadro);
+    }
+  }
+  for (int i = 0; i < espaco->num_paginas_secundarias; i++) {
+    slots_imagem[i] = espaco->slots_imagem[i];
+    vm_estado_retem_pagsec(self->vm_estado, slots_imagem[i]);
+  }
+  for (int i = 0; i < espaco->num_paginas_heap; i++) {
+    slots_heap[i] = espaco->slots_heap[i];
+    if (slots_heap[i] >= 0) {
+      vm_estado_retem_pagsec(self->vm_estado, slots_heap[i]);
+    }
+  }
+  filho->slots_imagem = slots_imagem;
+  filho->slots_heap = slots_heap;
+  filho->base_pagsec = espaco->base_pagsec;
+  filho->num_paginas_secundarias = espaco->num_paginas_secundarias;
+  filho->num_paginas_heap = espaco->num_paginas_heap;
+  filho->tamanho_programa = espaco->tamanho_programa;
+  filho->end_virtual_base = espaco->end_virtual_base;
+  filho->fim_heap = espaco->fim_heap;
+  filho->quadros_residentes = espaco->quadros_residentes;
+  filho->conjunto_trabalho = espaco->conjunto_trabalho;
+  filho->programa = espaco->programa;
+  if (filho->programa != NULL) {
+    cacheprog_retem(self->cache_programas, filho->programa);
+  }
+
+  self->metricas_vm.processos_fork++;
+  so_insere_novo_em_pronto(self, idx_filho);
+  pai->estado_cpu.regA = pid_filho;
+  console_printf("SO: Processo %d criou o processo %d com SO_FORK (%d páginas residentes compartilhadas)",
+                 pai->pid, pid_filho, espaco->quadros_residentes);
+}
+
+// implementação da chamada de sistema SO_CRIA_THREAD
+// cria uma thread que começa a executar no endereço X; ela usa o espaço de
+//   endereçamento do processo que o criou (se o chamador é uma thread, o do
+//   mesmo processo), sem tabela de páginas própria
+static void so_chamada_cria_thread(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *criador = so_proc(self, self->processo_em_execucao_idx);
+  processo_t *espaco = so_vm_espaco(self, criador);
+  int inicio = criador->estado_cpu.regX;
+
+  if (espaco->tabela_paginas == NULL || !so_endereco_valido_para_processo(espaco, inicio)) {
+    console_printf("SO: Processo %d pediu thread com início inválido (%d).", criador->pid, inicio);
+    criador->estado_cpu.regA = -1;
+    return;
+  }
+
+  int idx_thread = so_proc_aloca(self);
+  if (idx_thread == -1) {
+    console_printf("SO: Limite de processos atingido.");
+    criador->estado_cpu.regA = -1;
+    return;
+  }
+  processo_t *thread = so_proc(self, idx_thread);
+  so_proc_inicializa_vm(self, thread);
+  tabpag_destroi(thread->tabela_paginas);
+  thread->tabela_paginas = NULL;
+
+  int tid = self->proximo_pid;
+  so_proc_ativa(self, thread, tid);
+  so_inicializa_metricas_processo(self, thread, tid, inicio);
+  self->proximo_pid = tid + 1;
+  thread->lider_idx = espaco->idx;
+  espaco->num_threads++;
+  thread->terminal = criador->terminal;
+  thread->nice = criador->nice;
+  thread->bilhetes = criador->bilhetes;
+  so_insere_novo_em_pronto(self, idx_thread);
+
+  criador->estado_cpu.regA = tid;
+  console_printf("SO: Processo %d criou a thread %d (início em %d)", criador->pid, tid, inicio);
+}
+
+// o processo dono do espaço de endereçamento de 'proc': ele mesmo, ou o que
+//   criou a thread
+static processo_t *so_vm_espaco(so_t *self, processo_t *proc)
+{
+  if (proc->lider_idx < 0) {
+    return proc;
+  }
+  return so_proc(self, proc->lider_idx);
+}
+
+// termina as threads que usam o espaço de endereçamento de 'lider', que está
+//   terminando, antes que o espaço seja liberado
+static void so_thread_termina_todas(so_t *self, processo_t *lider)
+{
+  for (int i = self->vivos_primeiro; i != -1 && lider->num_threads > 0;) {
+    processo_t *thread = so_proc(self, i);
+    int prox = thread->vivo_prox;
+    if (thread->lider_idx == lider->idx && thread->estado != TERMINADO && thread->estado != LIVRE) {
+      if (thread->estado == PRONTO) {
+        so_remove_de_pronto(self, i);
+      }
+      so_atualiza_estado(self, thread, TERMINADO);
+      so_proc_liberacao_recursos(self, thread);
+      console_printf("SO: Thread %d terminada com o processo %d.", thread->pid, lider->pid);
+      // 'prox' já foi lido, porque a coleta tira a thread da lista de vivos
+      if (so_proc_desbloqueia_esperando(self, thread)) {
+        console_printf("SO: Processo %d foi coletado.", thread->pid);
+      }
+    }
+    i = prox;
+  }
+}
+
+static bool so_proc_le_nome_programa(so_t *self, processo_t *criador, int ender, char nome[], int tam, bool *bloqueou)
+{
+  return copia_str_da_mem(self, criador, tam, nome, ender, bloqueou);
+}
+
+static void so_proc_configura_novo(so_t *self, processo_t *novo_proc, int ender_carga, int idx_tabela, int pid)
+{
+  so_inicializa_metricas_processo(self, novo_proc, pid, ender_carga);
+  novo_proc->terminal = D_TERM_A + ((idx_tabela % 4) * 4);
+}
+
+static void so_proc_inicializa_vm(so_t *self, processo_t *proc)
+{
+  if (proc == NULL) {
+    return;
+  }
+  if (proc->tabela_paginas != NULL) {
+    tabpag_destroi(proc->tabela_paginas);
+  }
+  proc->tabela_paginas = tabpag_cria();
+  proc->falhas_pagina = 0;
+  proc->quadros_residentes = 0;
+  proc->conjunto_trabalho = 0;
+  proc->faltas_recentes = 0;
+  proc->instrucoes_recentes = 0;
+  if (self->vm_estado != NULL) {
+    so_vm_libera_slots_imagem(self, proc);
+  }
+  proc->base_pagsec = -1;
+  proc->num_paginas_secundarias = 0;
+  so_proc_libera_heap(self, proc);
+  proc->num_paginas_heap = 0;
+  proc->fim_heap = 0;
+  proc->tamanho_programa = 0;
+  proc->end_virtual_base = 0;
+  proc->tempo_desbloqueio = 0;
+  proc->tick_envelhecimento = self->tick_relogio;
+  proc->lider_idx = -1;
+  proc->num_threads = 0;
+}
+
+// libera os slots da secundária das páginas criadas com SO_SBRK
+// o número de páginas é mantido, para o relatório
+static void so_proc_libera_heap(so_t *self, processo_t *proc)
+{
+  if (proc->slots_heap != NULL) {
+    for (int i = 0; i < proc->num_paginas_heap; i++) {
+      if (proc->slots_heap[i] >= 0 && self->vm_estado != NULL) {
+        vm_estado_solta_pagsec(self->vm_estado, proc->slots_heap[i]);
+      }
+    }
+    free(proc->slots_heap);
+  }
+  proc->slots_heap = NULL;
+}
+
+static void so_proc_liberacao_recursos(so_t *self, processo_t *proc)
+{
+  if (proc == NULL) {
+    return;
+  }
+
+  // uma thread não tem memória própria; um processo com threads as termina
+  //   antes de liberar o espaço de endereçamento que elas usam
+  if (proc->lider_idx >= 0) {
+    so_proc(self, proc->lider_idx)->num_threads--;
+    proc->lider_idx = -1;
+  }
+  if (proc->num_threads > 0) {
+    so_thread_termina_todas(self, proc);
+  }
+
+  for (int fd = 0; fd < CONFIG_ARQUIVOS_POR_PROCESSO; fd++) {
+    if (proc->arquivos[fd].entrada >= 0) {
+      so_arq_fecha(self, proc, fd);
+    }
+  }
+
+  if (self->vm_estado != NULL) {
+    if (proc->tabela_paginas != NULL) {
+      so_vm_solta_quadros(self, proc);
+    }
+    vm_estado_libera_quadros_do_processo(self->vm_estado, proc->pid);
+    proc->quadros_residentes = 0;
+    so_vm_libera_slots_imagem(self, proc);
+  }
+
+  if (proc->tabela_paginas != NULL) {
+    tabpag_destroi(proc->tabela_paginas);
+    proc->tabela_paginas = NULL;
+  }
+
+  proc->base_pagsec = -1;
+  so_proc_libera_heap(self, proc);
+  if (proc->programa != NULL) {
+    cacheprog_libera(self->cache_programas, proc->programa);
+    proc->programa = NULL;
+  }
+  proc->tamanho_programa = 0;
+  proc->end_virtual_base = 0;
+  proc->tempo_desbloqueio = 0;
+}
+
+// índice do processo vivo com o pid, ou -1; só é percorrido o balde do pid
+static int so_proc_busca_idx(so_t *self, int pid)
+{
+  if (pid <= 0) {
+    return -1;
+  }
+  int i = self->pid_baldes[pid % self->capacidade_processos];
+  for (; i != -1; i = so_proc(self, i)->pid_prox) {
+    if (so_proc(self, i)->pid == pid) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// desbloqueia o primeiro processo que espera por 'proc_alvo', que então é
+//   coletado; só é percorrida a lista de espera do pid do alvo
+static bool so_proc_desbloqueia_esperando(so_t *self, processo_t *proc_alvo)
+{
+  bool coletado = false;
+  int pid_alvo = proc_alvo->pid;
+  lista_espera_t *lista = &self->espera_pid[pid_alvo % self->capacidade_processos];
+
+  for (int i = lista->primeiro; i != -1; i = so_proc(self, i)->espera_prox) {
+    processo_t *proc_esperando = so_proc(self, i);
+    if (proc_esperando->pid_esperado != pid_alvo) {
+      continue;
+    }
+
+    console_printf("SO: Desbloqueando processo %d (esperava por %d).",
+                   proc_esperando->pid, pid_alvo);
+    so_atualiza_estado(self, proc_esperando, PRONTO);
+    proc_esperando->motivo_bloqueio = BLOQUEIO_NENHUM;
+    proc_esperando->estado_cpu.regA = 0;
+    so_insere_em_pronto(self, i);
+
+    so_atualiza_estado(self, proc_alvo, LIVRE);
+    so_proc_liberacao_recursos(self, proc_alvo);
+    coletado = true;
+    break;
+  }
+
+  return coletado;
+}
+
+// ---------------------------------------------------------------------
+// MEMÓRIA VIRTUAL {{{1
+// ---------------------------------------------------------------------
+
+static bool so_endereco_valido_para_processo(processo_t *proc, int endereco)
+{
+  if (proc == NULL) {
+    return false;
+  }
+  if (proc->base_pagsec < 0) {
+    return false;
+  }
+  if (proc->num_paginas_secundarias <= 0) {
+    return false;
+  }
+
+  int base = proc->end_virtual_base;
+  int limite = proc->fim_heap;
+  if (endereco < base) {
+    return false;
+  }
+  if (endereco >= limite) {
+    return false;
+  }
+  return true;
+}
+
+// cria a memória secundária, mapeada de arquivo se CONFIG_ARQUIVO_MEM_SECUNDARIA
+//   estiver definido, ou no heap caso contrário (ou se o mapeamento falhar)
+static void so_vm_configura_mem_sec(so_t *self, int tam_sec)
+{
+#ifdef CONFIG_ARQUIVO_MEM_SECUNDARIA
+  if (vm_estado_configura_mem_sec_arquivo(self->vm_estado, tam_sec,
+                                          CONFIG_ARQUIVO_MEM_SECUNDARIA)) {
+    console_printf("SO: memória secundária mapeada de '%s' (%d palavras)",
+                   CONFIG_ARQUIVO_MEM_SECUNDARIA, tam_sec);
+    return;
+  }
+  console_printf("SO: não foi possível mapear '%s', usando memória secundária no heap",
+                 CONFIG_ARQUIVO_MEM_SECUNDARIA);
+#endif
+  vm_estado_configura_mem_sec(self->vm_estado, tam_sec);
+}
+
+static int so_vm_agenda_transferencia(so_t *self, int tempo_atual, int transferencias)
+{
+  if (transferencias <= 0) {
+    return tempo_atual;
+  }
+
+  int inicio = tempo_atual;
+  if (self->tempo_disponivel_memsec > inicio) {
+    inicio = self->tempo_disponivel_memsec;
+  }
+
+  int fim = inicio + transferencias * self->tempo_transferencia_pagina;
+  self->tempo_disponivel_memsec = fim;
+  self->metricas_vm.transferencias_paginas += transferencias;
+  return fim;
+}
+
+static int so_vm_escolhe_quadro_para_carregar(so_t *self)
+{
+  if (self == NULL || self->vm_estado == NULL) {
+    return -1;
+  }
+
+  int livre = vm_estado_busca_quadro_livre(self->vm_estado);
+  if (livre >= 0) {
+    return livre;
+  }
+
+  if (self->algoritmo_substituicao == SUBSTITUICAO_FIFO) {
+    return vm_estado_busca_vitima(self->vm_estado, VITIMA_MENOR_CARIMBO);
+  }
+  // as idades só são comparáveis se todos os processos estiverem em dia
+  so_vm_envelhece_todos(self);
+  return vm_estado_busca_vitima(self->vm_estado, VITIMA_MENOR_IDADE);
+}
+
+// retorna o slot da secundária que guarda a página, ou -1 se a página não
+//   tem cópia na secundária (página da área de SO_SBRK ainda não gravada)
+static int so_vm_slot_da_pagina(processo_t *proc, int pagina_virtual)
+{
+  if (proc->base_pagsec < 0 || pagina_virtual < 0) {
+    return -1;
+  }
+  if (pagina_virtual < proc->num_paginas_secundarias) {
+    if (proc->slots_imagem != NULL) {
+      return proc->slots_imagem[pagina_virtual];
+    }
+    return proc->base_pagsec + pagina_virtual;
+  }
+  int pagina_heap = pagina_virtual - proc->num_paginas_secundarias;
+  if (proc->slots_heap == NULL || pagina_heap >= proc->num_paginas_heap) {
+    return -1;
+  }
+  return proc->slots_heap[pagina_heap];
+}
+
+// reserva um slot novo da secundária, com uma referência, para gravar uma
+//   página: da área de SO_SBRK na primeira vez em que ela precisa ser gravada,
+//   ou cujo slot é compartilhado com outro processo (SO_FORK)
+static int so_vm_aloca_slot(so_t *self, processo_t *proc, int pagina_virtual)
+{
+  int slot = vm_estado_aloca_extensao(self->vm_estado, 1);
+  if (slot < 0) {
+    console_printf("SO: memória secundária cheia ao gravar página %d do proc %d",
+                   pagina_virtual, proc->pid);
+    return -1;
+  }
+  vm_estado_ocupa_pagsec(self->vm_estado, slot, proc->pid, pagina_virtual, slot * TAM_PAGINA, TAM_PAGINA);
+  return slot;
+}
+
+// passa a página do processo para 'slot', cuja referência já foi contada, e
+//   devolve a referência do slot anterior
+// uma página da imagem só muda de slot se o processo tem slots por página
+//   (slots_imagem), o que acontece com todo processo que compartilha slots
+static bool so_vm_troca_slot(so_t *self, processo_t *proc, int pagina_virtual, int slot)
+{
+  int *pos;
+  if (pagina_virtual < proc->num_paginas_secundarias) {
+    if (proc->slots_imagem == NULL) {
+      return false;
+    }
+    pos = &proc->slots_imagem[pagina_virtual];
+  } else {
+    int pagina_heap = pagina_virtual - proc->num_paginas_secundarias;
+    if (proc->slots_heap == NULL || pagina_heap >= proc->num_paginas_heap) {
+      return false;
+    }
+    pos = &proc->slots_heap[pagina_heap];
+  }
+  if (*pos >= 0) {
+    vm_estado_solta_pagsec(self->vm_estado, *pos);
   }
+  *pos = slot;
+  return true;
 }
 
-// implementação da chamada se sistema SO_LE
-// faz a leitura de um dado da entrada corrente do processo, coloca o dado no reg A
-static void so_chamada_le(so_t *self)
+// passa os slots da imagem do processo, que são os da extensão a partir de
+//   base_pagsec, para um vetor com o slot de cada página, para que cada
+//   página possa mudar de slot
+static bool so_vm_separa_slots_imagem(processo_t *proc)
 {
-  if (self->processo_em_execucao_idx == -1) return;
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
-  int term = proc->terminal;
+  if (proc->slots_imagem != NULL || proc->num_paginas_secundarias <= 0) {
+    return true;
+  }
+  int *slots = malloc(sizeof(int) * proc->num_paginas_secundarias);
+  if (slots == NULL) {
+    return false;
+  }
+  for (int i = 0; i < proc->num_paginas_secundarias; i++) {
+    slots[i] = proc->base_pagsec + i;
+  }
+  proc->slots_imagem = slots;
+  return true;
+}
 
-  // Verifica o estado do dispositivo UMA VEZ
-  int estado;
-  if (es_le(self->es, term + TERM_TECLADO_OK, &estado) != ERR_OK) {
-    console_printf("SO: problema no acesso ao estado do teclado (proc %d)", proc->pid);
-    self->erro_interno = true;
-    so_atualiza_estado(self, proc, LIVRE); // Mata o processo
-    so_proc_liberacao_recursos(self, proc);
-    return;
+// devolve os slots da imagem do processo: a extensão inteira, ou uma
+//   referência de cada slot se eles estiverem separados por página
+static void so_vm_libera_slots_imagem(so_t *self, processo_t *proc)
+{
+  if (proc->slots_imagem != NULL) {
+    for (int i = 0; i < proc->num_paginas_secundarias; i++) {
+      if (proc->slots_imagem[i] >= 0) {
+        vm_estado_solta_pagsec(self->vm_estado, proc->slots_imagem[i]);
+      }
+    }
+    free(proc->slots_imagem);
+    proc->slots_imagem = NULL;
+  } else if (proc->base_pagsec >= 0) {
+    vm_estado_libera_extensao(self->vm_estado, proc->base_pagsec, proc->num_paginas_secundarias);
   }
+}
 
-  if (estado != 0) {
-    // --- Caminho Rápido (Dispositivo Pronto) ---
-    int dado;
-    if (es_le(self->es, term + TERM_TECLADO, &dado) != ERR_OK) {
-      console_printf("SO: problema no acesso ao teclado (proc %d)", proc->pid);
-      self->erro_interno = true;
-      so_atualiza_estado(self, proc, LIVRE); // Mata o processo
-      so_proc_liberacao_recursos(self, proc);
-      return;
+// índice do primeiro processo, a partir de 'i' na lista de vivos, que mapeia
+//   'pagina_virtual' no quadro, ou -1
+// um quadro compartilhado (SO_FORK) está na mesma página de todos que o mapeiam
+static int so_vm_mapeador(so_t *self, int i, int pagina_virtual, int indice_quadro)
+{
+  for (; i != -1; i = so_proc(self, i)->vivo_prox) {
+    processo_t *proc = so_proc(self, i);
+    int quadro;
+    if (proc->tabela_paginas != NULL
+        && tabpag_traduz(proc->tabela_paginas, pagina_virtual, &quadro) == ERR_OK
+        && quadro == indice_quadro) {
+      return i;
     }
-    proc->estado_cpu.regA = dado;
-    // Processo continua PRONTO (escalonador vai rodá-lo)
+  }
+  return -1;
+}
 
-  } else {
-    // --- Caminho Lento (Bloqueio) ---
-    console_printf("SO: Processo %d bloqueado esperando por E/S (leitura)", proc->pid);
-    so_atualiza_estado(self, proc, BLOQUEADO);
-    proc->motivo_bloqueio = BLOQUEIO_IO_LE;
-    proc->dispositivo_esperado = term; // Armazena o terminal base
-    // regA será preenchido em so_trata_pendencias
+// devolve os quadros mapeados pelo processo; os que ele compartilha com outros
+//   continuam ocupados, e se ele era o dono um dos outros passa a ser
+static void so_vm_solta_quadros(so_t *self, processo_t *proc)
+{
+  int num_paginas = proc->num_paginas_secundarias + proc->num_paginas_heap;
+  for (int pagina = 0; pagina < num_paginas; pagina++) {
+    int quadro;
+    if (tabpag_traduz(proc->tabela_paginas, pagina, &quadro) != ERR_OK) {
+      continue;
+    }
+    tabpag_invalida_pagina(proc->tabela_paginas, pagina);
+    if (vm_estado_solta_quadro(self->vm_estado, quadro) > 0
+        && vm_estado_quadro_dono(self->vm_estado, quadro) == proc->pid) {
+      int outro = so_vm_mapeador(self, self->vivos_primeiro, pagina, quadro);
+      vm_estado_define_dono(self->vm_estado, quadro, outro >= 0 ? so_proc(self, outro)->pid : -1);
+    }
   }
+  proc->quadros_residentes = 0;
+}
 
-  // A gambiarra console_tictac(self->console) foi removida.
+// o processo deixa de ter a página no quadro
+static void so_vm_perde_quadro(so_t *self, int idx_proc, int pagina_virtual)
+{
+  processo_t *proc = so_proc(self, idx_proc);
+  tabpag_invalida_pagina(proc->tabela_paginas, pagina_virtual);
+  proc->quadros_residentes--;
+#ifdef CONFIG_ESCALONAMENTO_MEMORIA
+  // a chave de um pronto depende de quanto do seu conjunto de trabalho
+  //   está residente
+  if (so_usa_heap_prontos(self) && fprio_contem(self->prontos_prio, idx_proc)) {
+    fprio_insere(self->prontos_prio, idx_proc, so_chave_pronto(self, proc));
+  }
+#endif
 }
 
-// implementação da chamada se sistema SO_ESCR
-// escreve o valor do reg X na saída corrente do processo
-static void so_chamada_escr(so_t *self)
+// copia o conteúdo do quadro para o slot da secundária
+static bool so_vm_grava_quadro(so_t *self, int indice_quadro, int slot, int *transferencias)
 {
-  if (self->processo_em_execucao_idx == -1) return;
-  processo_t *proc = &self->tabela_processos[self->processo_em_execucao_idx];
-  int term = proc->terminal;
+  int base_sec = slot * TAM_PAGINA;
+  int base_fis = indice_quadro * TAM_PAGINA;
+  int pagina[TAM_PAGINA];
 
-  // Verifica o estado do dispositivo UMA VEZ
-  int estado;
-  if (es_le(self->es, term + TERM_TELA_OK, &estado) != ERR_OK) {
-    console_printf("SO: problema no acesso ao estado da tela (proc %d)", proc->pid);
-    self->erro_interno = true;
-    so_atualiza_estado(self, proc, LIVRE); // Mata o processo
-    so_proc_liberacao_recursos(self, proc);
-    return;
+  for (int offset = 0; offset < TAM_PAGINA; offset++) {
+    if (mem_le(self->mem, base_fis + offset, &pagina[offset]) != ERR_OK) {
+      return false;
+    }
+  }
+  if (vm_estado_sec_escreve_bloco(self->vm_estado, base_sec, pagina, TAM_PAGINA) != ERR_OK) {
+    return false;
   }
 
-  if (estado != 0) {
-    // --- Caminho Rápido (Dispositivo Pronto) ---
-    int dado = proc->estado_cpu.regX;
-    if (es_escreve(self->es, term + TERM_TELA, dado) != ERR_OK) {
-      console_printf("SO: problema no acesso à tela (proc %d)", proc->pid);
-      self->erro_interno = true;
-      so_atualiza_estado(self, proc, LIVRE); // Mata o processo
-      so_proc_liberacao_recursos(self, proc);
-      return;
+  if (transferencias != NULL) {
+    (*transferencias)++;
+  }
+  return true;
+}
+
+// libera um quadro compartilhado por vários processos (SO_FORK), todos com a
+//   página no mesmo slot; ela é gravada se algum deles a alterou, num slot
+//   novo se o slot é também de processos que não mapeiam o quadro
+static bool so_vm_salva_quadro_compartilhado(so_t *self, int indice_quadro, int pagina_virtual, int *transferencias)
+{
+  int referencias = vm_estado_quadro_referencias(self->vm_estado, indice_quadro);
+  int primeiro = so_vm_mapeador(self, self->vivos_primeiro, pagina_virtual, indice_quadro);
+  if (primeiro < 0) {
+    return false;
+  }
+
+  bool precisa_gravar = false;
+  for (int i = primeiro; i != -1;
+       i = so_vm_mapeador(self, so_proc(self, i)->vivo_prox, pagina_virtual, indice_quadro)) {
+    precisa_gravar |= tabpag_bit_alteracao(so_proc(self, i)->tabela_paginas, pagina_virtual);
+  }
+
+  if (precisa_gravar) {
+    processo_t *proc_primeiro = so_proc(self, primeiro);
+    int slot_secundario = so_vm_slot_da_pagina(proc_primeiro, pagina_virtual);
+    pagina_sec_desc_t *desc = vm_estado_pagina_sec(self->vm_estado, slot_secundario);
+    if (desc == NULL || desc->referencias > referencias) {
+      slot_secundario = so_vm_aloca_slot(self, proc_primeiro, pagina_virtual);
+      if (slot_secundario < 0) {
+        return false;
+      }
+      for (int i = primeiro; i != -1;
+           i = so_vm_mapeador(self, so_proc(self, i)->vivo_prox, pagina_virtual, indice_quadro)) {
+        vm_estado_retem_pagsec(self->vm_estado, slot_secundario);
+        so_vm_troca_slot(self, so_proc(self, i), pagina_virtual, slot_secundario);
+      }
+      // a referência da alocação; ficam as dos processos
+      vm_estado_solta_pagsec(self->vm_estado, slot_secundario);
     }
-    proc->estado_cpu.regA = 0; // Sucesso
-    // Processo continua PRONTO (escalonador vai rodá-lo)
+    if (!so_vm_grava_quadro(self, indice_quadro, slot_secundario, transferencias)) {
+      return false;
+    }
+  }
+
+  int i = primeiro;
+  while (i != -1) {
+    int prox = so_proc(self, i)->vivo_prox;
+    so_vm_perde_quadro(self, i, pagina_virtual);
+    i = so_vm_mapeador(self, prox, pagina_virtual, indice_quadro);
+  }
+
+  vm_estado_libera_quadro(self->vm_estado, indice_quadro);
+  return true;
+}
+
+static bool so_vm_salva_quadro(so_t *self, int indice_quadro, int *transferencias)
+{
+  if (self == NULL || self->vm_estado == NULL) {
+    return false;
+  }
+
+  if (indice_quadro < 0 || indice_quadro >= vm_estado_num_quadros(self->vm_estado)) {
+    return false;
+  }
+
+  if (vm_estado_quadro_livre(self->vm_estado, indice_quadro)) {
+    vm_estado_libera_quadro(self->vm_estado, indice_quadro);
+    return true;
+  }
+
+  int pid_dono = vm_estado_quadro_dono(self->vm_estado, indice_quadro);
+  int pagina_virtual = vm_estado_quadro_pagina(self->vm_estado, indice_quadro);
+  if (pid_dono < 0 || pagina_virtual < 0) {
+    return false;
+  }
+
+  if (vm_estado_quadro_referencias(self->vm_estado, indice_quadro) > 1) {
+    return so_vm_salva_quadro_compartilhado(self, indice_quadro, pagina_virtual, transferencias);
+  }
 
+  int idx_proc = so_proc_busca_idx(self, pid_dono);
+  processo_t *proc_dono = idx_proc >= 0 ? so_proc(self, idx_proc) : NULL;
+
+  bool precisa_gravar = false;
+  int slot_secundario = -1;
+
+  if (proc_dono != NULL && proc_dono->tabela_paginas != NULL && pagina_virtual >= 0) {
+    precisa_gravar = tabpag_bit_alteracao(proc_dono->tabela_paginas, pagina_virtual);
+    slot_secundario = so_vm_slot_da_pagina(proc_dono, pagina_virtual);
+    // página nunca gravada, ou num slot que outro processo também usa
+    if (precisa_gravar && (slot_secundario < 0
+        || vm_estado_pagina_sec(self->vm_estado, slot_secundario)->referencias > 1)) {
+      int novo_slot = so_vm_aloca_slot(self, proc_dono, pagina_virtual);
+      if (novo_slot >= 0 && !so_vm_troca_slot(self, proc_dono, pagina_virtual, novo_slot)) {
+        vm_estado_solta_pagsec(self->vm_estado, novo_slot);
+        novo_slot = -1;
+      }
+      slot_secundario = novo_slot;
+    }
+    // sem lugar para gravar, a página continua mapeada
+    if (precisa_gravar && slot_secundario < 0) {
+      return false;
+    }
+    so_vm_perde_quadro(self, idx_proc, pagina_virtual);
+  }
+
+  if (precisa_gravar && !so_vm_grava_quadro(self, indice_quadro, slot_secundario, transferencias)) {
+    return false;
+  }
+
+  vm_estado_libera_quadro(self->vm_estado, indice_quadro);
+  return true;
+}
+
+static bool so_vm_carrega_pagina(so_t *self, processo_t *proc, int pagina_virtual, int indice_quadro, int tempo_carimbo, int *transferencias)
+{
+  if (self == NULL || self->vm_estado == NULL || proc == NULL) {
+    return false;
+  }
+  if (proc->base_pagsec < 0) {
+    return false;
+  }
+  if (pagina_virtual < 0 || pagina_virtual >= proc->num_paginas_secundarias + proc->num_paginas_heap) {
+    return false;
+  }
+
+  int base_fis = indice_quadro * TAM_PAGINA;
+  int pagina[TAM_PAGINA];
+  int slot_secundario = so_vm_slot_da_pagina(proc, pagina_virtual);
+
+  if (slot_secundario >= 0) {
+    int base_sec = slot_secundario * TAM_PAGINA;
+    if (vm_estado_sec_le_bloco(self->vm_estado, base_sec, pagina, TAM_PAGINA) != ERR_OK) {
+      return false;
+    }
+    if (transferencias != NULL) {
+      (*transferencias)++;
+    }
   } else {
-    // --- Caminho Lento (Bloqueio) ---
-    console_printf("SO: Processo %d bloqueado esperando por E/S (escrita)", proc->pid);
-    so_atualiza_estado(self, proc, BLOQUEADO);
-    proc->motivo_bloqueio = BLOQUEIO_IO_ESCR;
-    proc->dispositivo_esperado = term; // Armazena o terminal base
-    // regA será preenchido em so_trata_pendencias
+    // página da área de SO_SBRK nunca gravada: basta um quadro zerado
+    for (int offset = 0; offset < TAM_PAGINA; offset++) {
+      pagina[offset] = 0;
+    }
+    self->metricas_vm.paginas_zeradas++;
+  }
+  for (int offset = 0; offset < TAM_PAGINA; offset++) {
+    if (mem_escreve(self->mem, base_fis + offset, pagina[offset]) != ERR_OK) {
+      return false;
+    }
   }
 
-  // A gambiarra console_tictac(self->console) foi removida.
+  vm_estado_ocupa_quadro(self->vm_estado, indice_quadro, proc->pid, pagina_virtual, (unsigned long)tempo_carimbo);
+  proc->quadros_residentes++;
+
+  vm_estado_define_idade(self->vm_estado, indice_quadro, VM_IDADE_MSB);
+
+  if (proc->tabela_paginas == NULL) {
+    return false;
+  }
+  tabpag_define_quadro(proc->tabela_paginas, pagina_virtual, indice_quadro);
+  return true;
 }
 
-// Inicializa os campos de métricas de um novo processo
-static void so_inicializa_metricas_processo(so_t *self, processo_t *proc, int pid, int ender_carga)
+static bool so_atende_falta_pagina(so_t *self, processo_t *proc)
 {
-  int tempo_agora = so_get_tempo(self);
+  if (self == NULL || proc == NULL || self->vm_estado == NULL) {
+    return false;
+  }
 
-  proc->pid = pid;
-  proc->estado = PRONTO; // Começa como PRONTO
-  proc->prioridade = 0.5; // Padrão para escalonador de prioridade
+  // a página é do dono do espaço de endereçamento; quem espera a
+  //   transferência é 'proc', que pode ser uma thread
+  processo_t *espaco = so_vm_espaco(self, proc);
+  int endereco = proc->estado_cpu.complemento;
+  if (!so_endereco_valido_para_processo(espaco, endereco)) {
+    return false;
+  }
 
-  // Metricas
-  proc->tempo_criacao = tempo_agora;
-  proc->tempo_termino = -1;
-  proc->num_preempcoes = 0;
-  proc->tempo_total_pronto = 0;
-  proc->ultimo_tempo_pronto = tempo_agora;
-  proc->ultimo_tempo_mudanca_estado = tempo_agora;
+  int pagina_virtual = (endereco - espaco->end_virtual_base) / TAM_PAGINA;
+  int tempo_atual = so_get_tempo(self);
+  int transferencias = 0;
 
-  for (int i = 0; i < 5; i++) {
-    proc->contagem_estado[i] = 0;
-    proc->tempo_total_estado[i] = 0;
+  int indice_quadro = vm_estado_busca_quadro_livre(self->vm_estado);
+  if (indice_quadro < 0) {
+    indice_quadro = so_vm_escolhe_quadro_para_carregar(self);
+    if (indice_quadro < 0) {
+      return false;
+    }
+    if (!so_vm_salva_quadro(self, indice_quadro, &transferencias)) {
+      int indice_alternativo = so_vm_escolhe_quadro_para_carregar(self);
+      if (indice_alternativo < 0) {
+        return false;
+      }
+      indice_quadro = indice_alternativo;
+      if (!so_vm_salva_quadro(self, indice_quadro, &transferencias)) {
+        return false;
+      }
+    }
   }
-  proc->contagem_estado[PRONTO] = 1; // Começa em PRONTO
 
-  // Estado CPU
-  proc->estado_cpu.regPC = ender_carga;
-  proc->estado_cpu.regA = 0;
-  proc->estado_cpu.regX = 0;
-  proc->estado_cpu.regERRO = 0;
-  proc->estado_cpu.complemento = 0;
-  proc->falhas_pagina = 0;
+  if (!so_vm_carrega_pagina(self, espaco, pagina_virtual, indice_quadro, tempo_atual, &transferencias)) {
+    return false;
+  }
 
-  // Bloqueio
-  proc->motivo_bloqueio = BLOQUEIO_NENHUM;
+  espaco->falhas_pagina++;
+  espaco->faltas_recentes++;
+  self->metricas_vm.falhas_pagina_total++;
+  proc->estado_cpu.regERRO = ERR_OK;
+
+  // página zerada em quadro livre: não tem transferência, o processo segue
+  if (transferencias == 0) {
+    console_printf("SO: Falta de pagina atendida com quadro zerado (proc %d, pagina %d -> quadro %d)",
+                   proc->pid, pagina_virtual, indice_quadro);
+    return true;
+  }
+
+  so_vm_bloqueia_transferencia(self, proc, tempo_atual, transferencias);
+  console_printf("SO: Falta de pagina atendida (proc %d, pagina %d -> quadro %d)",
+                 proc->pid, pagina_virtual, indice_quadro);
+
+  return true;
+}
+
+// bloqueia o processo até o fim das transferências de página que causou
+static void so_vm_bloqueia_transferencia(so_t *self, processo_t *proc, int tempo_atual, int transferencias)
+{
+  int tempo_desbloqueio = so_vm_agenda_transferencia(self, tempo_atual, transferencias);
+  proc->motivo_bloqueio = BLOQUEIO_PAGINA;
+  proc->tempo_desbloqueio = tempo_desbloqueio;
   proc->pid_esperado = -1;
   proc->dispositivo_esperado = -1;
-  proc->tempo_desbloqueio = 0;
 
-  self->metricas.num_processos_criados++;
+  so_atualiza_estado(self, proc, BLOQUEADO);
+  so_espera_insere(self, proc);
 }
 
-// implementação da chamada se sistema SO_CRIA_PROC
-// cria um processo
-static void so_chamada_cria_proc(so_t *self)
+// atende uma escrita numa página protegida, que o processo compartilha (ou
+//   compartilhava) com outro desde SO_FORK
+// se o quadro só é mapeado pelo processo, basta retirar a proteção; senão a
+//   página é copiada para um quadro só dele, que pode precisar ser liberado
+//   antes (e aí o processo bloqueia pela gravação, como numa falta de página)
+static bool so_atende_protecao_pagina(so_t *self, processo_t *proc)
 {
-  // Obtém o processo criador
-  if (self->processo_em_execucao_idx == -1) return;
-  processo_t *criador = &self->tabela_processos[self->processo_em_execucao_idx];
-
-  int novo_idx = so_proc_encontra_slot_livre(self);
-  if (novo_idx == -1) {
-    console_printf("SO: Limite de processos atingido.");
-    criador->estado_cpu.regA = -1; // Retorna erro
-    return;
+  if (self == NULL || proc == NULL || self->vm_estado == NULL) {
+    return false;
   }
-
-  char nome[100];
-  bool bloqueou_mem = false;
-  if (!so_proc_le_nome_programa(self, criador, nome, (int)sizeof(nome), &bloqueou_mem)) {
-    if (bloqueou_mem) {
-      return;
-    }
-    console_printf("SO: Erro ao ler nome do programa para criar processo.");
-    criador->estado_cpu.regA = -1;
-    return;
+  // como numa falta de página, 'proc' pode ser uma thread do dono do espaço
+  processo_t *espaco = so_vm_espaco(self, proc);
+  if (espaco->tabela_paginas == NULL) {
+    return false;
   }
 
-  processo_t *novo_proc = &self->tabela_processos[novo_idx];
-  so_proc_inicializa_vm(self, novo_proc);
+  int endereco = proc->estado_cpu.complemento;
+  if (!so_endereco_valido_para_processo(espaco, endereco)) {
+    return false;
+  }
+  int pagina_virtual = (endereco - espaco->end_virtual_base) / TAM_PAGINA;
+  int quadro;
+  if (tabpag_traduz(espaco->tabela_paginas, pagina_virtual, &quadro) != ERR_OK) {
+    return false;
+  }
+  self->metricas_vm.faltas_protecao++;
+  proc->estado_cpu.regERRO = ERR_OK;
 
-  int pid_novo = self->proximo_pid;
-  novo_proc->pid = pid_novo;
+  if (vm_estado_quadro_referencias(self->vm_estado, quadro) <= 1) {
+    vm_estado_define_dono(self->vm_estado, quadro, espaco->pid);
+    tabpag_protege_pagina(espaco->tabela_paginas, pagina_virtual, false);
+    return true;
+  }
 
-  int ender_carga = so_carrega_programa(self, nome, novo_proc);
-  if (ender_carga < 0) {
-    console_printf("SO: Erro ao carregar programa '%s'.", nome);
-    so_proc_liberacao_recursos(self, novo_proc);
-    novo_proc->estado = LIVRE;
-    novo_proc->pid = 0;
-    criador->estado_cpu.regA = -1;
-    return;
+  int tempo_atual = so_get_tempo(self);
+  int transferencias = 0;
+  int novo_quadro = vm_estado_busca_quadro_livre(self->vm_estado);
+  if (novo_quadro < 0) {
+    novo_quadro = so_vm_escolhe_quadro_para_carregar(self);
+    if (novo_quadro < 0 || !so_vm_salva_quadro(self, novo_quadro, &transferencias)) {
+      return false;
+    }
+    // a vítima pode ter sido o próprio quadro compartilhado: a página deixou
+    //   de estar mapeada, e a escrita refeita vai causar uma falta de página
+    if (tabpag_traduz(espaco->tabela_paginas, pagina_virtual, &quadro) != ERR_OK) {
+      if (transferencias > 0) {
+        so_vm_bloqueia_transferencia(self, proc, tempo_atual, transferencias);
+      }
+      return true;
+    }
   }
 
-  so_proc_configura_novo(self, novo_proc, ender_carga, novo_idx, pid_novo);
-  self->proximo_pid = pid_novo + 1;
-  so_insere_em_pronto(self, novo_idx);
+  int origem = quadro * TAM_PAGINA;
+  int destino = novo_quadro * TAM_PAGINA;
+  for (int offset = 0; offset < TAM_PAGINA; offset++) {
+    int valor;
+    if (mem_le(self->mem, origem + offset, &valor) != ERR_OK
+        || mem_escreve(self->mem, destino + offset, valor) != ERR_OK) {
+      return false;
+    }
+  }
+  // o quadro novo tem o conteúdo do compartilhado, inclusive o que ainda não
+  //   foi gravado no slot
+  bool alterada = tabpag_bit_alteracao(espaco->tabela_paginas, pagina_virtual);
+  vm_estado_ocupa_quadro(self->vm_estado, novo_quadro, espaco->pid, pagina_virtual, (unsigned long)tempo_atual);
+  vm_estado_define_idade(self->vm_estado, novo_quadro, VM_IDADE_MSB);
+  tabpag_define_quadro(espaco->tabela_paginas, pagina_virtual, novo_quadro);
+  if (alterada) {
+    tabpag_marca_bit_acesso(espaco->tabela_paginas, pagina_virtual, true);
+  }
 
-  criador->estado_cpu.regA = novo_proc->pid;
-}
+  if (vm_estado_solta_quadro(self->vm_estado, quadro) > 0
+      && vm_estado_quadro_dono(self->vm_estado, quadro) == espaco->pid) {
+    int outro = so_vm_mapeador(self, self->vivos_primeiro, pagina_virtual, quadro);
+    vm_estado_define_dono(self->vm_estado, quadro, outro >= 0 ? so_proc(self, outro)->pid : -1);
+  }
+  self->metricas_vm.copias_escrita++;
+  console_printf("SO: Cópia na escrita (proc %d, pagina %d, quadro %d -> %d)",
+                 espaco->pid, pagina_virtual, quadro, novo_quadro);
 
-static int so_proc_encontra_slot_livre(so_t *self)
-{
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    if (self->tabela_processos[i].estado == LIVRE) {
-      return i;
-    }
+  if (transferencias > 0) {
+    so_vm_bloqueia_transferencia(self, proc, tempo_atual, transferencias);
   }
-  return -1;
+  return true;
 }
 
-static bool so_proc_le_nome_programa(so_t *self, processo_t *criador, char nome[], int tam, bool *bloqueou)
+// aplica de uma vez às páginas de 'proc' os envelhecimentos atrasados desde a
+//   última vez que ele foi posto em dia
+// se o processo não executou nesses ticks ('executou' false), os bits de
+//   acesso ainda ligados foram ligados antes do primeiro deles, e entram só no
+//   primeiro deslocamento; se executou durante todos eles (o relógio sem tick
+//   periódico junta vários ticks numa interrupção), os acessos são
+//   considerados do último
+static void so_vm_envelhece_processo(so_t *self, processo_t *proc, bool executou)
 {
-  int ender_proc = criador->estado_cpu.regX;
-  return copia_str_da_mem(self, criador, tam, nome, ender_proc, bloqueou);
+  if (self->vm_estado == NULL || self->vm_quadros_proc == NULL
+      || proc->tabela_paginas == NULL) {
+    return;
+  }
+  unsigned long atraso = self->tick_relogio - proc->tick_envelhecimento;
+  if (atraso == 0) {
+    return;
+  }
+  proc->tick_envelhecimento = self->tick_relogio;
+  int deslocamento = atraso > VM_BITS_IDADE_MSB + 1 ? VM_BITS_IDADE_MSB + 1 : (int)atraso;
+  int n = tabpag_colhe_acessos(proc->tabela_paginas, self->vm_quadros_proc,
+                               self->vm_acessos_proc,
+                               vm_estado_num_quadros(self->vm_estado));
+  if (executou) {
+    vm_estado_envelhece_quadros(self->vm_estado, self->vm_quadros_proc,
+                                self->vm_acessos_proc, n, deslocamento, 0);
+  } else {
+    vm_estado_envelhece_quadros(self->vm_estado, self->vm_quadros_proc,
+                                self->vm_acessos_proc, n, 1, deslocamento - 1);
+  }
 }
 
-static void so_proc_configura_novo(so_t *self, processo_t *novo_proc, int ender_carga, int idx_tabela, int pid)
+// põe em dia as idades das páginas de todos os processos
+static void so_vm_envelhece_todos(so_t *self)
 {
-  so_inicializa_metricas_processo(self, novo_proc, pid, ender_carga);
-  novo_proc->terminal = D_TERM_A + ((idx_tabela % 4) * 4);
+  for (int i = self->vivos_primeiro; i != -1; i = so_proc(self, i)->vivo_prox) {
+    processo_t *proc = so_proc(self, i);
+    if (proc->estado == LIVRE || proc->estado == TERMINADO) continue;
+    so_vm_envelhece_processo(self, proc, false);
+  }
 }
 
-static void so_proc_inicializa_vm(so_t *self, processo_t *proc)
+// passaram 'ticks' ticks do relógio: só o processo em execução envelhece
+//   agora, com custo proporcional ao número de páginas dele; os demais
+//   acumulam o atraso
+static void so_vm_atualiza_idade_quadros(so_t *self, int ticks)
 {
-  if (proc == NULL) {
+  self->tick_relogio += ticks;
+  if (self->vm_estado == NULL) {
     return;
   }
-  if (proc->tabela_paginas != NULL) {
-    tabpag_destroi(proc->tabela_paginas);
-  }
-  proc->tabela_paginas = tabpag_cria();
-  proc->falhas_pagina = 0;
-  if (proc->indices_pagsec != NULL) {
-    free(proc->indices_pagsec);
+  if (self->processo_em_execucao_idx != -1) {
+    processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+    so_vm_envelhece_processo(self, so_vm_espaco(self, proc), true);
   }
-  proc->indices_pagsec = NULL;
-  proc->num_paginas_secundarias = 0;
-  proc->tamanho_programa = 0;
-  proc->end_virtual_base = 0;
-  proc->tempo_desbloqueio = 0;
 }
 
-static void so_proc_liberacao_recursos(so_t *self, processo_t *proc)
+// implementação da chamada se sistema SO_MATA_PROC
+// mata o processo com pid X (ou o processo corrente se X é 0)
+static void so_chamada_mata_proc(so_t *self)
 {
-  if (proc == NULL) {
-    return;
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *chamador = so_proc(self, self->processo_em_execucao_idx);
+  int pid_alvo = chamador->estado_cpu.regX; // PID do processo a matar
+
+  if (pid_alvo == 0) {
+    pid_alvo = chamador->pid;
   }
 
-  if (proc->tabela_paginas != NULL) {
-    tabpag_destroi(proc->tabela_paginas);
-    proc->tabela_paginas = NULL;
+  int idx_alvo = so_proc_busca_idx(self, pid_alvo);
+  if (idx_alvo == -1) {
+    console_printf("SO: Tentativa de matar processo inexistente ou já morto (PID %d)", pid_alvo);
+    chamador->estado_cpu.regA = -1; // Erro
+    return;
   }
 
-  if (self->vm_estado != NULL) {
-    int num_quadros = vm_estado_num_quadros(self->vm_estado);
-    for (int i = 0; i < num_quadros; i++) {
-      quadro_desc_t *q = vm_estado_quadro(self->vm_estado, i);
-      if (q == NULL) {
-        continue;
-      }
-      if (!q->livre && q->dono_pid == proc->pid) {
-        vm_estado_libera_quadro(self->vm_estado, i);
-      }
-    }
+  processo_t *proc_alvo = so_proc(self, idx_alvo);
+  if (proc_alvo->estado == LIVRE || proc_alvo->estado == TERMINADO) {
+    console_printf("SO: Tentativa de matar processo inexistente ou já morto (PID %d)", pid_alvo);
+    chamador->estado_cpu.regA = -1;
+    return;
+  }
 
-    int num_paginas_sec = vm_estado_num_paginas_sec(self->vm_estado);
-    for (int i = 0; i < num_paginas_sec; i++) {
-      pagina_sec_desc_t *p = vm_estado_pagina_sec(self->vm_estado, i);
-      if (p == NULL) {
-        continue;
-      }
-      if (p->ocupado && p->dono_pid == proc->pid) {
-        vm_estado_libera_pagsec(self->vm_estado, i);
-      }
-    }
+  // Muda o estado do processo alvo para TERMINADO
+  if (proc_alvo->estado == PRONTO) {
+    so_remove_de_pronto(self, idx_alvo);
   }
+  so_atualiza_estado(self, proc_alvo, TERMINADO);
+  so_proc_liberacao_recursos(self, proc_alvo);
+  console_printf("SO: Processo %d terminado.", pid_alvo);
 
-  if (proc->indices_pagsec != NULL) {
-    free(proc->indices_pagsec);
-    proc->indices_pagsec = NULL;
+  bool coletado = so_proc_desbloqueia_esperando(self, proc_alvo);
+  if (coletado) {
+     console_printf("SO: Processo %d foi coletado.", pid_alvo);
   }
-  proc->tamanho_programa = 0;
-  proc->end_virtual_base = 0;
-  proc->tempo_desbloqueio = 0;
-}
 
-static int so_proc_busca_idx(so_t *self, int pid)
-{
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    processo_t *proc = &self->tabela_processos[i];
-    if (proc->pid == pid && proc->estado != LIVRE) {
-      return i;
-    }
+  chamador->estado_cpu.regA = 0; // Sucesso
+
+  // --- Chamada do Relatório (Parte III) ---
+  if (pid_alvo == 1) { // Se o processo INIT (PID 1) morreu
+    so_imprime_relatorio_final(self);
+    // Para o sistema (opcional, mas bom para relatórios)
+    // self->erro_interno = true; // Descomente para parar a simulação
   }
-  return -1;
 }
 
-static bool so_proc_desbloqueia_esperando(so_t *self, processo_t *proc_alvo)
+// implementação da chamada se sistema SO_ESPERA_PROC
+// espera o fim do processo com pid X
+static void so_chamada_espera_proc(so_t *self)
 {
-  bool coletado = false;
-  int pid_alvo = proc_alvo->pid;
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *chamador = so_proc(self, self->processo_em_execucao_idx);
+  int pid_alvo = chamador->estado_cpu.regX;
 
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    processo_t *proc_esperando = &self->tabela_processos[i];
-    if (proc_esperando->estado != BLOQUEADO) {
-      continue;
-    }
-    if (proc_esperando->motivo_bloqueio != BLOQUEIO_PID) {
-      continue;
-    }
-    if (proc_esperando->pid_esperado != pid_alvo) {
-      continue;
-    }
+  // Erro: não pode esperar por si mesmo
+  if (pid_alvo == chamador->pid) {
+    console_printf("SO: Processo %d tentou esperar por si mesmo.", chamador->pid);
+    chamador->estado_cpu.regA = -1;
+    return;
+  }
 
-    console_printf("SO: Desbloqueando processo %d (esperava por %d).",
-                   proc_esperando->pid, pid_alvo);
-    so_atualiza_estado(self, proc_esperando, PRONTO);
-    proc_esperando->motivo_bloqueio = BLOQUEIO_NENHUM;
-    proc_esperando->estado_cpu.regA = 0;
-    so_insere_em_pronto(self, i);
+  // Erro: não pode esperar por PID 0 (inválido)
+  if (pid_alvo <= 0) {
+    console_printf("SO: Processo %d tentou esperar por PID inválido %d.", chamador->pid, pid_alvo);
+    chamador->estado_cpu.regA = -1;
+    return;
+  }
+
+  int idx_alvo = so_proc_busca_idx(self, pid_alvo);
+  if (idx_alvo == -1) {
+    console_printf("SO: Processo %d tentou esperar por PID inexistente %d.", chamador->pid, pid_alvo);
+    chamador->estado_cpu.regA = -1; // Erro
+    return;
+  }
 
+  processo_t *proc_alvo = so_proc(self, idx_alvo);
+  if (proc_alvo->estado == TERMINADO) {
+    console_printf("SO: Processo %d esperou por PID %d (já terminado). Coletando.",
+                   chamador->pid, pid_alvo);
     so_atualiza_estado(self, proc_alvo, LIVRE);
     so_proc_liberacao_recursos(self, proc_alvo);
-    coletado = true;
-    break;
+    chamador->estado_cpu.regA = 0;
+    return;
   }
 
-  return coletado;
+  console_printf("SO: Processo %d bloqueado esperando por PID %d.", chamador->pid, pid_alvo);
+  so_atualiza_estado(self, chamador, BLOQUEADO);
+  chamador->motivo_bloqueio = BLOQUEIO_PID;
+  chamador->pid_esperado = pid_alvo;
+  so_espera_insere(self, chamador);
+  // O regA não é definido agora, será definido quando for desbloqueado
 }
 
-// ---------------------------------------------------------------------
-// MEMÓRIA VIRTUAL {{{1
-// ---------------------------------------------------------------------
-
-static bool so_endereco_valido_para_processo(processo_t *proc, int endereco)
+// implementação da chamada se sistema SO_SBRK
+// aumenta a área válida do processo em X palavras
+static void so_chamada_sbrk(so_t *self)
 {
-  if (proc == NULL) {
-    return false;
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  // a área é do espaço de endereçamento, compartilhado pelas threads
+  processo_t *espaco = so_vm_espaco(self, proc);
+  int incremento = proc->estado_cpu.regX;
+
+  if (incremento < 0 || espaco->base_pagsec < 0) {
+    console_printf("SO: Processo %d pediu SO_SBRK inválido (%d).", proc->pid, incremento);
+    proc->estado_cpu.regA = -1;
+    return;
   }
-  if (proc->indices_pagsec == NULL) {
-    return false;
+
+  int fim_imagem = espaco->end_virtual_base + espaco->num_paginas_secundarias * TAM_PAGINA;
+  int novo_fim = espaco->fim_heap + incremento;
+  if (novo_fim - fim_imagem > CONFIG_TAM_MAX_HEAP) {
+    console_printf("SO: Processo %d excedeu o limite de SO_SBRK (%d palavras).",
+                   proc->pid, CONFIG_TAM_MAX_HEAP);
+    proc->estado_cpu.regA = -1;
+    return;
   }
-  if (proc->num_paginas_secundarias <= 0) {
-    return false;
+
+  // só cria descritores das páginas novas; quadros e slots ficam para depois
+  int paginas_heap = (novo_fim - fim_imagem + TAM_PAGINA - 1) / TAM_PAGINA;
+  if (paginas_heap > espaco->num_paginas_heap) {
+    int *slots = realloc(espaco->slots_heap, sizeof(int) * paginas_heap);
+    if (slots == NULL) {
+      proc->estado_cpu.regA = -1;
+      return;
+    }
+    for (int i = espaco->num_paginas_heap; i < paginas_heap; i++) {
+      slots[i] = -1;
+    }
+    espaco->slots_heap = slots;
+    espaco->num_paginas_heap = paginas_heap;
   }
 
-  int base = proc->end_virtual_base;
-  int limite = base + proc->num_paginas_secundarias * TAM_PAGINA;
-  if (endereco < base) {
-    return false;
+  proc->estado_cpu.regA = espaco->fim_heap;
+  espaco->fim_heap = novo_fim;
+  console_printf("SO: Processo %d cresceu %d palavras (fim em %d).", proc->pid, incremento, novo_fim);
+}
+
+// implementação da chamada de sistema SO_TEMPO_REAL
+// X aponta para período, orçamento e prazo, em ticks do relógio
+static void so_chamada_tempo_real(so_t *self)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+
+  int param[3];
+  bool bloqueou_mem = false;
+  for (int i = 0; i < 3; i++) {
+    if (!so_le_palavra_da_mem(self, proc, proc->estado_cpu.regX + i, &param[i], &bloqueou_mem)) {
+      if (bloqueou_mem) {
+        return;
+      }
+      console_printf("SO: Erro ao ler os parâmetros de tempo real do processo %d.", proc->pid);
+      proc->estado_cpu.regA = -1;
+      return;
+    }
   }
-  if (endereco >= limite) {
-    return false;
+  int periodo = param[0];
+  int orcamento = param[1];
+  int prazo = param[2];
+
+  if (orcamento <= 0 || orcamento > prazo || prazo > periodo) {
+    console_printf("SO: Processo %d pediu tempo real inválido (período %d, orçamento %d, prazo %d).",
+                   proc->pid, periodo, orcamento, prazo);
+    proc->estado_cpu.regA = -1;
+    return;
   }
-  return true;
+  if (!so_edf_admite(self, proc, orcamento, prazo)) {
+    console_printf("SO: EDF: processo %d recusado no teste de admissão.", proc->pid);
+    proc->estado_cpu.regA = -1;
+    return;
+  }
+
+  proc->tempo_real = true;
+  proc->rt_periodo = periodo * INTERVALO_INTERRUPCAO;
+  proc->rt_orcamento = orcamento * INTERVALO_INTERRUPCAO;
+  proc->rt_prazo = prazo * INTERVALO_INTERRUPCAO;
+  int agora = so_get_tempo(self);
+  so_edf_inicia_periodo(proc, agora);
+  // deixa de ser contado pela classe do escalonador configurado
+  self->quantum_restante = 0;
+  self->edf_inicio_contabilizacao = agora;
+  console_printf("SO: EDF: processo %d é de tempo real (período %d, orçamento %d, prazo %d ticks).",
+                 proc->pid, periodo, orcamento, prazo);
+  proc->estado_cpu.regA = 0;
 }
 
-static int so_vm_agenda_transferencia(so_t *self, int tempo_atual, int transferencias)
+// implementação da chamada de sistema SO_FIM_PERIODO
+static void so_chamada_fim_periodo(so_t *self)
 {
-  if (transferencias <= 0) {
-    return tempo_atual;
-  }
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
 
-  int inicio = tempo_atual;
-  if (self->tempo_disponivel_memsec > inicio) {
-    inicio = self->tempo_disponivel_memsec;
+  if (!proc->tempo_real) {
+    console_printf("SO: Processo %d não é de tempo real (SO_FIM_PERIODO).", proc->pid);
+    proc->estado_cpu.regA = -1;
+    return;
   }
 
-  int fim = inicio + transferencias * self->tempo_transferencia_pagina;
-  self->tempo_disponivel_memsec = fim;
-  self->metricas_vm.transferencias_paginas += transferencias;
-  return fim;
+  int agora = so_get_tempo(self);
+  so_edf_registra_fim_trabalho(proc, agora);
+  proc->estado_cpu.regA = 0;
+
+  int proximo = proc->rt_liberacao + proc->rt_periodo;
+  if (proximo <= agora) {
+    // atrasado: o período do trabalho seguinte já começou
+    so_edf_inicia_periodo(proc, proximo);
+    return;
+  }
+  proc->rt_prazo_abs = -1;
+  so_edf_espera_periodo(self, proc);
 }
 
-static int so_vm_escolhe_quadro_para_carregar(so_t *self)
+
+// ---------------------------------------------------------------------
+// CARGA DE PROGRAMA {{{1
+// ---------------------------------------------------------------------
+
+// carrega o programa na memória
+// - se destino == NULL, carrega diretamente na memória física (uso interno: BIOS, tratadores)
+// - caso contrário, grava o conteúdo na memória secundária e registra metadados no processo,
+//   que fica com uma referência ao programa na cache de programas
+// o programa vem da cache; o arquivo só é lido na primeira vez ou se mudou
+// retorna o endereço virtual inicial ou -1 em erro
+static int so_carrega_programa(so_t *self, char *nome_do_executavel, processo_t *destino)
 {
-  if (self == NULL || self->vm_estado == NULL) {
+  programa_t *prog = cacheprog_obtem(self->cache_programas, nome_do_executavel);
+  if (prog == NULL) {
+    console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
     return -1;
   }
 
-  int num_quadros = vm_estado_num_quadros(self->vm_estado);
+  int end_ini = prog_end_carga(prog);
+  int tam_prog = prog_tamanho(prog);
+  int end_fim = end_ini + tam_prog;
 
-  for (int i = 0; i < num_quadros; i++) {
-    quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, i);
-    if (quadro == NULL) {
-      continue;
-    }
-    if (quadro->livre) {
-      return i;
+  if (destino == NULL) {
+    for (int end = end_ini; end < end_fim; end++) {
+      if (mem_escreve(self->mem, end, prog_dado(prog, end)) != ERR_OK) {
+        console_printf("Erro na carga da memória, endereco %d\n", end);
+        cacheprog_libera(self->cache_programas, prog);
+        return -1;
+      }
     }
+    cacheprog_libera(self->cache_programas, prog);
+    console_printf("SO: carga fisica de '%s' em %d-%d", nome_do_executavel, end_ini, end_fim);
+    return end_ini;
   }
 
-  if (self->algoritmo_substituicao == SUBSTITUICAO_FIFO) {
-    int escolhido = -1;
-    unsigned long melhor_carimbo = 0;
-    bool inicializado = false;
-
-    for (int i = 0; i < num_quadros; i++) {
-      quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, i);
-      if (quadro == NULL || quadro->livre || quadro->dono_pid < 0) {
-        continue;
-      }
-      if (!inicializado || quadro->carimbo_fifo < melhor_carimbo) {
-        melhor_carimbo = quadro->carimbo_fifo;
-        escolhido = i;
-        inicializado = true;
-      }
-    }
+  if (self->vm_estado == NULL) {
+    console_printf("SO: memória secundária indisponível para carregar '%s'", nome_do_executavel);
+    cacheprog_libera(self->cache_programas, prog);
+    return -1;
+  }
 
-    return escolhido;
+  int num_paginas = (tam_prog + TAM_PAGINA - 1) / TAM_PAGINA;
+  if (num_paginas <= 0) {
+    num_paginas = 1;
   }
 
-  int escolhido = -1;
-  unsigned long melhor_idade = 0;
-  bool inicializado = false;
+  // a imagem inteira vai para uma extensão contígua, escrita de uma vez
+  int base_slot = vm_estado_aloca_extensao(self->vm_estado, num_paginas);
+  if (base_slot < 0) {
+    console_printf("SO: memória secundária insuficiente para '%s'", nome_do_executavel);
+    cacheprog_libera(self->cache_programas, prog);
+    return -1;
+  }
 
-  for (int i = 0; i < num_quadros; i++) {
-    quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, i);
-    if (quadro == NULL || quadro->livre || quadro->dono_pid < 0) {
-      continue;
-    }
-    if (!inicializado || quadro->idade < melhor_idade) {
-      melhor_idade = quadro->idade;
-      escolhido = i;
-      inicializado = true;
+  for (int pagina = 0; pagina < num_paginas; pagina++) {
+    int deslocamento_pagina = pagina * TAM_PAGINA;
+    int restante = tam_prog - deslocamento_pagina;
+    int tamanho_util = TAM_PAGINA;
+    if (restante > 0 && restante < TAM_PAGINA) {
+      tamanho_util = restante;
     }
+    int slot = base_slot + pagina;
+    vm_estado_ocupa_pagsec(self->vm_estado, slot, destino->pid, pagina, slot * TAM_PAGINA, tamanho_util);
+  }
+
+  // os dados vêm direto da cópia do programa na cache; só o resto da última
+  //   página é completado com zeros
+  int tam_imagem = num_paginas * TAM_PAGINA;
+  int zeros[TAM_PAGINA] = { 0 };
+  int base_sec = base_slot * TAM_PAGINA;
+  err_t err = vm_estado_sec_escreve_bloco(self->vm_estado, base_sec, prog_dados(prog), tam_prog);
+  if (err == ERR_OK && tam_imagem > tam_prog) {
+    err = vm_estado_sec_escreve_bloco(self->vm_estado, base_sec + tam_prog, zeros, tam_imagem - tam_prog);
+  }
+  if (err != ERR_OK) {
+    console_printf("SO: erro ao escrever memória secundária (%s)", nome_do_executavel);
+    vm_estado_libera_extensao(self->vm_estado, base_slot, num_paginas);
+    cacheprog_libera(self->cache_programas, prog);
+    return -1;
   }
 
-  return escolhido;
-}
-
-static bool so_vm_salva_quadro(so_t *self, int indice_quadro, int *transferencias)
-{
-  if (self == NULL || self->vm_estado == NULL) {
-    return false;
+  if (destino->base_pagsec >= 0) {
+    vm_estado_libera_extensao(self->vm_estado, destino->base_pagsec, destino->num_paginas_secundarias);
   }
-
-  quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, indice_quadro);
-  if (quadro == NULL) {
-    return false;
+  if (destino->programa != NULL) {
+    cacheprog_libera(self->cache_programas, destino->programa);
   }
+  destino->programa = prog;
+  destino->base_pagsec = base_slot;
+  destino->num_paginas_secundarias = num_paginas;
+  destino->tamanho_programa = tam_prog;
+  destino->end_virtual_base = end_ini;
+  destino->fim_heap = end_ini + num_paginas * TAM_PAGINA;
 
-  if (quadro->livre) {
-    vm_estado_libera_quadro(self->vm_estado, indice_quadro);
-    return true;
-  }
+  console_printf("SO: carga de '%s' em memoria secundaria (%d paginas)", nome_do_executavel, num_paginas);
+  return end_ini;
+}
 
-  if (quadro->dono_pid < 0 || quadro->pagina_virtual < 0) {
-    return false;
-  }
 
-  int pid_dono = quadro->dono_pid;
-  int pagina_virtual = quadro->pagina_virtual;
-  int idx_proc = so_proc_busca_idx(self, pid_dono);
-  processo_t *proc_dono = idx_proc >= 0 ? &self->tabela_processos[idx_proc] : NULL;
+// ---------------------------------------------------------------------
+// ARQUIVOS {{{1
+// ---------------------------------------------------------------------
 
-  bool precisa_gravar = false;
-  int slot_secundario = -1;
+// funções auxiliares da cache de blocos e do sistema de arquivos
+static void so_cache_suja(so_t *self, cache_bloco_t *ent);
+static void so_cache_antecipa_gravacao(so_t *self);
+static cache_bloco_t *so_fs_bloco(so_t *self, processo_t *proc, int bloco, bool le, bool *bloqueou);
+static cache_bloco_t *so_fs_entrada(so_t *self, processo_t *proc, int n, int *pos, bool *bloqueou);
+static arquivo_t *so_arq_descritor(processo_t *proc, int fd);
 
-  if (proc_dono != NULL && proc_dono->tabela_paginas != NULL && pagina_virtual >= 0) {
-    precisa_gravar = tabpag_bit_alteracao(proc_dono->tabela_paginas, pagina_virtual);
-    tabpag_invalida_pagina(proc_dono->tabela_paginas, pagina_virtual);
+// --- Cache de blocos do disco ---
 
-    if (proc_dono->indices_pagsec != NULL && pagina_virtual < proc_dono->num_paginas_secundarias) {
-      slot_secundario = proc_dono->indices_pagsec[pagina_virtual];
+// entrada da cache com o bloco 'bloco' (em qualquer estado), ou -1
+static int so_cache_busca(so_t *self, int bloco)
+{
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    if (self->cache_disco[e].estado != CACHE_LIVRE && self->cache_disco[e].bloco == bloco) {
+      return e;
     }
   }
+  return -1;
+}
 
-  if (precisa_gravar && slot_secundario < 0) {
-    return false;
-  }
-
-  if (precisa_gravar) {
-    int base_sec = slot_secundario * TAM_PAGINA;
-    int base_fis = indice_quadro * TAM_PAGINA;
-
-    for (int offset = 0; offset < TAM_PAGINA; offset++) {
-      int valor = 0;
-      if (mem_le(self->mem, base_fis + offset, &valor) != ERR_OK) {
-        return false;
-      }
-      if (vm_estado_sec_escreve(self->vm_estado, base_sec + offset, valor) != ERR_OK) {
-        return false;
-      }
+// entrada a reusar para outro bloco: uma livre, ou a válida e não alterada
+//   usada há mais tempo (LRU); a usada por último fica, porque a chamada em
+//   andamento pode estar com ela; -1 se nenhuma pode ser reusada (estão sendo
+//   lidas ou esperando gravação)
+static int so_cache_vitima(so_t *self)
+{
+  int vitima = -1;
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    cache_bloco_t *ent = &self->cache_disco[e];
+    if (ent->estado == CACHE_LIVRE) {
+      return e;
     }
-
-    if (transferencias != NULL) {
-      (*transferencias)++;
+    if (ent->estado == CACHE_VALIDO && !ent->sujo && ent->uso != self->cache_relogio
+        && (vitima == -1 || ent->uso < self->cache_disco[vitima].uso)) {
+      vitima = e;
     }
   }
-
-  vm_estado_libera_quadro(self->vm_estado, indice_quadro);
-  return true;
+  return vitima;
 }
 
-static bool so_vm_carrega_pagina(so_t *self, processo_t *proc, int pagina_virtual, int indice_quadro, int tempo_carimbo)
+// registra uma alteração no bloco da entrada, que vai ser gravado
+//   CONFIG_CACHE_ATRASO_GRAVACAO depois da primeira; as alterações seguintes
+//   são absorvidas por essa gravação
+static void so_cache_suja(so_t *self, cache_bloco_t *ent)
 {
-  if (self == NULL || self->vm_estado == NULL || proc == NULL) {
-    return false;
-  }
-  if (proc->indices_pagsec == NULL) {
-    return false;
-  }
-  if (pagina_virtual < 0 || pagina_virtual >= proc->num_paginas_secundarias) {
-    return false;
+  if (ent->sujo) {
+    self->metricas.cache_absorvidas++;
+    return;
   }
+  ent->sujo = true;
+  ent->sujo_desde = so_get_tempo(self);
+}
 
-  int slot_secundario = proc->indices_pagsec[pagina_virtual];
-  if (slot_secundario < 0) {
-    return false;
+// faz os blocos alterados serem gravados assim que o disco estiver livre,
+//   sem esperar o fim do atraso
+static void so_cache_antecipa_gravacao(so_t *self)
+{
+  int limite = so_get_tempo(self) - CONFIG_CACHE_ATRASO_GRAVACAO;
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    cache_bloco_t *ent = &self->cache_disco[e];
+    if (ent->sujo && ent->sujo_desde > limite) {
+      ent->sujo_desde = limite;
+    }
   }
+}
 
-  int base_sec = slot_secundario * TAM_PAGINA;
-  int base_fis = indice_quadro * TAM_PAGINA;
-
-  for (int offset = 0; offset < TAM_PAGINA; offset++) {
-    int valor = 0;
-    if (vm_estado_sec_le(self->vm_estado, base_sec + offset, &valor) != ERR_OK) {
-      return false;
-    }
-    if (mem_escreve(self->mem, base_fis + offset, valor) != ERR_OK) {
-      return false;
+// inicia a próxima operação no disco, se ele está livre: a leitura pedida
+//   há mais tempo, ou, sem leituras, a gravação do bloco alterado há mais
+//   tempo, se já passou o atraso
+static void so_disco_inicia(so_t *self)
+{
+  if (self->disco_op != 0) {
+    return;
+  }
+  int limite = so_get_tempo(self) - CONFIG_CACHE_ATRASO_GRAVACAO;
+  int leitura = -1;
+  int gravacao = -1;
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    cache_bloco_t *ent = &self->cache_disco[e];
+    if (ent->estado == CACHE_PEDIDO) {
+      if (leitura == -1 || ent->uso < self->cache_disco[leitura].uso) leitura = e;
+    } else if (ent->estado == CACHE_VALIDO && ent->sujo && ent->sujo_desde <= limite) {
+      if (gravacao == -1 || ent->sujo_desde < self->cache_disco[gravacao].sujo_desde) gravacao = e;
     }
   }
-
-  vm_estado_ocupa_quadro(self->vm_estado, indice_quadro, proc->pid, pagina_virtual, (unsigned long)tempo_carimbo);
-
-  quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, indice_quadro);
-  if (quadro != NULL) {
-    quadro->idade = LRU_MSB_MASK;
+  int e = leitura != -1 ? leitura : gravacao;
+  if (e == -1) {
+    return;
   }
 
-  if (proc->tabela_paginas == NULL) {
-    return false;
+  cache_bloco_t *ent = &self->cache_disco[e];
+  bool ok = es_escreve(self->es, D_DISCO_BLOCO, ent->bloco) == ERR_OK;
+  if (e == leitura) {
+    ent->estado = CACHE_LENDO;
+    self->disco_op = DISCO_LE;
+  } else {
+    for (int i = 0; i < DISCO_TAM_BLOCO && ok; i++) {
+      ok = es_escreve(self->es, D_DISCO_DADO, ent->dados[i]) == ERR_OK;
+    }
+    ent->sujo = false;
+    self->disco_op = DISCO_GRAVA;
+  }
+  self->disco_entrada = e;
+  if (!ok || es_escreve(self->es, D_DISCO_COMANDO, self->disco_op) != ERR_OK) {
+    console_printf("SO: problema no acesso ao disco (bloco %d)", ent->bloco);
+    self->erro_interno = true;
   }
-  tabpag_define_quadro(proc->tabela_paginas, pagina_virtual, indice_quadro);
-  return true;
 }
 
-static bool so_atende_falta_pagina(so_t *self, processo_t *proc)
+#ifdef CONFIG_RELOGIO_SEM_TICK
+// instante em que termina o atraso de gravação do bloco alterado há mais
+//   tempo, se o disco está livre; -1 se não há o que gravar (ou se o disco
+//   está ocupado, e vai interromper no fim da operação)
+static int so_disco_proxima_gravacao(so_t *self)
 {
-  if (self == NULL || proc == NULL || self->vm_estado == NULL) {
-    return false;
+  if (self->disco_op != 0) {
+    return -1;
   }
-
-  int endereco = proc->estado_cpu.complemento;
-  if (!so_endereco_valido_para_processo(proc, endereco)) {
-    return false;
+  int alvo = -1;
+  for (int e = 0; e < CONFIG_CACHE_BLOCOS; e++) {
+    cache_bloco_t *ent = &self->cache_disco[e];
+    if (ent->estado == CACHE_VALIDO && ent->sujo
+        && (alvo == -1 || ent->sujo_desde + CONFIG_CACHE_ATRASO_GRAVACAO < alvo)) {
+      alvo = ent->sujo_desde + CONFIG_CACHE_ATRASO_GRAVACAO;
+    }
   }
+  return alvo;
+}
+#endif
 
-  int pagina_virtual = (endereco - proc->end_virtual_base) / TAM_PAGINA;
-  int tempo_atual = so_get_tempo(self);
-  int transferencias = 1; // leitura obrigatória da página faltante
+// bloqueia 'proc' esperando o disco: pela leitura do bloco 'bloco', ou por uma
+//   entrada da cache que possa ser reusada se 'bloco' é -1; o PC volta para o
+//   CHAMAS, e a chamada é refeita quando ele for desbloqueado
+static void so_disco_bloqueia(so_t *self, processo_t *proc, int bloco)
+{
+  console_printf("SO: Processo %d bloqueado esperando o disco (bloco %d)", proc->pid, bloco);
+  so_atualiza_estado(self, proc, BLOQUEADO);
+  proc->motivo_bloqueio = BLOQUEIO_DISCO;
+  proc->dispositivo_esperado = bloco;
+  proc->estado_cpu.regPC -= 1;
+  proc->disco_inicio_espera = so_get_tempo(self);
+  proc->disco_refaz = true;
+  so_espera_insere(self, proc);
+}
 
-  int indice_quadro = vm_estado_busca_quadro_livre(self->vm_estado);
-  if (indice_quadro < 0) {
-    indice_quadro = so_vm_escolhe_quadro_para_carregar(self);
-    if (indice_quadro < 0) {
-      return false;
+// entrada da cache com o bloco 'bloco' do disco, para uma chamada de sistema
+//   de 'proc'; se o bloco não está na cache, uma entrada é reservada para ele
+//   e, com 'le', a leitura é pedida ao disco e o processo bloqueia até ela
+//   terminar (retorna NULL com *bloqueou true); sem 'le' (o bloco vai ser
+//   escrito a partir do início), a entrada começa zerada, sem leitura
+// se nenhuma entrada pode ser reusada, os blocos alterados são gravados sem
+//   esperar o atraso, e o processo bloqueia até o disco terminar uma operação
+// retorna NULL com *bloqueou false se o bloco não existe
+static cache_bloco_t *so_fs_bloco(so_t *self, processo_t *proc, int bloco, bool le, bool *bloqueou)
+{
+  *bloqueou = false;
+  if (bloco < 0 || bloco >= CONFIG_DISCO_BLOCOS) {
+    return NULL;
+  }
+  // o primeiro acesso de uma chamada refeita é o que a fez bloquear, e já foi
+  //   contado
+  bool conta = !proc->disco_refaz;
+  proc->disco_refaz = false;
+
+  int e = so_cache_busca(self, bloco);
+  if (e != -1 && self->cache_disco[e].estado == CACHE_VALIDO) {
+    if (conta) self->metricas.cache_acertos++;
+    self->cache_disco[e].uso = ++self->cache_relogio;
+    return &self->cache_disco[e];
+  }
+  if (conta) self->metricas.cache_faltas++;
+
+  if (e == -1) {
+    e = so_cache_vitima(self);
+    if (e == -1) {
+      so_cache_antecipa_gravacao(self);
+      so_disco_inicia(self);
+      so_disco_bloqueia(self, proc, -1);
+      *bloqueou = true;
+      return NULL;
     }
-    if (!so_vm_salva_quadro(self, indice_quadro, &transferencias)) {
-      int indice_alternativo = so_vm_escolhe_quadro_para_carregar(self);
-      if (indice_alternativo < 0) {
-        return false;
-      }
-      indice_quadro = indice_alternativo;
-      if (!so_vm_salva_quadro(self, indice_quadro, &transferencias)) {
-        return false;
+    cache_bloco_t *ent = &self->cache_disco[e];
+    ent->bloco = bloco;
+    ent->sujo = false;
+    ent->uso = ++self->cache_relogio;
+    if (!le) {
+      for (int i = 0; i < DISCO_TAM_BLOCO; i++) {
+        ent->dados[i] = 0;
       }
+      ent->estado = CACHE_VALIDO;
+      return ent;
     }
+    ent->estado = CACHE_PEDIDO;
+    so_disco_inicia(self);
   }
+  // o bloco está sendo lido, a pedido deste ou de outro processo
+  so_disco_bloqueia(self, proc, bloco);
+  *bloqueou = true;
+  return NULL;
+}
 
-  if (!so_vm_carrega_pagina(self, proc, pagina_virtual, indice_quadro, tempo_atual)) {
-    return false;
-  }
-
-  int tempo_desbloqueio = so_vm_agenda_transferencia(self, tempo_atual, transferencias);
-
-  proc->falhas_pagina++;
-  self->metricas_vm.falhas_pagina_total++;
-  proc->estado_cpu.regERRO = ERR_OK;
-  proc->motivo_bloqueio = BLOQUEIO_PAGINA;
-  proc->tempo_desbloqueio = tempo_desbloqueio;
-  proc->pid_esperado = -1;
-  proc->dispositivo_esperado = -1;
-
-  so_atualiza_estado(self, proc, BLOQUEADO);
-
-  console_printf("SO: Falta de pagina atendida (proc %d, pagina %d -> quadro %d)",
-                 proc->pid, pagina_virtual, indice_quadro);
+// --- Sistema de arquivos ---
 
-  return true;
+// bloco do diretório (na cache, como em so_fs_bloco) com a entrada 'n', que
+//   está a partir da posição *pos dele
+static cache_bloco_t *so_fs_entrada(so_t *self, processo_t *proc, int n, int *pos, bool *bloqueou)
+{
+  *pos = (n % FS_ENTRADAS_POR_BLOCO) * FS_TAM_ENTRADA;
+  return so_fs_bloco(self, proc, 1 + n / FS_ENTRADAS_POR_BLOCO, true, bloqueou);
 }
 
-static void so_vm_atualiza_idade_quadros(so_t *self)
+// true se a entrada do diretório 'ent' tem o nome 'nome'
+static bool so_fs_nome_igual(int *ent, char *nome)
 {
-  if (self == NULL || self->vm_estado == NULL) {
-    return;
-  }
-
-  int num_quadros = vm_estado_num_quadros(self->vm_estado);
-  for (int i = 0; i < num_quadros; i++) {
-    quadro_desc_t *quadro = vm_estado_quadro(self->vm_estado, i);
-    if (quadro == NULL || quadro->livre) {
-      continue;
-    }
-
-    quadro->idade >>= 1;
-
-    bool acessada = false;
-    if (quadro->dono_pid > 0 && quadro->pagina_virtual >= 0) {
-      int idx_proc = so_proc_busca_idx(self, quadro->dono_pid);
-      if (idx_proc >= 0) {
-        processo_t *proc = &self->tabela_processos[idx_proc];
-        if (proc->tabela_paginas != NULL) {
-          acessada = tabpag_bit_acesso(proc->tabela_paginas, quadro->pagina_virtual);
-          tabpag_zera_bit_acesso(proc->tabela_paginas, quadro->pagina_virtual);
-        }
-      }
+  for (int i = 0; i < FS_TAM_NOME; i++) {
+    if (ent[FS_ENT_NOME + i] != nome[i]) {
+      return false;
     }
-
-    if (acessada) {
-      quadro->idade |= LRU_MSB_MASK;
+    if (nome[i] == '\0') {
+      return true;
     }
   }
+  return nome[FS_TAM_NOME] == '\0';
 }
 
-// implementação da chamada se sistema SO_MATA_PROC
-// mata o processo com pid X (ou o processo corrente se X é 0)
-static void so_chamada_mata_proc(so_t *self)
+// descritor 'fd' de 'proc', se é de um arquivo aberto; senão NULL
+static arquivo_t *so_arq_descritor(processo_t *proc, int fd)
 {
-  if (self->processo_em_execucao_idx == -1) return;
-  processo_t *chamador = &self->tabela_processos[self->processo_em_execucao_idx];
-  int pid_alvo = chamador->estado_cpu.regX; // PID do processo a matar
-
-  if (pid_alvo == 0) {
-    pid_alvo = chamador->pid;
+  if (fd < 0 || fd >= CONFIG_ARQUIVOS_POR_PROCESSO || proc->arquivos[fd].entrada < 0) {
+    return NULL;
   }
+  return &proc->arquivos[fd];
+}
 
-  int idx_alvo = so_proc_busca_idx(self, pid_alvo);
-  if (idx_alvo == -1) {
-    console_printf("SO: Tentativa de matar processo inexistente ou já morto (PID %d)", pid_alvo);
-    chamador->estado_cpu.regA = -1; // Erro
-    return;
+// fecha o descritor 'fd' de 'proc'; o que foi escrito no arquivo passa a ser
+//   gravado no disco sem esperar o atraso
+static void so_arq_fecha(so_t *self, processo_t *proc, int fd)
+{
+  if (proc->arq_entrada == fd) proc->arq_entrada = -1;
+  if (proc->arq_saida == fd) proc->arq_saida = -1;
+  bool escrita = proc->arquivos[fd].modo == 1;
+  proc->arquivos[fd].entrada = -1;
+  if (escrita) {
+    so_cache_antecipa_gravacao(self);
+    so_disco_inicia(self);
   }
+}
 
-  processo_t *proc_alvo = &self->tabela_processos[idx_alvo];
-  if (proc_alvo->estado == LIVRE || proc_alvo->estado == TERMINADO) {
-    console_printf("SO: Tentativa de matar processo inexistente ou já morto (PID %d)", pid_alvo);
-    chamador->estado_cpu.regA = -1;
-    return;
+// lê em *dado a palavra na posição corrente do arquivo 'arq' de 'proc', sem
+//   avançar a posição (para que a chamada possa ser refeita depois de uma
+//   falta de página); retorna false no fim do arquivo, ou se bloqueou
+//   esperando o disco (*bloqueou true)
+static bool so_arq_le_palavra(so_t *self, processo_t *proc, arquivo_t *arq, int *dado, bool *bloqueou)
+{
+  int pos;
+  cache_bloco_t *dir = so_fs_entrada(self, proc, arq->entrada, &pos, bloqueou);
+  if (dir == NULL || arq->posicao >= dir->dados[pos + FS_ENT_TAMANHO]) {
+    return false;
   }
-
-  // Muda o estado do processo alvo para TERMINADO
-  so_atualiza_estado(self, proc_alvo, TERMINADO);
-  so_proc_liberacao_recursos(self, proc_alvo);
-  console_printf("SO: Processo %d terminado.", pid_alvo);
-
-  bool coletado = so_proc_desbloqueia_esperando(self, proc_alvo);
-  if (coletado) {
-     console_printf("SO: Processo %d foi coletado.", pid_alvo);
+  int bloco = dir->dados[pos + FS_ENT_INICIO] + arq->posicao / DISCO_TAM_BLOCO;
+  cache_bloco_t *dados = so_fs_bloco(self, proc, bloco, true, bloqueou);
+  if (dados == NULL) {
+    return false;
   }
+  *dado = dados->dados[arq->posicao % DISCO_TAM_BLOCO];
+  return true;
+}
 
-  chamador->estado_cpu.regA = 0; // Sucesso
-
-  // --- Chamada do Relatório (Parte III) ---
-  if (pid_alvo == 1) { // Se o processo INIT (PID 1) morreu
-    so_imprime_relatorio_final(self);
-    // Para o sistema (opcional, mas bom para relatórios)
-    // self->erro_interno = true; // Descomente para parar a simulação
+// escreve 'dado' na posição corrente do arquivo 'arq' de 'proc', avança a
+//   posição e aumenta o tamanho do arquivo se ela passou do fim; retorna false
+//   se o arquivo não pode crescer mais, ou se bloqueou esperando o disco
+//   (*bloqueou true)
+static bool so_arq_escreve_palavra(so_t *self, processo_t *proc, arquivo_t *arq, int dado, bool *bloqueou)
+{
+  int pos;
+  cache_bloco_t *dir = so_fs_entrada(self, proc, arq->entrada, &pos, bloqueou);
+  if (dir == NULL) {
+    return false;
+  }
+  int *ent = &dir->dados[pos];
+  if (arq->posicao >= ent[FS_ENT_BLOCOS] * DISCO_TAM_BLOCO) {
+    return false;
+  }
+  // um bloco escrito a partir do início, depois do fim do arquivo, não tem o
+  //   que ser lido do disco
+  bool le = arq->posicao % DISCO_TAM_BLOCO != 0 || arq->posicao < ent[FS_ENT_TAMANHO];
+  int bloco = ent[FS_ENT_INICIO] + arq->posicao / DISCO_TAM_BLOCO;
+  cache_bloco_t *dados = so_fs_bloco(self, proc, bloco, le, bloqueou);
+  if (dados == NULL) {
+    return false;
+  }
+  dados->dados[arq->posicao % DISCO_TAM_BLOCO] = dado;
+  so_cache_suja(self, dados);
+  arq->posicao++;
+  if (arq->posicao > ent[FS_ENT_TAMANHO]) {
+    ent[FS_ENT_TAMANHO] = arq->posicao;
+    so_cache_suja(self, dir);
   }
+  return true;
 }
 
-// implementação da chamada se sistema SO_ESPERA_PROC
-// espera o fim do processo com pid X
-static void so_chamada_espera_proc(so_t *self)
+// implementação da chamada de sistema SO_ABRE
+// o diretório inteiro é percorrido (procurando o nome, uma entrada livre e o
+//   fim do último arquivo, depois do qual é criado um arquivo novo) antes de
+//   qualquer alteração, para que a chamada possa ser refeita depois de
+//   esperar o disco
+static void so_chamada_abre(so_t *self)
 {
   if (self->processo_em_execucao_idx == -1) return;
-  processo_t *chamador = &self->tabela_processos[self->processo_em_execucao_idx];
-  int pid_alvo = chamador->estado_cpu.regX;
-
-  // Erro: não pode esperar por si mesmo
-  if (pid_alvo == chamador->pid) {
-    console_printf("SO: Processo %d tentou esperar por si mesmo.", chamador->pid);
-    chamador->estado_cpu.regA = -1;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int ender = proc->estado_cpu.regX;
+  bool bloqueou = false;
+
+  int modo;
+  char nome[FS_TAM_NOME + 1];
+  if (!so_le_palavra_da_mem(self, proc, ender, &modo, &bloqueou)
+      || !copia_str_da_mem(self, proc, sizeof(nome), nome, ender + 1, &bloqueou)) {
+    if (!bloqueou) {
+      console_printf("SO: Processo %d passou modo ou nome de arquivo inválido para SO_ABRE", proc->pid);
+      proc->estado_cpu.regA = -1;
+    }
+    return;
+  }
+  int fd = 0;
+  while (fd < CONFIG_ARQUIVOS_POR_PROCESSO && proc->arquivos[fd].entrada >= 0) {
+    fd++;
+  }
+  if ((modo != 0 && modo != 1) || nome[0] == '\0' || fd == CONFIG_ARQUIVOS_POR_PROCESSO) {
+    console_printf("SO: Processo %d não pode abrir '%s' (modo %d)", proc->pid, nome, modo);
+    proc->estado_cpu.regA = -1;
     return;
   }
 
-  // Erro: não pode esperar por PID 0 (inválido)
-  if (pid_alvo <= 0) {
-    console_printf("SO: Processo %d tentou esperar por PID inválido %d.", chamador->pid, pid_alvo);
-    chamador->estado_cpu.regA = -1;
+  cache_bloco_t *super = so_fs_bloco(self, proc, 0, true, &bloqueou);
+  if (super == NULL) {
     return;
   }
+  if (super->dados[FS_SB_MAGICO] != FS_MAGICO) {
+    console_printf("SO: o disco não tem um sistema de arquivos (use cria_disco)");
+    proc->estado_cpu.regA = -1;
+    return;
+  }
+  int num_blocos = super->dados[FS_SB_BLOCOS];
+  if (num_blocos > CONFIG_DISCO_BLOCOS) num_blocos = CONFIG_DISCO_BLOCOS;
+
+  int achada = -1;
+  int livre = -1;
+  int fim = FS_PRIMEIRO_BLOCO_DADOS;
+  for (int n = 0; n < FS_NUM_ENTRADAS; n++) {
+    int pos;
+    cache_bloco_t *dir = so_fs_entrada(self, proc, n, &pos, &bloqueou);
+    if (dir == NULL) {
+      return;
+    }
+    int *ent = &dir->dados[pos];
+    if (ent[FS_ENT_INICIO] == 0) {
+      if (livre == -1) livre = n;
+      continue;
+    }
+    if (ent[FS_ENT_INICIO] + ent[FS_ENT_BLOCOS] > fim) {
+      fim = ent[FS_ENT_INICIO] + ent[FS_ENT_BLOCOS];
+    }
+    if (achada == -1 && so_fs_nome_igual(ent, nome)) {
+      achada = n;
+    }
+  }
 
-  int idx_alvo = so_proc_busca_idx(self, pid_alvo);
-  if (idx_alvo == -1) {
-    console_printf("SO: Processo %d tentou esperar por PID inexistente %d.", chamador->pid, pid_alvo);
-    chamador->estado_cpu.regA = -1; // Erro
+  if (achada == -1 && modo == 0) {
+    console_printf("SO: Processo %d: arquivo '%s' não existe", proc->pid, nome);
+    proc->estado_cpu.regA = -1;
     return;
   }
-
-  processo_t *proc_alvo = &self->tabela_processos[idx_alvo];
-  if (proc_alvo->estado == TERMINADO) {
-    console_printf("SO: Processo %d esperou por PID %d (já terminado). Coletando.",
-                   chamador->pid, pid_alvo);
-    so_atualiza_estado(self, proc_alvo, LIVRE);
-    so_proc_liberacao_recursos(self, proc_alvo);
-    chamador->estado_cpu.regA = 0;
-    return;
+  if (modo == 1) {
+    if (achada == -1 && (livre == -1 || fim + CONFIG_FS_BLOCOS_NOVO_ARQUIVO > num_blocos)) {
+      console_printf("SO: Processo %d: sem espaço no disco para '%s'", proc->pid, nome);
+      proc->estado_cpu.regA = -1;
+      return;
+    }
+    // o bloco do diretório foi acessado no laço, e ainda está na cache
+    int pos;
+    cache_bloco_t *dir = so_fs_entrada(self, proc, achada != -1 ? achada : livre, &pos, &bloqueou);
+    if (dir == NULL) {
+      return;
+    }
+    int *ent = &dir->dados[pos];
+    if (achada == -1) {
+      achada = livre;
+      for (int i = 0; i < FS_TAM_NOME; i++) {
+        ent[FS_ENT_NOME + i] = nome[i];
+        if (nome[i] == '\0') break;
+      }
+      ent[FS_ENT_INICIO] = fim;
+      ent[FS_ENT_BLOCOS] = CONFIG_FS_BLOCOS_NOVO_ARQUIVO;
+    }
+    ent[FS_ENT_TAMANHO] = 0;
+    so_cache_suja(self, dir);
   }
 
-  console_printf("SO: Processo %d bloqueado esperando por PID %d.", chamador->pid, pid_alvo);
-  so_atualiza_estado(self, chamador, BLOQUEADO);
-  chamador->motivo_bloqueio = BLOQUEIO_PID;
-  chamador->pid_esperado = pid_alvo;
-  // O regA não é definido agora, será definido quando for desbloqueado
+  proc->arquivos[fd] = (arquivo_t){ achada, 0, modo };
+  proc->estado_cpu.regA = fd;
+  console_printf("SO: Processo %d abriu '%s' para %s (descritor %d)", proc->pid, nome,
+                 modo == 0 ? "leitura" : "escrita", fd);
 }
 
-
-// ---------------------------------------------------------------------
-// CARGA DE PROGRAMA {{{1
-// ---------------------------------------------------------------------
-
-// carrega o programa na memória
-// - se destino == NULL, carrega diretamente na memória física (uso interno: BIOS, tratadores)
-// - caso contrário, grava o conteúdo na memória secundária e registra metadados no processo
-// retorna o endereço virtual inicial ou -1 em erro
-static int so_carrega_programa(so_t *self, char *nome_do_executavel, processo_t *destino)
+// implementação da chamada de sistema SO_FECHA
+static void so_chamada_fecha(so_t *self)
 {
-  programa_t *prog = prog_cria(nome_do_executavel);
-  if (prog == NULL) {
-    console_printf("Erro na leitura do programa '%s'\n", nome_do_executavel);
-    return -1;
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int fd = proc->estado_cpu.regX;
+  if (so_arq_descritor(proc, fd) == NULL) {
+    proc->estado_cpu.regA = -1;
+    return;
   }
+  so_arq_fecha(self, proc, fd);
+  proc->estado_cpu.regA = 0;
+}
 
-  int end_ini = prog_end_carga(prog);
-  int tam_prog = prog_tamanho(prog);
-  int end_fim = end_ini + tam_prog;
-
-  if (destino == NULL) {
-    for (int end = end_ini; end < end_fim; end++) {
-      if (mem_escreve(self->mem, end, prog_dado(prog, end)) != ERR_OK) {
-        console_printf("Erro na carga da memória, endereco %d\n", end);
-        prog_destroi(prog);
-        return -1;
-      }
+// implementação das chamadas de sistema SO_SEL_LE ('entrada' true) e
+//   SO_SEL_ESCR
+static void so_chamada_sel(so_t *self, bool entrada)
+{
+  if (self->processo_em_execucao_idx == -1) return;
+  processo_t *proc = so_proc(self, self->processo_em_execucao_idx);
+  int fd = proc->estado_cpu.regX;
+  if (fd != -1) {
+    arquivo_t *arq = so_arq_descritor(proc, fd);
+    if (arq == NULL || arq->modo != (entrada ? 0 : 1)) {
+      proc->estado_cpu.regA = -1;
+      return;
     }
-    prog_destroi(prog);
-    console_printf("SO: carga fisica de '%s' em %d-%d", nome_do_executavel, end_ini, end_fim);
-    return end_ini;
   }
-
-  if (self->vm_estado == NULL) {
-    console_printf("SO: memória secundária indisponível para carregar '%s'", nome_do_executavel);
-    prog_destroi(prog);
-    return -1;
+  if (entrada) {
+    proc->arq_entrada = fd;
+  } else {
+    proc->arq_saida = fd;
   }
+  proc->estado_cpu.regA = 0;
+}
 
-  int num_paginas = (tam_prog + TAM_PAGINA - 1) / TAM_PAGINA;
-  if (num_paginas <= 0) {
-    num_paginas = 1;
+// SO_LE com um arquivo de entrada: o caractere na posição corrente, ou -1 no
+//   fim do arquivo
+static void so_arq_chamada_le(so_t *self, processo_t *proc)
+{
+  arquivo_t *arq = &proc->arquivos[proc->arq_entrada];
+  bool bloqueou;
+  int dado;
+  if (!so_arq_le_palavra(self, proc, arq, &dado, &bloqueou)) {
+    if (!bloqueou) proc->estado_cpu.regA = -1;
+    return;
   }
+  arq->posicao++;
+  proc->estado_cpu.regA = dado;
+}
 
-  int *indices = malloc(sizeof(int) * num_paginas);
-  if (indices == NULL) {
-    console_printf("SO: falta de memória ao preparar carga de '%s'", nome_do_executavel);
-    prog_destroi(prog);
-    return -1;
-  }
-  for (int i = 0; i < num_paginas; i++) {
-    indices[i] = -1;
+// SO_ESCR com um arquivo de saída
+static void so_arq_chamada_escr(so_t *self, processo_t *proc)
+{
+  arquivo_t *arq = &proc->arquivos[proc->arq_saida];
+  bool bloqueou;
+  if (!so_arq_escreve_palavra(self, proc, arq, proc->estado_cpu.regX, &bloqueou)) {
+    if (!bloqueou) proc->estado_cpu.regA = -1;
+    return;
   }
+  proc->estado_cpu.regA = 0;
+}
 
-  for (int pagina = 0; pagina < num_paginas; pagina++) {
-    int slot = vm_estado_busca_pagsec_livre(self->vm_estado);
-    if (slot < 0) {
-      console_printf("SO: memória secundária insuficiente para '%s'", nome_do_executavel);
-      for (int j = 0; j < pagina; j++) {
-        if (indices[j] >= 0) {
-          vm_estado_libera_pagsec(self->vm_estado, indices[j]);
-        }
+// SO_ESCR_BUF com um arquivo de saída; como no terminal, a chamada é refeita
+//   a partir de es_buf_feitos depois de um bloqueio; se o arquivo não pode
+//   crescer mais, retorna quantos caracteres foram escritos
+static void so_arq_chamada_escr_buf(so_t *self, processo_t *proc, int ender, int tam)
+{
+  arquivo_t *arq = &proc->arquivos[proc->arq_saida];
+  bool bloqueou = false;
+  while (proc->es_buf_feitos < tam) {
+    int dado;
+    if (!so_le_palavra_da_mem(self, proc, ender + 1 + proc->es_buf_feitos, &dado, &bloqueou)) {
+      if (!bloqueou) {
+        console_printf("SO: Processo %d passou endereço inválido para SO_ESCR_BUF", proc->pid);
+        proc->estado_cpu.regA = -1;
+        proc->es_buf_feitos = 0;
       }
-      free(indices);
-      prog_destroi(prog);
-      return -1;
+      return;
     }
-
-    indices[pagina] = slot;
-    int base = slot * TAM_PAGINA;
-    int deslocamento_pagina = pagina * TAM_PAGINA;
-    int restante = tam_prog - deslocamento_pagina;
-    int tamanho_util = TAM_PAGINA;
-    if (restante > 0 && restante < TAM_PAGINA) {
-      tamanho_util = restante;
+    if (!so_arq_escreve_palavra(self, proc, arq, dado, &bloqueou)) {
+      if (!bloqueou) {
+        proc->estado_cpu.regA = proc->es_buf_feitos > 0 ? proc->es_buf_feitos : -1;
+        proc->es_buf_feitos = 0;
+      }
+      return;
     }
-    vm_estado_ocupa_pagsec(self->vm_estado, slot, destino->pid, pagina, base, tamanho_util);
+    proc->es_buf_feitos++;
+  }
+  proc->estado_cpu.regA = tam;
+  proc->es_buf_feitos = 0;
+}
 
-    for (int offset = 0; offset < TAM_PAGINA; offset++) {
-      int pos_prog = deslocamento_pagina + offset;
-      int valor = 0;
-      if (pos_prog < tam_prog) {
-        valor = prog_dado(prog, end_ini + pos_prog);
-      }
-      if (vm_estado_sec_escreve(self->vm_estado, base + offset, valor) != ERR_OK) {
-        console_printf("SO: erro ao escrever memória secundária (%s)", nome_do_executavel);
-        for (int j = 0; j <= pagina; j++) {
-          if (indices[j] >= 0) {
-            vm_estado_libera_pagsec(self->vm_estado, indices[j]);
-          }
-        }
-        free(indices);
-        prog_destroi(prog);
-        return -1;
+// SO_LE_LINHA ('linha' true) e SO_LE_BUF com um arquivo de entrada: lê até o
+//   máximo, o fim da linha ou o fim do arquivo; retorna -1 só se já estava no
+//   fim do arquivo
+// como no terminal, o '\n' só é consumido depois que o tamanho foi escrito
+static void so_arq_chamada_le_buf(so_t *self, processo_t *proc, int ender, int max, bool linha)
+{
+  arquivo_t *arq = &proc->arquivos[proc->arq_entrada];
+  bool bloqueou = false;
+  bool fim_arquivo = false;
+  bool fim_linha = false;
+  while (proc->es_buf_feitos < max) {
+    int dado;
+    if (!so_arq_le_palavra(self, proc, arq, &dado, &bloqueou)) {
+      if (bloqueou) return;
+      fim_arquivo = true;
+      break;
+    }
+    if (linha && dado == '\n') {
+      fim_linha = true;
+      break;
+    }
+    if (!so_escreve_palavra_na_mem(self, proc, ender + 1 + proc->es_buf_feitos, dado, &bloqueou)) {
+      if (!bloqueou) {
+        console_printf("SO: Processo %d passou endereço inválido para leitura bufferizada", proc->pid);
+        proc->estado_cpu.regA = -1;
+        proc->es_buf_feitos = 0;
       }
+      return;
     }
+    arq->posicao++;
+    proc->es_buf_feitos++;
   }
 
-  if (destino->indices_pagsec != NULL) {
-    free(destino->indices_pagsec);
+  int lidos = proc->es_buf_feitos;
+  if (lidos == 0 && fim_arquivo) {
+    proc->estado_cpu.regA = -1;
+    return;
   }
-  destino->indices_pagsec = indices;
-  destino->num_paginas_secundarias = num_paginas;
-  destino->tamanho_programa = tam_prog;
-  destino->end_virtual_base = end_ini;
-
-  prog_destroi(prog);
-  console_printf("SO: carga de '%s' em memoria secundaria (%d paginas)", nome_do_executavel, num_paginas);
-  return end_ini;
+  if (!so_escreve_palavra_na_mem(self, proc, ender, lidos, &bloqueou)) {
+    if (!bloqueou) {
+      proc->estado_cpu.regA = -1;
+      proc->es_buf_feitos = 0;
+    }
+    return;
+  }
+  if (fim_linha) {
+    arq->posicao++;
+  }
+  proc->estado_cpu.regA = lidos;
+  proc->es_buf_feitos = 0;
 }
 
-
 // ---------------------------------------------------------------------
 // ACESSO À MEMÓRIA DOS PROCESSOS {{{1
 // ---------------------------------------------------------------------
@@ -1800,19 +5271,7 @@ static bool copia_str_da_mem(so_t *self, processo_t *proc, int tam, char str[tam
       continue;
     }
 
-    if (err == ERR_PAG_AUSENTE) {
-      proc->estado_cpu.complemento = ender + indice_str;
-      if (so_atende_falta_pagina(self, proc)) {
-        if (bloqueou != NULL) {
-          *bloqueou = true;
-        }
-        if (proc->estado_cpu.regPC > 0) {
-          proc->estado_cpu.regPC -= 1;
-        }
-      }
-    } else if (err == ERR_END_INV) {
-      proc->estado_cpu.complemento = ender + indice_str;
-    }
+    so_trata_erro_acesso_usuario(self, proc, ender + indice_str, err, bloqueou);
     return false;
   }
 
@@ -1820,6 +5279,61 @@ static bool copia_str_da_mem(so_t *self, processo_t *proc, int tam, char str[tam
   return false;
 }
 
+static bool so_le_palavra_da_mem(so_t *self, processo_t *proc, int ender, int *valor, bool *bloqueou)
+{
+  if (bloqueou != NULL) {
+    *bloqueou = false;
+  }
+  if (self == NULL || proc == NULL || self->mmu == NULL) {
+    return false;
+  }
+  err_t err = mmu_le(self->mmu, ender, valor, usuario);
+  if (err == ERR_OK) {
+    return true;
+  }
+  so_trata_erro_acesso_usuario(self, proc, ender, err, bloqueou);
+  return false;
+}
+
+static bool so_escreve_palavra_na_mem(so_t *self, processo_t *proc, int ender, int valor, bool *bloqueou)
+{
+  if (bloqueou != NULL) {
+    *bloqueou = false;
+  }
+  if (self == NULL || proc == NULL || self->mmu == NULL) {
+    return false;
+  }
+  err_t err = mmu_escreve(self->mmu, ender, valor, usuario);
+  if (err == ERR_OK) {
+    return true;
+  }
+  so_trata_erro_acesso_usuario(self, proc, ender, err, bloqueou);
+  return false;
+}
+
+// trata um erro no acesso do SO à memória de 'proc' durante uma chamada de
+//   sistema: se a página está ausente (ou protegida, numa escrita depois de
+//   SO_FORK), atende a falta e faz a chamada ser repetida quando o processo
+//   voltar a executar (*bloqueou fica true)
+static void so_trata_erro_acesso_usuario(so_t *self, processo_t *proc, int ender, err_t err, bool *bloqueou)
+{
+  if (err == ERR_PAG_AUSENTE || err == ERR_PAG_PROTEGIDA) {
+    proc->estado_cpu.complemento = ender;
+    bool atendida = err == ERR_PAG_AUSENTE ? so_atende_falta_pagina(self, proc)
+                                           : so_atende_protecao_pagina(self, proc);
+    if (atendida) {
+      if (bloqueou != NULL) {
+        *bloqueou = true;
+      }
+      if (proc->estado_cpu.regPC > 0) {
+        proc->estado_cpu.regPC -= 1;
+      }
+    }
+  } else if (err == ERR_END_INV) {
+    proc->estado_cpu.complemento = ender;
+  }
+}
+
 // Imprime o relatório final de métricas do sistema
 static void so_imprime_relatorio_final(so_t *self)
 {
@@ -1847,6 +5361,8 @@ static void so_relatorio_atualiza_ociosidade_final(so_t *self, int tempo_final)
 static void so_relatorio_imprime_globais(so_t *self, int tempo_final)
 {
   console_printf("Processos criados: %d", self->metricas.num_processos_criados);
+  console_printf("Tabela de processos: %d descritores, %d usados",
+                 self->capacidade_processos, self->processos_usados);
   console_printf("Tempo total: %ld ticks", self->metricas.tempo_total_execucao);
 
   float percentual_ocioso = 0.0f;
@@ -1857,8 +5373,44 @@ static void so_relatorio_imprime_globais(so_t *self, int tempo_final)
   console_printf("Tempo ocioso: %ld ticks (%.1f%%)",
                  self->metricas.tempo_total_ocioso, percentual_ocioso);
   console_printf("Preempções totais: %d", self->metricas.num_preempcoes_total);
+  console_printf("Trocas de contexto: %d", self->metricas.num_trocas_contexto);
+  console_printf("Saída bufferizada (SO_ESCR_BUF): %ld chamadas, %ld caracteres, %d bloqueios por buffer cheio",
+                 self->metricas.escr_buf_chamadas, self->metricas.escr_buf_caracteres,
+                 self->metricas.escr_buf_bloqueios);
+  console_printf("Entrada bufferizada (SO_LE_LINHA/SO_LE_BUF): %ld chamadas, %ld caracteres, %d bloqueios",
+                 self->metricas.le_buf_chamadas, self->metricas.le_buf_caracteres,
+                 self->metricas.le_buf_bloqueios);
+  console_printf("Trocas da tabela de páginas na MMU: %ld", self->metricas_vm.trocas_espaco);
   console_printf("Falhas de página (total): %ld", self->metricas_vm.falhas_pagina_total);
   console_printf("Transferências de página: %ld", self->metricas_vm.transferencias_paginas);
+  console_printf("Páginas zeradas sob demanda: %ld", self->metricas_vm.paginas_zeradas);
+  console_printf("Cópia na escrita: %ld processos com SO_FORK, %ld faltas de proteção, %ld páginas copiadas",
+                 self->metricas_vm.processos_fork, self->metricas_vm.faltas_protecao,
+                 self->metricas_vm.copias_escrita);
+  if (self->cache_programas != NULL) {
+    console_printf("Cache de programas: acertos=%d faltas=%d invalidações=%d entradas=%d",
+                   cacheprog_acertos(self->cache_programas),
+                   cacheprog_faltas(self->cache_programas),
+                   cacheprog_invalidacoes(self->cache_programas),
+                   cacheprog_num_entradas(self->cache_programas));
+  }
+  if (self->vm_estado != NULL) {
+    console_printf("Memória secundária: %d regiões livres, maior com %d páginas",
+                   vm_estado_num_extensoes_livres(self->vm_estado),
+                   vm_estado_maior_extensao_livre(self->vm_estado));
+  }
+  long acessos = self->metricas.cache_acertos + self->metricas.cache_faltas;
+  console_printf("Cache de blocos do disco: acertos=%ld faltas=%ld (%.1f%% de acertos) entradas=%d",
+                 self->metricas.cache_acertos, self->metricas.cache_faltas,
+                 acessos > 0 ? 100.0 * self->metricas.cache_acertos / acessos : 0.0,
+                 CONFIG_CACHE_BLOCOS);
+  console_printf("Disco: %ld leituras, %ld gravações adiadas, %ld alterações absorvidas em blocos ainda não gravados",
+                 self->metricas.disco_leituras, self->metricas.disco_gravacoes,
+                 self->metricas.cache_absorvidas);
+  int esperas = self->metricas.disco_esperas;
+  console_printf("Espera pelo disco: %d esperas, %ld ticks (média %.1f)",
+                 esperas, self->metricas.disco_tempo_espera,
+                 esperas > 0 ? (double)self->metricas.disco_tempo_espera / esperas : 0.0);
 }
 
 static void so_relatorio_imprime_irq(so_t *self)
@@ -1867,6 +5419,35 @@ static void so_relatorio_imprime_irq(so_t *self)
   for (int i = 0; i < N_IRQ; i++) {
     console_printf("  IRQ %-2d (%-12s): %d", i, irq_nome(i), self->metricas.num_irq[i]);
   }
+  console_printf("Ticks do relógio: %ld (%d com interrupção)",
+                 self->metricas.num_ticks, self->metricas.num_irq[IRQ_RELOGIO]);
+}
+
+// tempo que o processo passou executando, incluindo o trecho em andamento
+static int so_relatorio_tempo_executando(processo_t *proc, int tempo_final)
+{
+  int tempo = proc->tempo_total_estado[EXECUTANDO];
+  if (proc->estado == EXECUTANDO) {
+    tempo += tempo_final - proc->ultimo_tempo_mudanca_estado;
+  }
+  return tempo;
+}
+
+// parte da CPU que o processo recebeu, entre o tempo de CPU de todos os
+//   processos, comparada com a parte a que os bilhetes davam direito
+static void so_relatorio_imprime_parte_cpu(so_t *self, processo_t *proc, int tempo_final)
+{
+  long total_exec = 0;
+  long total_bilhetes = 0;
+  for (int i = 0; i < self->processos_usados; i++) {
+    processo_t *p = so_proc(self, i);
+    if (p->pid == 0) continue;
+    total_exec += so_relatorio_tempo_executando(p, tempo_final);
+    total_bilhetes += p->bilhetes;
+  }
+  float parte = total_exec > 0 ? 100.0f * so_relatorio_tempo_executando(proc, tempo_final) / total_exec : 0.0f;
+  float direito = total_bilhetes > 0 ? 100.0f * proc->bilhetes / total_bilhetes : 0.0f;
+  console_printf("    bilhetes=%d direito=%.1f%% parte da CPU=%.1f%%", proc->bilhetes, direito, parte);
 }
 
 static void so_relatorio_imprime_processos(so_t *self, int tempo_final)
@@ -1876,8 +5457,8 @@ static void so_relatorio_imprime_processos(so_t *self, int tempo_final)
   };
 
   console_printf("\nProcessos:");
-  for (int i = 0; i < MAX_PROCESSOS; i++) {
-    processo_t *proc = &self->tabela_processos[i];
+  for (int i = 0; i < self->processos_usados; i++) {
+    processo_t *proc = so_proc(self, i);
     if (proc->pid == 0) {
       continue;
     }
@@ -1919,8 +5500,293 @@ static void so_relatorio_imprime_processo(so_t *self, processo_t *proc, int temp
                    estado_nome[e], proc->contagem_estado[e], tempos_estado[e]);
   }
   console_printf("    resposta média: %.2f ticks", tempo_resposta);
-  console_printf("    memória virtual: faltas=%d páginas_sec=%d\n",
-                 proc->falhas_pagina, proc->num_paginas_secundarias);
+  float quantum_medio = execucoes > 0 ? (float)proc->soma_quanta / execucoes : 0.0f;
+  console_printf("    quantum: atual=%d médio concedido=%.2f rajada média=%d despachos=%d",
+                 proc->quantum, quantum_medio, proc->rajada_media, execucoes);
+  if (self->escalonador_atual == ESCAL_CFS) {
+    console_printf("    cfs: nice=%d vruntime=%lu", proc->nice, proc->vruntime);
+  }
+  if (self->escalonador_atual == ESCAL_STRIDE || self->escalonador_atual == ESCAL_LOTERIA) {
+    so_relatorio_imprime_parte_cpu(self, proc, tempo_final);
+  }
+  if (proc->tempo_real) {
+    console_printf("    tempo real: período=%d orçamento=%d prazo=%d trabalhos=%d perdas=%d esgotamentos=%d",
+                   proc->rt_periodo / INTERVALO_INTERRUPCAO, proc->rt_orcamento / INTERVALO_INTERRUPCAO,
+                   proc->rt_prazo / INTERVALO_INTERRUPCAO, proc->rt_trabalhos, proc->rt_perdas,
+                   proc->rt_esgotamentos);
+    console_printf("    atrasos (ticks): em dia=%d 1=%d 2-3=%d 4-7=%d 8-15=%d 16+=%d",
+                   proc->rt_atrasos[0], proc->rt_atrasos[1], proc->rt_atrasos[2],
+                   proc->rt_atrasos[3], proc->rt_atrasos[4], proc->rt_atrasos[5]);
+  }
+  if (proc->disco_esperas > 0) {
+    console_printf("    disco: esperas=%d tempo de espera=%d",
+                   proc->disco_esperas, proc->disco_tempo_espera);
+  }
+  console_printf("    memória virtual: faltas=%d páginas_sec=%d páginas_sbrk=%d residentes=%d taxa_recente=%d/1000\n",
+                 proc->falhas_pagina, proc->num_paginas_secundarias, proc->num_paginas_heap,
+                 proc->quadros_residentes, so_mem_taxa_faltas(proc));
+}
+
+// ---------------------------------------------------------------------
+// CHECKPOINT {{{1
+// ---------------------------------------------------------------------
+
+// o estado do SO é gravado como está na memória: a estrutura so_t, os blocos
+//   de descritores, e depois o que é apontado por eles (tabelas de páginas,
+//   slots das páginas, filas e heaps); na restauração, os ponteiros lidos
+//   são descartados e trocados pelos das estruturas recriadas, e os que
+//   apontam para o hardware e para a cache de programas continuam os desta
+//   execução
+// os descritores não guardam a referência ao programa na cache: a imagem já
+//   está na memória secundária, e só um SO_FORK precisaria dela
+
+#define SO_CHECKPOINT_VERSAO 1
+
+// identifica a compilação que gravou o estado, que é lido como foi gravado
+typedef struct {
+  int versao;
+  int tam_so;
+  int tam_processo;
+  int tam_pagina;
+  int escalonador;
+  int idx_tabpag_na_mmu;    // dono da tabela de páginas em uso pela MMU, ou -1
+} so_checkpoint_cabecalho_t;
+
+static bool so_checkpoint_grava(FILE *arq, const void *dados, size_t tam, int n)
+{
+  return n <= 0 || fwrite(dados, tam, n, arq) == (size_t)n;
+}
+
+static bool so_checkpoint_le(FILE *arq, void *dados, size_t tam, int n)
+{
+  return n <= 0 || fread(dados, tam, n, arq) == (size_t)n;
+}
+
+// grava o que é apontado por um descritor: para a tabela de páginas e para
+//   cada vetor de slots, um tamanho (-1 se o ponteiro é NULL) e o conteúdo
+static bool so_checkpoint_grava_processo(processo_t *proc, FILE *arq)
+{
+  int tamanhos[3] = {
+    proc->tabela_paginas != NULL ? 1 : -1,
+    proc->slots_imagem != NULL ? proc->num_paginas_secundarias : -1,
+    proc->slots_heap != NULL ? proc->num_paginas_heap : -1,
+  };
+  return so_checkpoint_grava(arq, tamanhos, sizeof(int), 3)
+         && (proc->tabela_paginas == NULL || tabpag_salva(proc->tabela_paginas, arq))
+         && so_checkpoint_grava(arq, proc->slots_imagem, sizeof(int), tamanhos[1])
+         && so_checkpoint_grava(arq, proc->slots_heap, sizeof(int), tamanhos[2]);
+}
+
+// lê o que foi gravado por so_checkpoint_grava_processo; os ponteiros do
+//   descritor devem estar NULL
+static bool so_checkpoint_le_vetor(FILE *arq, int tam, int **pvetor)
+{
+  if (tam < 0) {
+    return true;
+  }
+  *pvetor = malloc((tam > 0 ? tam : 1) * sizeof(int));
+  return *pvetor != NULL && so_checkpoint_le(arq, *pvetor, sizeof(int), tam);
+}
+
+static bool so_checkpoint_le_processo(processo_t *proc, FILE *arq)
+{
+  int tamanhos[3];
+  if (!so_checkpoint_le(arq, tamanhos, sizeof(int), 3)) {
+    return false;
+  }
+  if (tamanhos[0] > 0) {
+    proc->tabela_paginas = tabpag_restaura(arq);
+    if (proc->tabela_paginas == NULL) {
+      return false;
+    }
+  }
+  return so_checkpoint_le_vetor(arq, tamanhos[1], &proc->slots_imagem)
+         && so_checkpoint_le_vetor(arq, tamanhos[2], &proc->slots_heap);
+}
+
+// libera as estruturas apontadas pelo SO que são gravadas no checkpoint, sem
+//   mexer no estado da memória virtual; usada para descartar o estado atual
+//   na restauração, ou o que foi lido se a leitura falhar
+static void so_checkpoint_libera(so_t *self)
+{
+  for (int i = 0; i < self->processos_usados && i < self->capacidade_processos; i++) {
+    processo_t *proc = so_proc(self, i);
+    tabpag_destroi(proc->tabela_paginas);
+    free(proc->slots_imagem);
+    free(proc->slots_heap);
+    if (proc->programa != NULL) {
+      cacheprog_libera(self->cache_programas, proc->programa);
+    }
+  }
+  for (int b = 0; b < self->capacidade_processos / PROCESSOS_POR_BLOCO; b++) {
+    free(self->blocos_processos[b]);
+  }
+  free(self->blocos_processos);
+  free(self->pid_baldes);
+  free(self->espera_pid);
+  free(self->fila_prontos.itens);
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    free(self->mlfq_filas[n].itens);
+  }
+  fprio_destroi(self->prontos_prio);
+  fprio_destroi(self->prontos_rt);
+}
+
+// lê para 'novo', que tem os campos lidos de so_t, as estruturas apontadas;
+//   os ponteiros são zerados antes, e a capacidade da tabela só conta os
+//   blocos já lidos, para que so_checkpoint_libera funcione a qualquer momento
+static bool so_checkpoint_le_estruturas(so_t *novo, FILE *arq)
+{
+  int capacidade = novo->capacidade_processos;
+  int num_blocos = capacidade / PROCESSOS_POR_BLOCO;
+  novo->capacidade_processos = 0;
+  novo->pid_baldes = NULL;
+  novo->espera_pid = NULL;
+  novo->fila_prontos.itens = NULL;
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    novo->mlfq_filas[n].itens = NULL;
+  }
+  novo->prontos_prio = NULL;
+  novo->prontos_rt = NULL;
+  novo->blocos_processos = calloc(num_blocos > 0 ? num_blocos : 1, sizeof(*novo->blocos_processos));
+  if (novo->blocos_processos == NULL || capacidade > MAX_PROCESSOS
+      || novo->processos_usados > capacidade) {
+    return false;
+  }
+
+  for (int b = 0; b < num_blocos; b++) {
+    processo_t *bloco = malloc(PROCESSOS_POR_BLOCO * sizeof(*bloco));
+    if (bloco == NULL) {
+      return false;
+    }
+    novo->blocos_processos[b] = bloco;
+    novo->capacidade_processos += PROCESSOS_POR_BLOCO;
+    bool lido = so_checkpoint_le(arq, bloco, sizeof(*bloco), PROCESSOS_POR_BLOCO);
+    for (int p = 0; p < PROCESSOS_POR_BLOCO; p++) {
+      bloco[p].tabela_paginas = NULL;
+      bloco[p].slots_imagem = NULL;
+      bloco[p].slots_heap = NULL;
+      bloco[p].programa = NULL;
+    }
+    if (!lido) {
+      return false;
+    }
+  }
+  for (int i = 0; i < novo->processos_usados; i++) {
+    if (!so_checkpoint_le_processo(so_proc(novo, i), arq)) {
+      return false;
+    }
+  }
+
+  novo->pid_baldes = malloc(capacidade * sizeof(*novo->pid_baldes));
+  novo->espera_pid = malloc(capacidade * sizeof(*novo->espera_pid));
+  if (!so_checkpoint_le_vetor(arq, novo->fila_prontos.capacidade, &novo->fila_prontos.itens)) {
+    return false;
+  }
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    if (!so_checkpoint_le_vetor(arq, novo->mlfq_filas[n].capacidade, &novo->mlfq_filas[n].itens)) {
+      return false;
+    }
+  }
+  if (novo->pid_baldes == NULL || novo->espera_pid == NULL
+      || !so_checkpoint_le(arq, novo->pid_baldes, sizeof(*novo->pid_baldes), capacidade)
+      || !so_checkpoint_le(arq, novo->espera_pid, sizeof(*novo->espera_pid), capacidade)) {
+    return false;
+  }
+  novo->prontos_prio = fprio_restaura(arq);
+  novo->prontos_rt = fprio_restaura(arq);
+  return novo->prontos_prio != NULL && novo->prontos_rt != NULL;
+}
+
+bool so_salva(so_t *self, FILE *arq)
+{
+  if (self->vm_estado == NULL) {
+    return false;
+  }
+  so_checkpoint_cabecalho_t cab = {
+    SO_CHECKPOINT_VERSAO, sizeof(so_t), sizeof(processo_t), TAM_PAGINA,
+    self->escalonador_atual, -1
+  };
+  for (int i = 0; i < self->processos_usados && self->tabpag_na_mmu != NULL; i++) {
+    if (so_proc(self, i)->tabela_paginas == self->tabpag_na_mmu) {
+      cab.idx_tabpag_na_mmu = i;
+      break;
+    }
+  }
+
+  if (!so_checkpoint_grava(arq, &cab, sizeof(cab), 1)
+      || !so_checkpoint_grava(arq, self, sizeof(*self), 1)) {
+    return false;
+  }
+  for (int b = 0; b < self->capacidade_processos / PROCESSOS_POR_BLOCO; b++) {
+    if (!so_checkpoint_grava(arq, self->blocos_processos[b], sizeof(processo_t), PROCESSOS_POR_BLOCO)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < self->processos_usados; i++) {
+    if (!so_checkpoint_grava_processo(so_proc(self, i), arq)) {
+      return false;
+    }
+  }
+  if (!so_checkpoint_grava(arq, self->fila_prontos.itens, sizeof(int), self->fila_prontos.capacidade)) {
+    return false;
+  }
+  for (int n = 0; n < CONFIG_MLFQ_NIVEIS; n++) {
+    if (!so_checkpoint_grava(arq, self->mlfq_filas[n].itens, sizeof(int), self->mlfq_filas[n].capacidade)) {
+      return false;
+    }
+  }
+  return so_checkpoint_grava(arq, self->pid_baldes, sizeof(*self->pid_baldes), self->capacidade_processos)
+         && so_checkpoint_grava(arq, self->espera_pid, sizeof(*self->espera_pid), self->capacidade_processos)
+         && fprio_salva(self->prontos_prio, arq)
+         && fprio_salva(self->prontos_rt, arq)
+         && vm_estado_salva(self->vm_estado, arq);
+}
+
+bool so_restaura(so_t *self, FILE *arq)
+{
+  so_checkpoint_cabecalho_t cab;
+  so_t novo;
+  if (self->vm_estado == NULL
+      || !so_checkpoint_le(arq, &cab, sizeof(cab), 1)
+      || cab.versao != SO_CHECKPOINT_VERSAO || cab.tam_so != sizeof(so_t)
+      || cab.tam_processo != sizeof(processo_t) || cab.tam_pagina != TAM_PAGINA
+      || cab.escalonador != (int)self->escalonador_atual
+      || !so_checkpoint_le(arq, &novo, sizeof(novo), 1)) {
+    return false;
+  }
+  novo.cache_programas = self->cache_programas;
+  if (!so_checkpoint_le_estruturas(&novo, arq)) {
+    so_checkpoint_libera(&novo);
+    return false;
+  }
+  if (cab.idx_tabpag_na_mmu >= novo.processos_usados) {
+    so_checkpoint_libera(&novo);
+    return false;
+  }
+
+  // troca o estado, mantendo o que é desta execução
+  so_checkpoint_libera(self);
+  novo.cpu = self->cpu;
+  novo.mem = self->mem;
+  novo.mmu = self->mmu;
+  novo.es = self->es;
+  novo.console = self->console;
+  novo.vm_estado = self->vm_estado;
+  novo.vm_quadros_proc = self->vm_quadros_proc;
+  novo.vm_acessos_proc = self->vm_acessos_proc;
+  novo.algoritmo_substituicao = self->algoritmo_substituicao;
+  novo.tempo_transferencia_pagina = self->tempo_transferencia_pagina;
+  novo.tabpag_na_mmu = NULL;
+  *self = novo;
+
+  bool ok = vm_estado_restaura(self->vm_estado, arq);
+  tabpag_t *tabpag = NULL;
+  if (cab.idx_tabpag_na_mmu >= 0) {
+    tabpag = so_proc(self, cab.idx_tabpag_na_mmu)->tabela_paginas;
+  }
+  so_mmu_define_tabpag(self, tabpag);
+  return ok;
 }
 
 // vim: foldmethod=marker
@@ -10,13 +10,21 @@
 #include "mmu.h"
 #include "cpu.h"
 #include "es.h"
+#include "programa.h"
 #include "console.h" // só para uma gambiarra
 #include "config.h"
 
+#include <stdbool.h>
+#include <stdio.h>
+
 // Define qual escalonador está em uso
 typedef enum {
   ESCAL_CIRCULAR,   // Round-Robin
-  ESCAL_PRIORIDADE  // Prioridade com preempção
+  ESCAL_PRIORIDADE, // Prioridade com preempção
+  ESCAL_MLFQ,       // Filas multinível com realimentação
+  ESCAL_CFS,        // Justo, por tempo virtual de execução
+  ESCAL_STRIDE,     // Divisão proporcional por bilhetes, determinística (passos)
+  ESCAL_LOTERIA     // Divisão proporcional por bilhetes, por sorteio
 } tipo_escalonador_t;
 
 // Estado de um processo
@@ -34,9 +42,25 @@ typedef enum {
   BLOQUEIO_PID,     // Esperando um processo (pid_esperado)
   BLOQUEIO_IO_LE,   // Esperando para ler (dispositivo_esperado)
   BLOQUEIO_IO_ESCR, // Esperando para escrever (dispositivo_esperado)
-  BLOQUEIO_PAGINA   // Esperando transferência de página memória secundária
+  BLOQUEIO_PAGINA,  // Esperando transferência de página memória secundária
+  BLOQUEIO_PERIODO, // Tempo real esperando o próximo período (tempo_desbloqueio)
+  BLOQUEIO_BUF_ESCR, // Esperando espaço no buffer de saída do terminal (SO_ESCR_BUF)
+  BLOQUEIO_BUF_LE,   // Esperando dados no buffer de entrada do terminal (SO_LE_LINHA, SO_LE_BUF)
+  BLOQUEIO_DISCO     // Esperando a leitura de um bloco do disco para a cache (dispositivo_esperado é o
+                     //   bloco), ou uma entrada livre na cache (dispositivo_esperado é -1)
 } motivo_bloqueio_t;
 
+// faixas do histograma de atrasos dos processos de tempo real: em dia, e
+//   atrasos de 1, 2-3, 4-7, 8-15 e 16 ou mais ticks do relógio
+#define RT_FAIXAS_ATRASO 6
+
+// Arquivo aberto por um processo (SO_ABRE)
+typedef struct {
+  int entrada;              // Entrada do arquivo no diretório, ou -1 se o descritor está livre
+  int posicao;              // Próxima palavra a ler ou escrever
+  int modo;                 // 0 leitura, 1 escrita
+} arquivo_t;
+
 // Estrutura para salvar o estado da CPU de um processo
 typedef struct {
   int regA;
@@ -57,12 +81,33 @@ typedef struct {
   motivo_bloqueio_t motivo_bloqueio;
   int pid_esperado;             // PID do processo que este espera (se motivo_bloqueio == BLOQUEIO_PID)
   int dispositivo_esperado;   // Terminal (D_TERM_A, etc.) que este espera (se motivo_bloqueio == BLOQUEIO_IO_*)
+  int es_buf_feitos;            // Caracteres já transferidos pela chamada SO_ESCR_BUF ou SO_LE_* em andamento, que é
+                                //   refeita depois de um bloqueio e continua de onde parou
+
+  // --- Arquivos ---
+  arquivo_t arquivos[CONFIG_ARQUIVOS_POR_PROCESSO]; // Arquivos abertos, pelo descritor
+  int arq_entrada;              // Descritor do arquivo de entrada corrente, ou -1 para o terminal
+  int arq_saida;                // Descritor do arquivo de saída corrente, ou -1 para o terminal
+  int disco_inicio_espera;      // "Data" em que bloqueou esperando o disco
+  bool disco_refaz;             // Se a chamada em andamento é refeita depois de esperar o disco (o acesso
+                                //   ao bloco que faltava não conta de novo na cache)
+  int disco_esperas;            // Vezes em que bloqueou esperando o disco, e tempo total
+  int disco_tempo_espera;       //   (em instruções) bloqueado
 
   // --- Campos de Escalonamento e Métricas (Parte III) ---
   float prioridade;                 // Para o escalonador de prioridade
+  int nivel_mlfq;                   // Nível atual no escalonador MLFQ (0 é o mais prioritário)
+  int nice;                         // Gentileza (-20 a 19) para o escalonador CFS; herdada do criador
+  unsigned long vruntime;           // Tempo virtual de execução (instruções ponderadas pelo nice)
+  int bilhetes;                     // Parte da CPU a que tem direito (stride/loteria); herdada do criador
+  unsigned long passo;              // Stride: posição do processo, avança inversamente aos bilhetes
   int tempo_criacao;                // "Data" de criação (em ticks)
   int tempo_termino;                // "Data" de término (em ticks)
   int num_preempcoes;               // Quantas vezes foi preemptado
+  int quantum;                      // Quantum próprio (em ticks), com CONFIG_QUANTUM_ADAPTATIVO
+  int inicio_rajada;                // "Data" em que começou a execução atual
+  int rajada_media;                 // Média (exponencial) das rajadas de CPU, em instruções
+  long soma_quanta;                 // Soma dos quanta concedidos, para a média no relatório
 
   // Métricas de estado
   int contagem_estado[5];           // Contagem de quantas vezes entrou em cada estado
@@ -76,20 +121,75 @@ typedef struct {
   // --- Campos para memória virtual (Parte T3) ---
   tabpag_t *tabela_paginas;         // Tabela de páginas associada ao processo
   int falhas_pagina;                // Contador de faltas de página atendidas
-  int *indices_pagsec;              // Mapeamento de páginas virtuais para slots na memória secundária
-  int num_paginas_secundarias;      // Quantas páginas foram carregadas na memória secundária
+  int base_pagsec;                  // Primeiro slot da extensão contígua na memória secundária, ou -1
+  int num_paginas_secundarias;      // Quantas páginas foram carregadas na memória secundária (tamanho da extensão)
   int tamanho_programa;             // Tamanho total do programa em palavras
+  programa_t *programa;             // Programa executado (referência na cache de programas)
   int end_virtual_base;             // Endereço virtual base do programa
+  int fim_heap;                     // Endereço virtual limite da área válida (imagem + área criada com SO_SBRK)
+  int *slots_imagem;                // Slot na secundária de cada página da imagem, ou NULL se são os da
+                                    //   extensão a partir de base_pagsec (só após SO_FORK os slots são compartilhados)
+  int *slots_heap;                  // Slot na secundária de cada página além da imagem, ou -1 se nunca foi gravada
+  int num_paginas_heap;             // Quantas páginas existem além da imagem
   int tempo_desbloqueio;            // "Data" para desbloqueio em operações de página
+  int quadros_residentes;           // Quantos quadros da memória principal ocupa
+  int conjunto_trabalho;            // Quadros que ocupava ao deixar a CPU (estimativa do conjunto de trabalho)
+  int faltas_recentes;              // Faltas e instruções executadas numa janela que
+  int instrucoes_recentes;          //   decai (metade a cada CONFIG_JANELA_FALTAS instruções)
+  int idx;                          // Índice do descritor na tabela de processos
+  bool em_uso;                      // Se está na lista de vivos e no índice de pids
+  int vivo_ant;                     // Vizinhos na lista de vivos (índices, ou -1); um
+  int vivo_prox;                    //   descritor livre usa vivo_prox na pilha de livres
+  int pid_prox;                     // Próximo descritor no mesmo balde do índice de pids
+  int espera_ant;                   // Vizinhos na fila de espera em que está bloqueado
+  int espera_prox;                  //   (índices na tabela de processos, ou -1)
+  bool em_espera;                   // Se está encadeado em alguma fila de espera
+  unsigned long tick_envelhecimento; // Tick do relógio até o qual as idades das páginas estão em dia
+
+  // --- Threads ---
+  int lider_idx;                    // Processo dono do espaço de endereçamento de uma thread criada com
+                                    //   SO_CRIA_THREAD (índice na tabela), ou -1 se o espaço é próprio
+  int num_threads;                  // Threads vivas que usam o espaço de endereçamento deste processo
+
+  // --- Tempo real (EDF) ---
+  bool tempo_real;                  // Se declarou período, orçamento e prazo com SO_TEMPO_REAL
+  int rt_periodo;                   // Período, orçamento (CPU por período) e prazo relativo,
+  int rt_orcamento;                 //   em instruções
+  int rt_prazo;
+  int rt_liberacao;                 // "Data" de início do período corrente
+  int rt_prazo_abs;                 // "Data" limite do trabalho corrente, ou -1 se nenhum
+  int rt_restante;                  // Orçamento que resta no período corrente
+  int rt_trabalhos;                 // Trabalhos terminados (SO_FIM_PERIODO)
+  int rt_perdas;                    // Trabalhos terminados depois do prazo
+  int rt_esgotamentos;              // Vezes em que gastou o orçamento antes de terminar o trabalho
+  int rt_atrasos[RT_FAIXAS_ATRASO]; // Histograma dos atrasos dos trabalhos terminados
 } processo_t;
 
-#define MAX_PROCESSOS 10
+// limite de processos simultâneos; a tabela de processos cresce conforme a
+//   necessidade até esse tamanho
+#define MAX_PROCESSOS 1024
 
 typedef struct so_t so_t;
 
 so_t *so_cria(cpu_t *cpu, mem_t *mem, mmu_t *mmu, es_t *es, console_t *console);
 void so_destroi(so_t *self);
 
+// grava em 'arq' o estado do SO (descritores de processos, filas, tabelas de
+//   páginas, estado da memória virtual e conteúdo da memória secundária),
+//   para o checkpoint da máquina
+// retorna false em caso de erro de escrita
+bool so_salva(so_t *self, FILE *arq);
+
+// substitui o estado do SO pelo gravado com so_salva, por um SO desta mesma
+//   compilação e configuração (o arquivo é recusado se não for); o
+//   algoritmo de substituição e o tempo de transferência de página continuam
+//   os desta execução, e os programas dos processos não são lidos de novo
+//   (a imagem deles está na memória secundária)
+// o resto da máquina (memória, CPU, relógio) deve ser restaurado junto
+// retorna false em caso de erro de leitura; o estado do SO só é trocado se
+//   tudo for lido, mas o da memória virtual pode ficar pela metade
+bool so_restaura(so_t *self, FILE *arq);
+
 // Chamadas de sistema
 // Uma chamada de sistema é realizada colocando a identificação da
 //   chamada (um dos valores abaixo) no registrador A e executando a
@@ -99,7 +199,7 @@ void so_destroi(so_t *self);
 // Cada processo tem um dispositivo (ou arquivo) corrente de entrada
 //   e um de saída. As chamadas de sistema para leitura e escrita são
 //   realizadas nesses dispositivos.
-// Outras chamadas (não definidas) abrem e fecham arquivos, e definem
+// Outras chamadas abrem e fecham arquivos, e definem
 //   qual dos arquivos abertos é escolhido para ser o de entrada ou
 //   saída correntes.
 
@@ -113,10 +213,63 @@ void so_destroi(so_t *self);
 // retorna em A: 0 se OK ou um código de erro negativo
 #define SO_ESCR        2
 
-// #define SO_ABRE        3
-// #define SO_FECHA       4
-// #define SO_SEL_LE      5
-// #define SO_SEL_ESCR    6
+// escreve vários caracteres no dispositivo de saída do processo, numa chamada
+// a posição X da memória do chamador contém o número de caracteres, e os
+//   caracteres estão a partir da posição X+1
+// os caracteres vão para um buffer do SO para o terminal, esvaziado conforme
+//   o terminal aceita; o processo só bloqueia se o buffer encher
+// retorna em A: o número de caracteres escritos ou um código de erro negativo
+#define SO_ESCR_BUF   16
+
+// lê uma linha do dispositivo de entrada do processo, numa chamada
+// a posição X da memória do chamador contém o número máximo de caracteres, e
+//   os caracteres lidos são colocados a partir da posição X+1, sem o '\n';
+//   o número de caracteres lidos é colocado na posição X (a área fica no
+//   formato de SO_ESCR_BUF)
+// os caracteres do terminal são guardados num buffer do SO, e o processo
+//   bloqueia até ter uma linha inteira (ou o buffer encher)
+// retorna em A: o número de caracteres lidos ou um código de erro negativo
+#define SO_LE_LINHA   17
+
+// como SO_LE_LINHA, mas não espera o fim da linha: lê os caracteres que
+//   estiverem no buffer (até o máximo), e só bloqueia se não houver nenhum
+#define SO_LE_BUF     18
+
+// Os arquivos ficam no disco, num diretório único (o formato está em
+//   sistarq.h); cada caractere ocupa uma palavra do arquivo. As leituras e
+//   escritas passam por uma cache de blocos no SO: quem precisa de um bloco
+//   que não está nela bloqueia até ele ser lido, e os blocos alterados são
+//   gravados depois, em segundo plano.
+// Com um arquivo selecionado, SO_LE, SO_ESCR, SO_LE_LINHA, SO_LE_BUF e
+//   SO_ESCR_BUF usam o arquivo em vez do terminal; uma leitura no fim do
+//   arquivo retorna -1 (SO_LE_LINHA e SO_LE_BUF só retornam -1 se não há nada
+//   para ler).
+
+// abre um arquivo
+// a posição X da memória do chamador contém o modo (0 leitura, 1 escrita), e o
+//   nome do arquivo está a partir da posição X+1, terminado por 0
+// um arquivo aberto para escrita é esvaziado, ou criado se não existir (com
+//   CONFIG_FS_BLOCOS_NOVO_ARQUIVO blocos, além dos quais não pode crescer)
+// retorna em A: o descritor do arquivo aberto, ou código de erro negativo
+#define SO_ABRE        3
+
+// fecha um arquivo
+// recebe em X o descritor do arquivo; se ele estava selecionado para entrada
+//   ou saída, volta a ser usado o terminal
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_FECHA       4
+
+// seleciona o arquivo de entrada do processo
+// recebe em X o descritor de um arquivo aberto para leitura, ou -1 para o
+//   terminal
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_SEL_LE      5
+
+// seleciona o arquivo de saída do processo
+// recebe em X o descritor de um arquivo aberto para escrita, ou -1 para o
+//   terminal
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_SEL_ESCR    6
 
 
 // Chamadas para gerenciamento de processos
@@ -149,4 +302,64 @@ void so_destroi(so_t *self);
 // retorna sem bloquear, com erro, se não existir processo com esse pid
 #define SO_ESPERA_PROC 9
 
+// cria um processo novo com um número de bilhetes (parte da CPU a que tem
+//   direito nos escalonadores ESCAL_STRIDE e ESCAL_LOTERIA)
+// a posição X da memória do chamador contém o número de bilhetes (> 0), e o
+//   nome do programa está a partir da posição X+1, como em SO_CRIA_PROC
+// com SO_CRIA_PROC, o processo criado herda os bilhetes do criador
+// retorna em A: pid do processo criado, ou código de erro negativo
+#define SO_CRIA_PROC_BILH 11
+
+// declara o processo chamador como de tempo real: ele passa a ser escalonado
+//   antes dos demais, o de data limite mais cedo primeiro (EDF)
+// a posição X da memória do chamador e as duas seguintes contêm, em ticks do
+//   relógio, o período, o orçamento (tempo de CPU a que tem direito em cada
+//   período) e o prazo (a partir do início do período) de cada trabalho
+// quem gasta o orçamento antes de terminar o trabalho só volta a executar no
+//   período seguinte
+// o pedido é recusado se não valer 0 < orçamento <= prazo <= período, ou se
+//   a soma de orçamento/prazo dos processos de tempo real passar de
+//   CONFIG_EDF_UTILIZACAO_MAXIMA
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_TEMPO_REAL 12
+
+// termina o trabalho do período corrente de um processo de tempo real e
+//   bloqueia até o início do próximo período (se ele já começou, o trabalho
+//   seguinte começa sem bloquear)
+// retorna em A: 0 se OK ou um código de erro negativo
+#define SO_FIM_PERIODO 13
+
+// cria um processo que é uma cópia do chamador: mesma memória, mesmos
+//   registradores, mesmo terminal; os dois continuam a execução após a chamada
+// a memória não é copiada na criação: os quadros e a memória secundária são
+//   compartilhados, protegidos contra escrita, e cada página só é copiada
+//   quando um dos processos escreve nela
+// retorna em A: para o chamador, o pid do processo criado, ou código de erro
+//   negativo; para o processo criado, 0
+#define SO_FORK 14
+
+// cria uma thread do processo chamador: uma entidade escalonada à parte, com
+//   seus próprios registradores, que compartilha a memória (tabela de páginas,
+//   memória secundária, área de SO_SBRK) e o terminal do processo
+// recebe em X o endereço em que a thread começa a executar; ela começa com
+//   A e X valendo 0
+// a thread termina com SO_MATA_PROC, e pode ser esperada com SO_ESPERA_PROC;
+//   quando o processo que criou o espaço de endereçamento termina, as threads
+//   terminam junto
+// retorna em A: o identificador (pid) da thread, ou código de erro negativo
+#define SO_CRIA_THREAD 15
+
+
+// Chamadas para gerenciamento de memória
+
+// aumenta a área de memória válida do processo
+// recebe em X o número de palavras a acrescentar após o final atual da área
+//   (X = 0 só consulta o final atual)
+// a área nova começa zerada; as páginas só ocupam um quadro quando forem
+//   acessadas, e só ocupam memória secundária quando forem alteradas e
+//   precisarem ser substituídas
+// retorna em A: o endereço inicial da área acrescentada (o final anterior),
+//   ou código de erro negativo
+#define SO_SBRK       10
+
 #endif // SO_H
@@ -5,6 +5,7 @@
 
 #include "tabpag.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // estrutura auxiliar, contém informação sobre uma página
@@ -17,6 +18,8 @@ typedef struct {
   bool acessada;
   // a página foi alterada ou não
   bool alterada;
+  // a escrita na página é proibida ou não
+  bool protegida;
 } descritor_t;
 
 struct tabpag_t {
@@ -100,6 +103,7 @@ void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro)
   self->tabela[pagina].valida = true;
   self->tabela[pagina].acessada = false;
   self->tabela[pagina].alterada = false;
+  self->tabela[pagina].protegida = false;
 }
 
 void tabpag_marca_bit_acesso(tabpag_t *self, int pagina, bool alteracao)
@@ -129,9 +133,76 @@ bool tabpag_bit_alteracao(tabpag_t *self, int pagina)
   return self->tabela[pagina].alterada;
 }
 
+void tabpag_protege_pagina(tabpag_t *self, int pagina, bool protegida)
+{
+  if (!tabpag__pagina_valida(self, pagina)) return;
+  self->tabela[pagina].protegida = protegida;
+}
+
+bool tabpag_pagina_protegida(tabpag_t *self, int pagina)
+{
+  if (!tabpag__pagina_valida(self, pagina)) return false;
+  return self->tabela[pagina].protegida;
+}
+
+tabpag_t *tabpag_duplica_protegida(tabpag_t *self)
+{
+  tabpag_t *copia = tabpag_cria();
+  if (self->tam_tab == 0) return copia;
+  for (int pagina = 0; pagina < self->tam_tab; pagina++) {
+    if (self->tabela[pagina].valida) {
+      self->tabela[pagina].protegida = true;
+    }
+  }
+  copia->tabela = malloc(self->tam_tab * sizeof(descritor_t));
+  assert(copia->tabela != NULL);
+  memcpy(copia->tabela, self->tabela, self->tam_tab * sizeof(descritor_t));
+  copia->tam_tab = self->tam_tab;
+  return copia;
+}
+
+int tabpag_colhe_acessos(tabpag_t *self, int quadros[], unsigned char acessados[], int max)
+{
+  int n = 0;
+  for (int pagina = 0; pagina < self->tam_tab && n < max; pagina++) {
+    descritor_t *d = &self->tabela[pagina];
+    if (!d->valida) continue;
+    quadros[n] = d->quadro;
+    acessados[n] = d->acessada;
+    d->acessada = false;
+    n++;
+  }
+  return n;
+}
+
 err_t tabpag_traduz(tabpag_t *self, int pagina, int *pquadro)
 {
   if (!tabpag__pagina_valida(self, pagina)) return ERR_PAG_AUSENTE;
   *pquadro = self->tabela[pagina].quadro;
   return ERR_OK;
 }
+
+bool tabpag_salva(tabpag_t *self, FILE *arq)
+{
+  if (fwrite(&self->tam_tab, sizeof(self->tam_tab), 1, arq) != 1) return false;
+  // uma tabela vazia ainda não tem vetor (tabela é NULL)
+  if (self->tam_tab == 0) return true;
+  return fwrite(self->tabela, sizeof(descritor_t), self->tam_tab, arq) == (size_t)self->tam_tab;
+}
+
+tabpag_t *tabpag_restaura(FILE *arq)
+{
+  int tam_tab;
+  if (fread(&tam_tab, sizeof(tam_tab), 1, arq) != 1 || tam_tab < 0) return NULL;
+  tabpag_t *self = tabpag_cria();
+  if (tam_tab > 0) {
+    self->tabela = malloc(tam_tab * sizeof(descritor_t));
+    assert(self->tabela != NULL);
+    self->tam_tab = tam_tab;
+    if (fread(self->tabela, sizeof(descritor_t), tam_tab, arq) != (size_t)tam_tab) {
+      tabpag_destroi(self);
+      return NULL;
+    }
+  }
+  return self;
+}
@@ -10,10 +10,12 @@
 // realiza a tradução de números de páginas do espaço de endereçamento
 //   de um processo em números de quadros da memória principal onde essas
 //   páginas estão mapeadas
-// mantém para cada página mapeada um bit de acesso e um bit de alteração
+// mantém para cada página mapeada um bit de acesso e um bit de alteração, e
+//   um bit de proteção contra escrita
 
 #include "err.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 // tipo opaco que representa a tabela de páginas
 typedef struct tabpag_t tabpag_t;
@@ -30,8 +32,8 @@ tabpag_t *tabpag_cria(void);
 void tabpag_destroi(tabpag_t *self);
 
 // define que a tradução da página 'pagina' deve resultar no quadro 'quadro'
-// essa página é marcada como válida, e os bits de acesso e alteração para essa
-//   página são zerados
+// essa página é marcada como válida, e os bits de acesso, alteração e
+//   proteção para essa página são zerados
 // páginas sem quadro definido são consideradas inválidas
 void tabpag_define_quadro(tabpag_t *self, int pagina, int quadro);
 
@@ -56,9 +58,38 @@ bool tabpag_bit_acesso(tabpag_t *self, int pagina);
 // retorna false se a página for inválida
 bool tabpag_bit_alteracao(tabpag_t *self, int pagina);
 
+// liga ou desliga a proteção contra escrita da página
+// não faz nada se a página for inválida
+void tabpag_protege_pagina(tabpag_t *self, int pagina, bool protegida);
+
+// retorna o valor do bit de proteção contra escrita da página
+// retorna false se a página for inválida
+bool tabpag_pagina_protegida(tabpag_t *self, int pagina);
+
+// cria uma cópia da tabela, com as mesmas traduções e bits, e protege contra
+//   escrita todas as páginas válidas, nas duas tabelas
+// usada para que dois processos compartilhem os quadros até que um deles
+//   escreva (cópia na escrita); o custo é proporcional ao tamanho da tabela
+// mata o programa em caso de erro (malloc)
+tabpag_t *tabpag_duplica_protegida(tabpag_t *self);
+
+// colhe de uma vez os bits de acesso de todas as páginas válidas: para cada
+//   página válida (até 'max'), coloca o quadro em 'quadros' e o bit de acesso
+//   (0 ou 1) na mesma posição de 'acessados', e zera o bit de acesso da página
+// retorna o número de páginas colhidas
+int tabpag_colhe_acessos(tabpag_t *self, int quadros[], unsigned char acessados[], int max);
+
 // traduz a página 'pagina'; coloca o quadro correspondente na posição apontada
 //   por 'pquadro'
 // retorna ERR_PAG_AUSENTE (e não altera '*pquadro') se a página for inválida
 err_t tabpag_traduz(tabpag_t *self, int pagina, int *pquadro);
 
+// grava a tabela em 'arq' (checkpoint da máquina)
+// retorna false em caso de erro de escrita
+bool tabpag_salva(tabpag_t *self, FILE *arq);
+
+// cria uma tabela com o conteúdo gravado por tabpag_salva
+// retorna NULL em caso de erro de leitura
+tabpag_t *tabpag_restaura(FILE *arq);
+
 #endif // TABPAG_H
@@ -6,19 +6,26 @@
 #include "terminal.h"
 
 #include <stdlib.h>
-#include <string.h>
 #include <assert.h>
 
 // TERMINAL
 
 // dados para um terminal
+// a entrada e a saída são filas circulares de caracteres, para que cada
+//   operação (e cada passo da rolagem ou da limpeza) tenha custo constante;
+//   o texto de uma linha só é montado pela console, ao desenhar
 struct terminal_t {
   // número de caracteres que cabem em uma linha
   int tam_linha;
-  // texto já digitado no terminal, esperando para ser lido
+  // texto já digitado no terminal, esperando para ser lido (cabem até
+  //   tam_linha - 2 caracteres)
   char *entrada;
-  // texto sendo mostrado na saída do terminal
+  int entrada_inicio;
+  int entrada_tam;
+  // texto sendo mostrado na saída do terminal (até tam_linha caracteres)
   char *saida;
+  int saida_inicio;
+  int saida_tam;
   // estado da saída do terminal, que pode ser:
   // normal: aceitando novos caracteres na saída
   // rolando: removendo um caractere no início para gerar espaço.
@@ -26,6 +33,8 @@ struct terminal_t {
   //   da linha, então volta ao estado normal.
   //   entra neste estado quando recebe um caractere na última posição.
   //   não aceita novos caracteres
+  //   os caracteres não são movidos na fila: pos_rolagem diz quantos já
+  //   foram, e o primeiro só sai da fila no fim da rolagem
   // limpando: removendo um caractere no início da linha por vez, até
   //   ficar com a linha vazia, então volta ao estado normal.
   //   entra nesse estado quando recebe um '\n'.
@@ -33,6 +42,8 @@ struct terminal_t {
   enum { normal, rolando, limpando } estado_saida;
   // posicao do caractere que está sendo movido durante uma rolagem
   int pos_rolagem;
+  // pedidos de interrupção pendentes (TERM_INT_TECLADO, TERM_INT_TELA)
+  int interrupcao;
 };
 
 
@@ -43,11 +54,15 @@ terminal_t *terminal_cria(int tam_linha)
 
   self->tam_linha = tam_linha;
 
-  self->saida = calloc(1, tam_linha + 1);
-  self->entrada = calloc(1, tam_linha + 1);
+  self->saida = calloc(1, tam_linha);
+  self->entrada = calloc(1, tam_linha);
   assert(self->saida != NULL && self->entrada != NULL);
+  self->saida_inicio = self->saida_tam = 0;
+  self->entrada_inicio = self->entrada_tam = 0;
 
   self->estado_saida = normal;
+  self->pos_rolagem = 0;
+  self->interrupcao = 0;
 
   return self;
 }
@@ -59,28 +74,34 @@ void terminal_destroi(terminal_t *self)
   free(self);
 }
 
+// caractere na posição 'pos' da saída (a partir do início da linha)
+static char terminal_saida_char(terminal_t *self, int pos)
+{
+  return self->saida[(self->saida_inicio + pos) % self->tam_linha];
+}
+
 static bool terminal_entrada_vazia(terminal_t *self)
 {
-  return self->entrada[0] == '\0';
+  return self->entrada_tam == 0;
 }
 
 static err_t terminal_le_char(terminal_t *self, int *pch)
 {
   if (terminal_entrada_vazia(self)) return ERR_OCUP;
-  char *p = self->entrada;
-  *pch = *p;
-  memmove(p, p + 1, strlen(p));
+  *pch = self->entrada[self->entrada_inicio];
+  self->entrada_inicio = (self->entrada_inicio + 1) % self->tam_linha;
+  self->entrada_tam--;
   return ERR_OK;
 }
 
 void terminal_insere_char(terminal_t *self, char ch)
 {
-  char *p = self->entrada;
-  int tam = strlen(p);
   // se não cabe, ignora silenciosamente
-  if (tam >= self->tam_linha - 2) return;
-  p[tam] = ch;
-  p[tam + 1] = '\0';
+  if (self->entrada_tam >= self->tam_linha - 2) return;
+  self->entrada[(self->entrada_inicio + self->entrada_tam) % self->tam_linha] = ch;
+  self->entrada_tam++;
+  // o teclado passou a ter o que ler
+  if (self->entrada_tam == 1) self->interrupcao |= TERM_INT_TECLADO;
 }
 
 static bool terminal_pode_imprimir(terminal_t *self)
@@ -97,12 +118,10 @@ static err_t terminal_imprime(terminal_t *self, char ch)
     self->estado_saida = limpando;
   } else {
     // insere o caractere no final da linha
-    int tam = strlen(self->saida);
-    self->saida[tam] = ch;
-    tam++;
-    self->saida[tam] = '\0';
+    self->saida[(self->saida_inicio + self->saida_tam) % self->tam_linha] = ch;
+    self->saida_tam++;
     // se encheu a linha, inicia a rolagem
-    if (tam >= self->tam_linha - 1) {
+    if (self->saida_tam >= self->tam_linha - 1) {
       self->estado_saida = rolando;
       self->pos_rolagem = 0;
     }
@@ -112,50 +131,92 @@ static err_t terminal_imprime(terminal_t *self, char ch)
 
 void terminal_limpa_saida(terminal_t *self)
 {
-  self->saida[0] = '\0';
+  self->saida_tam = 0;
+  if (self->estado_saida != normal) self->interrupcao |= TERM_INT_TELA;
   self->estado_saida = normal;
 }
 
+// retira o primeiro caractere da saída
+static void terminal_saida_retira(terminal_t *self)
+{
+  if (self->saida_tam == 0) return;
+  self->saida_inicio = (self->saida_inicio + 1) % self->tam_linha;
+  self->saida_tam--;
+}
+
 static void terminal_atualiza_rolagem(terminal_t *self)
 {
   if (self->estado_saida != rolando) return;
-  // rola um caractere e avança a posição de rolagem
-  char *p = self->saida;
-  char ch = p[self->pos_rolagem + 1];
-  p[self->pos_rolagem] = ch;
+  // avança a posição de rolagem; quando chega no final da linha, o primeiro
+  //   caractere sai, e volta ao estado normal
   self->pos_rolagem++;
-  p[self->pos_rolagem] = ' ';
-  // se chegou no final da string, volta ao estado normal
-  if (ch == '\0') self->estado_saida = normal;
+  if (self->pos_rolagem >= self->saida_tam) {
+    terminal_saida_retira(self);
+    self->estado_saida = normal;
+    self->interrupcao |= TERM_INT_TELA;
+  }
 }
 
 static void terminal_atualiza_limpeza(terminal_t *self)
 {
   if (self->estado_saida != limpando) return;
-  // remove um caractere do início da string
-  char *p = self->saida;
-  int tam = strlen(p);
-  memmove(p, p + 1, tam);
-  tam--;
+  // remove um caractere do início da linha
+  terminal_saida_retira(self);
   // volta ao estado normal se era o último
-  if (tam <= 0) self->estado_saida = normal;
+  if (self->saida_tam == 0) {
+    self->estado_saida = normal;
+    self->interrupcao |= TERM_INT_TELA;
+  }
 }
 
-// altera a string de saída em 1 caractere, se estiver rolando ou limpando
+// altera a linha de saída em 1 caractere, se estiver rolando ou limpando
 void terminal_tictac(terminal_t *self)
 {
   terminal_atualiza_rolagem(self);
   terminal_atualiza_limpeza(self);
 }
 
-char *terminal_txt_entrada(terminal_t *self)
+int terminal_interrupcao(terminal_t *self)
 {
-  return self->entrada;
+  return self->interrupcao;
 }
 
-char *terminal_txt_saida(terminal_t *self)
+void terminal_reconhece_interrupcao(terminal_t *self, int bits)
 {
-  return self->saida;
+  self->interrupcao &= ~bits;
+}
+
+int terminal_txt_entrada(terminal_t *self, char *txt)
+{
+  for (int i = 0; i < self->entrada_tam; i++) {
+    txt[i] = self->entrada[(self->entrada_inicio + i) % self->tam_linha];
+  }
+  txt[self->entrada_tam] = '\0';
+  return self->entrada_tam;
+}
+
+int terminal_txt_saida(terminal_t *self, char *txt)
+{
+  int tam = self->saida_tam;
+  if (self->estado_saida != rolando || self->pos_rolagem == 0) {
+    for (int i = 0; i < tam; i++) {
+      txt[i] = terminal_saida_char(self, i);
+    }
+  } else {
+    // durante a rolagem, os caracteres antes de pos_rolagem já foram movidos
+    //   uma posição para a esquerda, e o que está nela ficou em branco
+    for (int i = 0; i < tam; i++) {
+      if (i < self->pos_rolagem) {
+        txt[i] = terminal_saida_char(self, i + 1);
+      } else if (i == self->pos_rolagem) {
+        txt[i] = ' ';
+      } else {
+        txt[i] = terminal_saida_char(self, i);
+      }
+    }
+  }
+  txt[tam] = '\0';
+  return tam;
 }
 
 // Operações de leitura e escrita no terminal, chamadas pelo controlador de E/S
@@ -190,3 +251,33 @@ err_t terminal_escrita(void *disp, int id, int valor)
   if (subdisp != TERM_TELA) return ERR_OP_INV;
   return terminal_imprime(self, valor);
 }
+
+bool terminal_salva(terminal_t *self, FILE *arq)
+{
+  int campos[] = { self->tam_linha, self->entrada_inicio, self->entrada_tam,
+                   self->saida_inicio, self->saida_tam, self->estado_saida,
+                   self->pos_rolagem, self->interrupcao };
+  return fwrite(campos, sizeof(campos), 1, arq) == 1
+         && fwrite(self->entrada, 1, self->tam_linha, arq) == (size_t)self->tam_linha
+         && fwrite(self->saida, 1, self->tam_linha, arq) == (size_t)self->tam_linha;
+}
+
+bool terminal_restaura(terminal_t *self, FILE *arq)
+{
+  int campos[8];
+  if (fread(campos, sizeof(campos), 1, arq) != 1 || campos[0] != self->tam_linha) {
+    return false;
+  }
+  if (fread(self->entrada, 1, self->tam_linha, arq) != (size_t)self->tam_linha
+      || fread(self->saida, 1, self->tam_linha, arq) != (size_t)self->tam_linha) {
+    return false;
+  }
+  self->entrada_inicio = campos[1];
+  self->entrada_tam = campos[2];
+  self->saida_inicio = campos[3];
+  self->saida_tam = campos[4];
+  self->estado_saida = campos[5];
+  self->pos_rolagem = campos[6];
+  self->interrupcao = campos[7];
+  return true;
+}
@@ -25,15 +25,20 @@
 //   gerar espaço para o novo. a impressão de um \n causa a "limpeza" da linha.
 // a escrita não é possível se a saída estiver rolando ou sendo limpa, o que é
 //   feito um caractere por vez (a cada chamada a tictac).
+// o terminal pede interrupção quando chega um caractere com a entrada vazia,
+//   e quando a saída volta a aceitar caracteres depois de rolar ou limpar; o
+//   pedido fica pendente até ser reconhecido (terminal_reconhece_interrupcao)
 //
 // além das funções que implementam as operações de E/S acessadas pelo controlador
 //   de E/S, contém as funções para o controle do terminal, realizado pela console.
-// a E/S efetiva é realizada pela console. ela obtém acesso às linhas de entrada e
-//   saída chamando terminal_txt_entrada ou terminal_txt_saida. a console insere
+// a E/S efetiva é realizada pela console. ela obtém o texto das linhas de entrada e
+//   saída chamando terminal_txt_entrada ou terminal_txt_saida, que o montam a
+//   partir das filas internas do terminal (só no desenho). a console insere
 //   caracteres digitados no terminal chamando terminal_insere_char, e limpa a
 //   linha de saída com terminal_limpa_saida.
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "err.h"
 
 typedef struct terminal_t terminal_t;
@@ -44,16 +49,22 @@ typedef struct terminal_t terminal_t;
 #define TERM_TELA       2
 #define TERM_TELA_OK    3
 
+// os sentidos em que um terminal pede interrupção (bits)
+#define TERM_INT_TECLADO 1
+#define TERM_INT_TELA    2
+
 // aloca e inicializa um novo terminal
 terminal_t *terminal_cria(int tam_linha);
 // libera a memória ocupada por um terminal
 void terminal_destroi(terminal_t *self);
 
-// retorna a linha de entrada do terminal (para uso pela console)
-char *terminal_txt_entrada(terminal_t *self);
+// copia a linha de entrada do terminal para 'txt', terminada por '\0', e
+//   retorna o número de caracteres (para uso pela console)
+// 'txt' deve ter espaço para tam_linha + 1 caracteres
+int terminal_txt_entrada(terminal_t *self, char *txt);
 
-// retorna a linha de saida do terminal (para uso pela console)
-char *terminal_txt_saida(terminal_t *self);
+// copia a linha de saída do terminal para 'txt', como terminal_txt_entrada
+int terminal_txt_saida(terminal_t *self, char *txt);
 
 // insere um novo caractere na entrada do terminal
 // (para uso pela console, para simular um caractere digitado no teclado)
@@ -65,10 +76,23 @@ void terminal_limpa_saida(terminal_t *self);
 // esta função deve ser chamada periodicamente
 void terminal_tictac(terminal_t *self);
 
+// retorna os pedidos de interrupção pendentes (TERM_INT_TECLADO, TERM_INT_TELA)
+int terminal_interrupcao(terminal_t *self);
+
+// desliga os pedidos de interrupção em 'bits'
+void terminal_reconhece_interrupcao(terminal_t *self, int bits);
+
 // Funções para implementar o protocolo de acesso a um dispositivo pelo
 //   controlador de E/S
 // Devem seguir o protocolo f_leitura_t e f_escrita_t declarados em es.h
 err_t terminal_leitura(void *disp, int id, int *pvalor);
 err_t terminal_escrita(void *disp, int id, int valor);
 
+// grava em 'arq' as linhas de entrada e saída e o estado da saída do terminal
+//   (checkpoint da máquina), e recupera o que foi gravado; o terminal deve ter
+//   o mesmo tamanho de linha
+// retornam false em caso de erro de escrita ou leitura
+bool terminal_salva(terminal_t *self, FILE *arq);
+bool terminal_restaura(terminal_t *self, FILE *arq);
+
 #endif // TERMINAL_H
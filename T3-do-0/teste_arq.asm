@@ -0,0 +1,147 @@
+; teste_arq.asm
+; Programa de teste para os arquivos (SO_ABRE, SO_FECHA, SO_SEL_LE, SO_SEL_ESCR)
+; Lê dados.txt (colocado no disco por cria_disco) linha a linha com
+;   SO_LE_LINHA, mostra cada linha no terminal e a copia para copia.txt;
+;   depois fecha os dois, abre copia.txt de novo e a mostra caractere a
+;   caractere com SO_LE, até o fim do arquivo
+; O relatório final mostra os acertos e faltas da cache de blocos, as
+;   leituras e gravações do disco e o tempo de espera pelo disco
+
+MAX_LINHA define 60
+
+         desv main
+
+; chamadas de sistema
+SO_LE          define 1
+SO_ESCR        define 2
+SO_ABRE        define 3
+SO_FECHA       define 4
+SO_SEL_LE      define 5
+SO_SEL_ESCR    define 6
+SO_MATA_PROC   define 8
+SO_ESCR_BUF    define 16
+SO_LE_LINHA    define 17
+
+; para SO_ABRE: o modo (0 leitura, 1 escrita), seguido do nome
+ab_dados valor 0
+         string 'dados.txt'
+ab_copia valor 1
+         string 'copia.txt'
+ab_relei valor 0
+         string 'copia.txt'
+msg_erro valor 26
+         string 'teste_arq: erro em arquivo'
+
+main
+         ; abre os dois arquivos; a entrada passa a ser dados.txt
+         cargi ab_dados
+         chama abre
+         armm fd_dados
+         cargi ab_copia
+         chama abre
+         armm fd_copia
+         cargm fd_dados
+         trax
+         cargi SO_SEL_LE
+         chamas
+
+laco
+         ; o tamanho máximo vai em linha, e é substituído pelo tamanho lido
+         cargi MAX_LINHA
+         armm linha
+         cargi linha
+         trax
+         cargi SO_LE_LINHA
+         chamas
+         desvn copiado
+
+         ; a linha vai para o terminal (a saída ainda é ele) ...
+         cargi linha
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+         cargi 10
+         chama impch
+         ; ... e para copia.txt
+         cargm fd_copia
+         trax
+         cargi SO_SEL_ESCR
+         chamas
+         cargi linha
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+         desvn erro
+         cargi 10
+         chama impch
+         cargi -1
+         trax
+         cargi SO_SEL_ESCR
+         chamas
+         desv laco
+
+copiado
+         ; fecha os dois (copia.txt passa a ser gravada no disco)
+         cargm fd_dados
+         trax
+         cargi SO_FECHA
+         chamas
+         cargm fd_copia
+         trax
+         cargi SO_FECHA
+         chamas
+
+         ; mostra copia.txt, lida caractere a caractere
+         cargi ab_relei
+         chama abre
+         trax
+         cargi SO_SEL_LE
+         chamas
+relei
+         cargi SO_LE
+         chamas
+         desvn morre
+         chama impch
+         desv relei
+
+erro
+         cargi -1
+         trax
+         cargi SO_SEL_ESCR
+         chamas
+         cargi msg_erro
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+
+morre
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+fd_dados espaco 1
+fd_copia espaco 1
+linha    espaco 1
+         espaco MAX_LINHA
+
+; função que abre o arquivo descrito a partir de A; retorna o descritor em A,
+;   ou termina o programa se der erro
+abre     espaco 1
+         trax
+         cargi SO_ABRE
+         chamas
+         desvn erro
+         ret abre
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
@@ -0,0 +1,49 @@
+; teste_escr_buf.asm
+; Programa de teste para SO_ESCR_BUF
+; Imprime várias vezes uma mensagem com uma só chamada de sistema cada; a
+;   mensagem tem mais caracteres que o buffer de saída do terminal, então o
+;   processo bloqueia com o buffer cheio e continua quando a tela o esvazia
+; A saída esperada é a mensagem repetida, e o relatório final mostra as
+;   chamadas, os caracteres e os bloqueios por buffer cheio
+
+         desv main
+
+; chamadas de sistema
+SO_ESCR_BUF    define 16
+SO_MATA_PROC   define 8
+
+; a mensagem: o tamanho, seguido dos caracteres
+msg      valor 78
+         string 'teste_escr_buf: uma linha inteira escrita com uma unica chamada de sistema!   '
+msg_erro valor 18
+         string 'SO_ESCR_BUF falhou'
+
+main
+         cargi 5
+         armm vezes
+laco
+         cargi msg
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+         desvn erro
+         cargm vezes
+         sub um
+         armm vezes
+         desvnz laco
+         desv morre
+
+erro
+         cargi msg_erro
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+
+morre
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+vezes    espaco 1
+um       valor 1
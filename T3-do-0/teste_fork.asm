@@ -0,0 +1,93 @@
+; teste_fork.asm
+; Programa de teste para SO_FORK
+; Cria uma cópia de si mesmo; o filho troca 'valor' e imprime 'F' seguido do
+;   valor, o pai espera o filho terminar e imprime 'P' seguido do seu valor,
+;   que não muda com a escrita do filho (as páginas são copiadas na escrita)
+; A saída esperada é "teste_fork: F7 P1"; o relatório final mostra as faltas
+;   de proteção e as páginas copiadas
+
+         desv main
+prog     string 'teste_fork: '
+msg_erro string 'SO_FORK recusado!'
+
+; chamadas de sistema
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_ESPERA_PROC define 9
+SO_FORK        define 14
+
+main
+         ; Mensagem inicial
+         cargi prog
+         chama impstr
+
+         ; Cria a cópia: A é 0 no filho e o pid do filho no pai
+         cargi SO_FORK
+         chamas
+         desvz filho
+         desvn erro
+         armm pid_filho
+
+         ; pai: espera o filho e imprime o valor, que deve continuar 1
+         cargm pid_filho
+         trax
+         cargi SO_ESPERA_PROC
+         chamas
+         cargi ' '
+         chama impch
+         cargi 'P'
+         chama impch
+         cargm valor
+         soma ch_zero
+         chama impch
+         chama morre
+
+filho
+         ; filho: altera o valor e imprime
+         cargi 7
+         armm valor
+         cargi 'F'
+         chama impch
+         cargm valor
+         soma ch_zero
+         chama impch
+         chama morre
+
+erro
+         cargi msg_erro
+         chama impstr
+         chama morre
+
+morre    espaco 1
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         ret morre
+
+pid_filho espaco 1
+valor    valor 1
+ch_zero  valor '0'
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+impstr1
+         cargx 0
+         desvz impstrf
+         chama impch
+         incx
+         desv impstr1
+impstrf  ret impstr
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
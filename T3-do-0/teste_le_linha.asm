@@ -0,0 +1,76 @@
+; teste_le_linha.asm
+; Programa de teste para SO_LE_LINHA
+; Lê 3 linhas do terminal, cada uma com uma só chamada de sistema, e imprime
+;   cada uma entre colchetes com SO_ESCR_BUF (a área lida já está no formato
+;   que SO_ESCR_BUF espera: o tamanho seguido dos caracteres)
+; Para testar, entre linhas no terminal pela console, ex: "eaola mundo"; o
+;   relatório final mostra um bloqueio por linha, não um por caractere
+
+N_LINHAS define 3
+MAX_LINHA define 40
+
+         desv main
+
+; chamadas de sistema
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_ESCR_BUF    define 16
+SO_LE_LINHA    define 17
+
+prog     valor 33
+         string 'teste_le_linha: digite 3 linhas  '
+
+main
+         cargi prog
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+
+         cargi N_LINHAS
+         armm vezes
+laco
+         ; o tamanho máximo vai em linha, e é substituído pelo tamanho lido
+         cargi MAX_LINHA
+         armm linha
+         cargi linha
+         trax
+         cargi SO_LE_LINHA
+         chamas
+         desvn morre
+
+         cargi '['
+         chama impch
+         cargi linha
+         trax
+         cargi SO_ESCR_BUF
+         chamas
+         cargi ']'
+         chama impch
+
+         cargm vezes
+         sub um
+         armm vezes
+         desvnz laco
+
+morre
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+vezes    espaco 1
+um       valor 1
+linha    espaco 1
+         espaco MAX_LINHA
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
@@ -0,0 +1,153 @@
+; teste_sbrk.asm
+; Programa de teste para SO_SBRK (área crescida com páginas zeradas sob demanda)
+; Pede N palavras ao SO, grava 0..N-1 nelas, soma tudo e imprime a soma
+; (para N = 300 a soma deve ser 44850)
+
+N        define 300
+
+         desv main
+prog     string 'teste_sbrk: pedindo memoria... '
+msg_erro string 'SO_SBRK falhou!'
+
+; chamadas de sistema
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_SBRK        define 10
+
+main
+         ; Mensagem inicial
+         cargi prog
+         chama impstr
+
+         ; Pede N palavras; A recebe o início da área nova
+         cargi N
+         trax
+         cargi SO_SBRK
+         chamas
+         desvn erro
+         armm base
+
+         ; Grava i em base+i
+         cargi 0
+         armm i
+grava
+         cargm base
+         soma i
+         trax
+         cargm i
+         armx 0
+         cargm i
+         soma um
+         armm i
+         sub ene
+         desvnz grava
+
+         ; Soma o conteúdo de base..base+N-1
+         cargi 0
+         armm i
+         armm total
+le
+         cargm base
+         soma i
+         trax
+         cargx 0
+         soma total
+         armm total
+         cargm i
+         soma um
+         armm i
+         sub ene
+         desvnz le
+
+         cargm total
+         chama impnum
+         chama morre
+
+erro
+         cargi msg_erro
+         chama impstr
+         chama morre
+
+morre    espaco 1
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         ret morre
+
+base     espaco 1
+i        espaco 1
+total    espaco 1
+um       valor 1
+ene      valor N
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+impstr1
+         cargx 0
+         desvz impstrf
+         chama impch
+         incx
+         desv impstr1
+impstrf  ret impstr
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
+
+; escreve o valor de A no terminal, em decimal
+impnum  espaco 1
+        armm ei_num
+        desvp ei_pos
+        desvn ei_neg
+        cargi '0'
+        chama impch
+        desv ei_f
+ei_neg
+        neg
+        armm ei_num
+        cargi '-'
+        chama impch
+ei_pos
+        cargi 1
+        armm ei_mul
+ei_1
+        cargm ei_mul
+        sub ei_num
+        desvz ei_3
+        desvp ei_2
+        cargm ei_mul
+        mult dez
+        armm ei_mul
+        desv ei_1
+ei_2
+        cargm ei_mul
+        div dez
+        armm ei_mul
+ei_3
+        cargm ei_num
+        div ei_mul
+        resto dez
+        soma a_zero
+        chama impch
+        cargm ei_mul
+        div dez
+        armm ei_mul
+        desvp ei_3
+ei_f
+        cargi ' '
+        chama impch
+        ret impnum
+ei_num  espaco 1
+ei_mul  espaco 1
+a_zero  valor '0'
+dez     valor 10
@@ -0,0 +1,104 @@
+; teste_tempo_real.asm
+; Programa de teste para a classe de tempo real (SO_TEMPO_REAL e SO_FIM_PERIODO)
+; Declara período de 6 ticks, orçamento de 2 e prazo de 5; em cada período faz
+;   um trabalho de TRAB voltas e imprime um '.', por NPER períodos
+; O relatório final mostra os trabalhos, as perdas de prazo e os atrasos
+
+NPER     define 10
+TRAB     define 10
+
+         desv main
+prog     string 'teste_tempo_real: '
+msg_erro string 'SO_TEMPO_REAL recusado!'
+
+; período, orçamento e prazo, em ticks do relógio
+param    valor 6
+         valor 2
+         valor 5
+
+; chamadas de sistema
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_TEMPO_REAL  define 12
+SO_FIM_PERIODO define 13
+
+main
+         ; Mensagem inicial
+         cargi prog
+         chama impstr
+
+         ; Vira processo de tempo real
+         cargi param
+         trax
+         cargi SO_TEMPO_REAL
+         chamas
+         desvnz erro
+
+         cargi 0
+         armm periodo
+laco
+         ; o trabalho do período: TRAB voltas sem fazer nada
+         cargi 0
+         armm i
+trab
+         cargm i
+         soma um
+         armm i
+         sub trab_n
+         desvnz trab
+
+         cargi '.'
+         chama impch
+
+         ; fim do trabalho; espera o próximo período
+         cargi SO_FIM_PERIODO
+         chamas
+
+         cargm periodo
+         soma um
+         armm periodo
+         sub nper
+         desvnz laco
+
+         chama morre
+
+erro
+         cargi msg_erro
+         chama impstr
+         chama morre
+
+morre    espaco 1
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         ret morre
+
+periodo  espaco 1
+i        espaco 1
+um       valor 1
+nper     valor NPER
+trab_n   valor TRAB
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+impstr1
+         cargx 0
+         desvz impstrf
+         chama impch
+         incx
+         desv impstr1
+impstrf  ret impstr
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
@@ -0,0 +1,120 @@
+; teste_thread.asm
+; Programa de teste para SO_CRIA_THREAD
+; Cria duas threads, que executam na mesma memória do processo: cada uma
+;   imprime uma letra e guarda um valor numa variável global; o processo
+;   espera as duas terminarem e imprime a soma dos valores
+; A saída esperada é "teste_thread: ab 7" (as letras em qualquer ordem)
+; As threads não usam as funções impch/impstr, que guardam o endereço de
+;   retorno na memória e não podem ser usadas por duas threads ao mesmo tempo
+
+         desv main
+prog     string 'teste_thread: '
+msg_erro string 'SO_CRIA_THREAD recusado!'
+
+; chamadas de sistema
+SO_ESCR        define 2
+SO_MATA_PROC   define 8
+SO_ESPERA_PROC define 9
+SO_CRIA_THREAD define 15
+
+main
+         ; Mensagem inicial
+         cargi prog
+         chama impstr
+
+         ; Cria as threads
+         cargi thread1
+         trax
+         cargi SO_CRIA_THREAD
+         chamas
+         desvn erro
+         armm tid1
+         cargi thread2
+         trax
+         cargi SO_CRIA_THREAD
+         chamas
+         desvn erro
+         armm tid2
+
+         ; Espera as duas
+         cargm tid1
+         trax
+         cargi SO_ESPERA_PROC
+         chamas
+         cargm tid2
+         trax
+         cargi SO_ESPERA_PROC
+         chamas
+
+         ; Os valores que elas deixaram na memória compartilhada
+         cargi ' '
+         chama impch
+         cargm v1
+         soma v2
+         soma ch_zero
+         chama impch
+         chama morre
+
+thread1
+         cargi 'a'
+         trax
+         cargi SO_ESCR
+         chamas
+         cargi 3
+         armm v1
+         desv fim_thread
+
+thread2
+         cargi 'b'
+         trax
+         cargi SO_ESCR
+         chamas
+         cargi 4
+         armm v2
+
+fim_thread
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+
+erro
+         cargi msg_erro
+         chama impstr
+         chama morre
+
+morre    espaco 1
+         cargi 0
+         trax
+         cargi SO_MATA_PROC
+         chamas
+         ret morre
+
+tid1     espaco 1
+tid2     espaco 1
+v1       valor 0
+v2       valor 0
+ch_zero  valor '0'
+
+; imprime a string que inicia em A (destroi X)
+impstr   espaco 1
+         trax
+impstr1
+         cargx 0
+         desvz impstrf
+         chama impch
+         incx
+         desv impstr1
+impstrf  ret impstr
+
+; função que chama o SO para imprimir o caractere em A
+impch    espaco 1
+         trax
+         armm impch_X
+         cargi SO_ESCR
+         chamas
+         trax
+         cargm impch_X
+         trax
+         ret impch
+impch_X  espaco 1
@@ -7,27 +7,58 @@
 #include "err.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// região contígua de slots livres na memória secundária
+typedef struct {
+  int base;               // primeiro slot da região
+  int tamanho;            // número de slots na região
+} extensao_t;
 
 struct vm_estado_t {
   int num_quadros;
-  quadro_desc_t *quadros;
+  // tabela de quadros como estrutura de vetores: um vetor por campo, para que
+  //   as varreduras (envelhecimento, escolha de vítima) sejam laços simples
+  //   sobre memória contígua, que o compilador consegue vetorizar
+  unsigned char *quadro_livre;      // 1 se o quadro está disponível
+  int *quadro_dono;                 // pid do processo que ocupa o quadro, ou -1
+  int *quadro_pagina;               // página virtual ocupante, ou -1
+  unsigned long *quadro_carimbo;    // usado para FIFO
+  unsigned long *quadro_idade;      // usado para envelhecimento/LRU aproximado
+  int *quadro_refs;                 // processos que mapeiam o quadro (cópia na escrita)
+  int num_quadros_livres;
   int num_paginas_sec;
   pagina_sec_desc_t *paginas_sec;
   mem_t *mem_secundaria;
   int tam_mem_sec;
+  // memória secundária mapeada de um arquivo (alternativa a mem_secundaria)
+  void *mapa;             // início do mapeamento (cabeçalho), ou NULL
+  size_t tam_mapa;        // tamanho do mapeamento em bytes
+  int *dados_mapa;        // palavras da memória secundária dentro do mapeamento
+  // regiões livres da secundária, ordenadas por base e sem regiões adjacentes
+  // no pior caso (slots alternados) são num_paginas_sec / 2 + 1 regiões
+  extensao_t *livres;
+  int num_livres;
 };
 
+static void libera_mem_sec(vm_estado_t *estado);
+
 static void inicializa_quadros(vm_estado_t *estado)
 {
   for (int i = 0; i < estado->num_quadros; i++) {
-    quadro_desc_t *q = &estado->quadros[i];
-    q->livre = true;
-    q->dono_pid = -1;
-    q->pagina_virtual = -1;
-    q->carimbo_fifo = 0;
-    q->idade = 0;
+    estado->quadro_livre[i] = 1;
+    estado->quadro_dono[i] = -1;
+    estado->quadro_pagina[i] = -1;
+    estado->quadro_carimbo[i] = 0;
+    estado->quadro_idade[i] = 0;
+    estado->quadro_refs[i] = 0;
   }
+  estado->num_quadros_livres = estado->num_quadros;
 }
 
 static void inicializa_paginas(vm_estado_t *estado)
@@ -39,7 +70,12 @@ static void inicializa_paginas(vm_estado_t *estado)
     p->pagina_virtual = -1;
     p->base_endereco = -1;
     p->tamanho = 0;
+    p->referencias = 0;
   }
+  // toda a secundária forma uma única região livre
+  estado->livres[0].base = 0;
+  estado->livres[0].tamanho = estado->num_paginas_sec;
+  estado->num_livres = 1;
 }
 
 vm_estado_t *vm_estado_cria(int num_quadros, int num_paginas_sec)
@@ -48,23 +84,43 @@ vm_estado_t *vm_estado_cria(int num_quadros, int num_paginas_sec)
   assert(estado != NULL);
 
   estado->num_quadros = num_quadros;
+  estado->num_quadros_livres = 0;
   estado->num_paginas_sec = num_paginas_sec;
   estado->mem_secundaria = NULL;
   estado->tam_mem_sec = 0;
+  estado->mapa = NULL;
+  estado->tam_mapa = 0;
+  estado->dados_mapa = NULL;
 
   if (num_quadros > 0) {
-    estado->quadros = malloc(sizeof(*estado->quadros) * num_quadros);
-    assert(estado->quadros != NULL);
+    estado->quadro_livre = malloc(sizeof(*estado->quadro_livre) * num_quadros);
+    estado->quadro_dono = malloc(sizeof(*estado->quadro_dono) * num_quadros);
+    estado->quadro_pagina = malloc(sizeof(*estado->quadro_pagina) * num_quadros);
+    estado->quadro_carimbo = malloc(sizeof(*estado->quadro_carimbo) * num_quadros);
+    estado->quadro_idade = malloc(sizeof(*estado->quadro_idade) * num_quadros);
+    estado->quadro_refs = malloc(sizeof(*estado->quadro_refs) * num_quadros);
+    assert(estado->quadro_livre != NULL && estado->quadro_dono != NULL
+           && estado->quadro_pagina != NULL && estado->quadro_carimbo != NULL
+           && estado->quadro_idade != NULL && estado->quadro_refs != NULL);
   } else {
-    estado->quadros = NULL;
+    estado->quadro_livre = NULL;
+    estado->quadro_dono = NULL;
+    estado->quadro_pagina = NULL;
+    estado->quadro_carimbo = NULL;
+    estado->quadro_idade = NULL;
+    estado->quadro_refs = NULL;
   }
 
   if (num_paginas_sec > 0) {
     estado->paginas_sec = malloc(sizeof(*estado->paginas_sec) * num_paginas_sec);
     assert(estado->paginas_sec != NULL);
+    estado->livres = malloc(sizeof(*estado->livres) * (num_paginas_sec / 2 + 1));
+    assert(estado->livres != NULL);
   } else {
     estado->paginas_sec = NULL;
+    estado->livres = NULL;
   }
+  estado->num_livres = 0;
 
   vm_estado_reseta(estado);
   return estado;
@@ -75,11 +131,15 @@ void vm_estado_destroi(vm_estado_t *estado)
   if (estado == NULL) {
     return;
   }
-  if (estado->mem_secundaria != NULL) {
-    mem_destroi(estado->mem_secundaria);
-  }
-  free(estado->quadros);
+  libera_mem_sec(estado);
+  free(estado->quadro_livre);
+  free(estado->quadro_dono);
+  free(estado->quadro_pagina);
+  free(estado->quadro_carimbo);
+  free(estado->quadro_idade);
+  free(estado->quadro_refs);
   free(estado->paginas_sec);
+  free(estado->livres);
   free(estado);
 }
 
@@ -88,17 +148,57 @@ int vm_estado_num_quadros(const vm_estado_t *estado)
   return estado != NULL ? estado->num_quadros : 0;
 }
 
+int vm_estado_num_quadros_livres(const vm_estado_t *estado)
+{
+  return estado != NULL ? estado->num_quadros_livres : 0;
+}
+
 int vm_estado_num_paginas_sec(const vm_estado_t *estado)
 {
   return estado != NULL ? estado->num_paginas_sec : 0;
 }
 
-quadro_desc_t *vm_estado_quadro(vm_estado_t *estado, int indice)
+// true se 'indice' é um quadro existente
+static bool quadro_valido(const vm_estado_t *estado, int indice)
 {
-  if (estado == NULL || indice < 0 || indice >= estado->num_quadros) {
-    return NULL;
+  return estado != NULL && indice >= 0 && indice < estado->num_quadros;
+}
+
+bool vm_estado_quadro_livre(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) && estado->quadro_livre[indice];
+}
+
+int vm_estado_quadro_dono(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) ? estado->quadro_dono[indice] : -1;
+}
+
+int vm_estado_quadro_pagina(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) ? estado->quadro_pagina[indice] : -1;
+}
+
+unsigned long vm_estado_quadro_carimbo(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) ? estado->quadro_carimbo[indice] : 0;
+}
+
+unsigned long vm_estado_quadro_idade(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) ? estado->quadro_idade[indice] : 0;
+}
+
+int vm_estado_quadro_referencias(const vm_estado_t *estado, int indice)
+{
+  return quadro_valido(estado, indice) ? estado->quadro_refs[indice] : 0;
+}
+
+void vm_estado_define_idade(vm_estado_t *estado, int indice, unsigned long idade)
+{
+  if (quadro_valido(estado, indice)) {
+    estado->quadro_idade[indice] = idade;
   }
-  return &estado->quadros[indice];
 }
 
 pagina_sec_desc_t *vm_estado_pagina_sec(vm_estado_t *estado, int indice)
@@ -114,7 +214,7 @@ void vm_estado_reseta(vm_estado_t *estado)
   if (estado == NULL) {
     return;
   }
-  if (estado->quadros != NULL) {
+  if (estado->num_quadros > 0) {
     inicializa_quadros(estado);
   }
   if (estado->paginas_sec != NULL) {
@@ -128,7 +228,7 @@ int vm_estado_busca_quadro_livre(vm_estado_t *estado)
     return -1;
   }
   for (int i = 0; i < estado->num_quadros; i++) {
-    if (estado->quadros[i].livre) {
+    if (estado->quadro_livre[i]) {
       return i;
     }
   }
@@ -137,41 +237,224 @@ int vm_estado_busca_quadro_livre(vm_estado_t *estado)
 
 void vm_estado_ocupa_quadro(vm_estado_t *estado, int indice, int pid, int pagina_virtual, unsigned long carimbo)
 {
-  quadro_desc_t *quadro = vm_estado_quadro(estado, indice);
-  if (quadro == NULL) {
+  if (!quadro_valido(estado, indice)) {
     return;
   }
-  quadro->livre = false;
-  quadro->dono_pid = pid;
-  quadro->pagina_virtual = pagina_virtual;
-  quadro->carimbo_fifo = carimbo;
-  quadro->idade = 0;
+  if (estado->quadro_livre[indice]) {
+    estado->num_quadros_livres--;
+  }
+  estado->quadro_livre[indice] = 0;
+  estado->quadro_dono[indice] = pid;
+  estado->quadro_pagina[indice] = pagina_virtual;
+  estado->quadro_carimbo[indice] = carimbo;
+  estado->quadro_idade[indice] = 0;
+  estado->quadro_refs[indice] = 1;
+}
+
+void vm_estado_retem_quadro(vm_estado_t *estado, int indice)
+{
+  if (quadro_valido(estado, indice) && !estado->quadro_livre[indice]) {
+    estado->quadro_refs[indice]++;
+  }
+}
+
+int vm_estado_solta_quadro(vm_estado_t *estado, int indice)
+{
+  if (!quadro_valido(estado, indice) || estado->quadro_livre[indice]) {
+    return 0;
+  }
+  if (--estado->quadro_refs[indice] > 0) {
+    return estado->quadro_refs[indice];
+  }
+  vm_estado_libera_quadro(estado, indice);
+  return 0;
+}
+
+void vm_estado_define_dono(vm_estado_t *estado, int indice, int pid)
+{
+  if (quadro_valido(estado, indice) && !estado->quadro_livre[indice]) {
+    estado->quadro_dono[indice] = pid;
+  }
 }
 
 void vm_estado_libera_quadro(vm_estado_t *estado, int indice)
 {
-  quadro_desc_t *quadro = vm_estado_quadro(estado, indice);
-  if (quadro == NULL) {
+  if (!quadro_valido(estado, indice)) {
     return;
   }
-  quadro->livre = true;
-  quadro->dono_pid = -1;
-  quadro->pagina_virtual = -1;
+  if (!estado->quadro_livre[indice]) {
+    estado->num_quadros_livres++;
+  }
+  estado->quadro_livre[indice] = 1;
+  estado->quadro_dono[indice] = -1;
+  estado->quadro_pagina[indice] = -1;
+  estado->quadro_refs[indice] = 0;
 }
 
-int vm_estado_busca_pagsec_livre(vm_estado_t *estado)
+int vm_estado_libera_quadros_do_processo(vm_estado_t *estado, int pid)
 {
   if (estado == NULL) {
-    return -1;
+    return 0;
   }
-  for (int i = 0; i < estado->num_paginas_sec; i++) {
-    if (!estado->paginas_sec[i].ocupado) {
+  int liberados = 0;
+  for (int i = 0; i < estado->num_quadros; i++) {
+    if (!estado->quadro_livre[i] && estado->quadro_dono[i] == pid) {
+      vm_estado_libera_quadro(estado, i);
+      liberados++;
+    }
+  }
+  return liberados;
+}
+
+void vm_estado_envelhece_quadros(vm_estado_t *estado, const int quadros[],
+                                 const unsigned char acessados[], int n,
+                                 int antes, int depois)
+{
+  if (estado == NULL || antes <= 0) {
+    return;
+  }
+  unsigned long *idade = estado->quadro_idade;
+  int bits = VM_BITS_IDADE_MSB + 1;
+  for (int i = 0; i < n; i++) {
+    int q = quadros[i];
+    if (q < 0 || q >= estado->num_quadros) continue;
+    unsigned long v = antes < bits ? idade[q] >> antes : 0;
+    v |= (unsigned long)(acessados[i] != 0) << VM_BITS_IDADE_MSB;
+    idade[q] = depois < bits ? v >> depois : 0;
+  }
+}
+
+// índice do quadro ocupado por processo (não reservado) com o menor valor em
+//   'chave', ou -1 se não houver
+// a busca do mínimo é separada da busca do índice para que o primeiro laço
+//   seja uma redução simples, vetorizável
+static int busca_minimo(const vm_estado_t *estado, const unsigned long *chave)
+{
+  int n = estado->num_quadros;
+  const unsigned char *livre = estado->quadro_livre;
+  const int *dono = estado->quadro_dono;
+  unsigned long minimo = ULONG_MAX;
+  for (int i = 0; i < n; i++) {
+    unsigned long k = (livre[i] | (dono[i] < 0)) ? ULONG_MAX : chave[i];
+    minimo = k < minimo ? k : minimo;
+  }
+  for (int i = 0; i < n; i++) {
+    if (!livre[i] && dono[i] >= 0 && chave[i] == minimo) {
       return i;
     }
   }
   return -1;
 }
 
+int vm_estado_busca_vitima(vm_estado_t *estado, vm_criterio_vitima_t criterio)
+{
+  if (estado == NULL || estado->num_quadros <= 0) {
+    return -1;
+  }
+  if (criterio == VITIMA_MENOR_CARIMBO) {
+    return busca_minimo(estado, estado->quadro_carimbo);
+  }
+  return busca_minimo(estado, estado->quadro_idade);
+}
+
+int vm_estado_aloca_extensao(vm_estado_t *estado, int num_paginas)
+{
+  if (estado == NULL || num_paginas <= 0) {
+    return -1;
+  }
+  // best-fit: a menor região que comporta o pedido
+  int escolhida = -1;
+  for (int i = 0; i < estado->num_livres; i++) {
+    int tam = estado->livres[i].tamanho;
+    if (tam < num_paginas) {
+      continue;
+    }
+    if (escolhida < 0 || tam < estado->livres[escolhida].tamanho) {
+      escolhida = i;
+      if (tam == num_paginas) {
+        break;
+      }
+    }
+  }
+  if (escolhida < 0) {
+    return -1;
+  }
+
+  extensao_t *ext = &estado->livres[escolhida];
+  int base = ext->base;
+  ext->base += num_paginas;
+  ext->tamanho -= num_paginas;
+  if (ext->tamanho == 0) {
+    for (int i = escolhida; i < estado->num_livres - 1; i++) {
+      estado->livres[i] = estado->livres[i + 1];
+    }
+    estado->num_livres--;
+  }
+  return base;
+}
+
+void vm_estado_libera_extensao(vm_estado_t *estado, int base, int num_paginas)
+{
+  if (estado == NULL || num_paginas <= 0) {
+    return;
+  }
+  if (base < 0 || base + num_paginas > estado->num_paginas_sec) {
+    return;
+  }
+  for (int i = base; i < base + num_paginas; i++) {
+    vm_estado_libera_pagsec(estado, i);
+  }
+
+  // posição da região na lista ordenada
+  int pos = 0;
+  while (pos < estado->num_livres && estado->livres[pos].base < base) {
+    pos++;
+  }
+  bool junta_anterior = pos > 0
+    && estado->livres[pos - 1].base + estado->livres[pos - 1].tamanho == base;
+  bool junta_seguinte = pos < estado->num_livres
+    && base + num_paginas == estado->livres[pos].base;
+
+  if (junta_anterior && junta_seguinte) {
+    estado->livres[pos - 1].tamanho += num_paginas + estado->livres[pos].tamanho;
+    for (int i = pos; i < estado->num_livres - 1; i++) {
+      estado->livres[i] = estado->livres[i + 1];
+    }
+    estado->num_livres--;
+  } else if (junta_anterior) {
+    estado->livres[pos - 1].tamanho += num_paginas;
+  } else if (junta_seguinte) {
+    estado->livres[pos].base = base;
+    estado->livres[pos].tamanho += num_paginas;
+  } else {
+    for (int i = estado->num_livres; i > pos; i--) {
+      estado->livres[i] = estado->livres[i - 1];
+    }
+    estado->livres[pos].base = base;
+    estado->livres[pos].tamanho = num_paginas;
+    estado->num_livres++;
+  }
+}
+
+int vm_estado_num_extensoes_livres(const vm_estado_t *estado)
+{
+  return estado != NULL ? estado->num_livres : 0;
+}
+
+int vm_estado_maior_extensao_livre(const vm_estado_t *estado)
+{
+  if (estado == NULL) {
+    return 0;
+  }
+  int maior = 0;
+  for (int i = 0; i < estado->num_livres; i++) {
+    if (estado->livres[i].tamanho > maior) {
+      maior = estado->livres[i].tamanho;
+    }
+  }
+  return maior;
+}
+
 void vm_estado_ocupa_pagsec(vm_estado_t *estado, int indice, int pid, int pagina_virtual, int base_endereco, int tamanho)
 {
   pagina_sec_desc_t *pagina = vm_estado_pagina_sec(estado, indice);
@@ -183,6 +466,7 @@ void vm_estado_ocupa_pagsec(vm_estado_t *estado, int indice, int pid, int pagina
   pagina->pagina_virtual = pagina_virtual;
   pagina->base_endereco = base_endereco;
   pagina->tamanho = tamanho;
+  pagina->referencias = 1;
 }
 
 void vm_estado_libera_pagsec(vm_estado_t *estado, int indice)
@@ -196,37 +480,241 @@ void vm_estado_libera_pagsec(vm_estado_t *estado, int indice)
   pagina->pagina_virtual = -1;
   pagina->base_endereco = -1;
   pagina->tamanho = 0;
+  pagina->referencias = 0;
 }
 
-void vm_estado_configura_mem_sec(vm_estado_t *estado, int tamanho)
+void vm_estado_retem_pagsec(vm_estado_t *estado, int indice)
 {
-  if (estado == NULL) {
-    return;
+  pagina_sec_desc_t *pagina = vm_estado_pagina_sec(estado, indice);
+  if (pagina != NULL && pagina->ocupado) {
+    pagina->referencias++;
   }
+}
+
+int vm_estado_solta_pagsec(vm_estado_t *estado, int indice)
+{
+  pagina_sec_desc_t *pagina = vm_estado_pagina_sec(estado, indice);
+  if (pagina == NULL || !pagina->ocupado) {
+    return 0;
+  }
+  if (--pagina->referencias > 0) {
+    return pagina->referencias;
+  }
+  vm_estado_libera_extensao(estado, indice, 1);
+  return 0;
+}
+
+// libera a memória secundária, seja ela um mem_t ou um arquivo mapeado
+static void libera_mem_sec(vm_estado_t *estado)
+{
   if (estado->mem_secundaria != NULL) {
     mem_destroi(estado->mem_secundaria);
     estado->mem_secundaria = NULL;
   }
+  if (estado->mapa != NULL) {
+    msync(estado->mapa, estado->tam_mapa, MS_ASYNC);
+    munmap(estado->mapa, estado->tam_mapa);
+    estado->mapa = NULL;
+    estado->dados_mapa = NULL;
+    estado->tam_mapa = 0;
+  }
+  estado->tam_mem_sec = 0;
+}
+
+// true se a memória secundária está configurada (em qualquer das formas)
+static bool tem_mem_sec(vm_estado_t *estado)
+{
+  return estado->mem_secundaria != NULL || estado->dados_mapa != NULL;
+}
+
+void vm_estado_configura_mem_sec(vm_estado_t *estado, int tamanho)
+{
+  if (estado == NULL) {
+    return;
+  }
+  libera_mem_sec(estado);
   if (tamanho <= 0) {
-    estado->tam_mem_sec = 0;
     return;
   }
   estado->mem_secundaria = mem_cria(tamanho);
   estado->tam_mem_sec = tamanho;
 }
 
+bool vm_estado_configura_mem_sec_arquivo(vm_estado_t *estado, int tamanho, const char *nome)
+{
+  if (estado == NULL || nome == NULL || tamanho <= 0) {
+    return false;
+  }
+  libera_mem_sec(estado);
+
+  int fd = open(nome, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  // o conteúdo de uma execução anterior não serve (o SO recria os
+  //   descritores das páginas e recarrega os programas a cada boot);
+  //   ftruncate para 0 e de volta ao tamanho deixa o arquivo zerado
+  size_t tam_mapa = (size_t)tamanho * sizeof(int);
+  if (ftruncate(fd, 0) != 0 || ftruncate(fd, tam_mapa) != 0) {
+    close(fd);
+    return false;
+  }
+
+  void *mapa = mmap(NULL, tam_mapa, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // o mapeamento continua válido depois de fechar o descritor
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return false;
+  }
+
+  estado->mapa = mapa;
+  estado->tam_mapa = tam_mapa;
+  estado->dados_mapa = mapa;
+  estado->tam_mem_sec = tamanho;
+  return true;
+}
+
 err_t vm_estado_sec_escreve(vm_estado_t *estado, int endereco, int valor)
 {
-  if (estado == NULL || estado->mem_secundaria == NULL) {
+  if (estado == NULL || !tem_mem_sec(estado)) {
     return ERR_OP_INV;
   }
-  return mem_escreve(estado->mem_secundaria, endereco, valor);
+  if (estado->dados_mapa == NULL) {
+    return mem_escreve(estado->mem_secundaria, endereco, valor);
+  }
+  if (endereco < 0 || endereco >= estado->tam_mem_sec) {
+    return ERR_END_INV;
+  }
+  estado->dados_mapa[endereco] = valor;
+  return ERR_OK;
 }
 
 err_t vm_estado_sec_le(vm_estado_t *estado, int endereco, int *valor)
 {
-  if (estado == NULL || estado->mem_secundaria == NULL) {
+  if (estado == NULL || !tem_mem_sec(estado)) {
+    return ERR_OP_INV;
+  }
+  if (estado->dados_mapa == NULL) {
+    return mem_le(estado->mem_secundaria, endereco, valor);
+  }
+  if (endereco < 0 || endereco >= estado->tam_mem_sec) {
+    return ERR_END_INV;
+  }
+  *valor = estado->dados_mapa[endereco];
+  return ERR_OK;
+}
+
+err_t vm_estado_sec_escreve_bloco(vm_estado_t *estado, int endereco, const int *valores, int n)
+{
+  if (estado == NULL || !tem_mem_sec(estado)) {
     return ERR_OP_INV;
   }
-  return mem_le(estado->mem_secundaria, endereco, valor);
+  if (endereco < 0 || n < 0 || endereco + n > estado->tam_mem_sec) {
+    return ERR_END_INV;
+  }
+  if (estado->dados_mapa != NULL) {
+    memcpy(&estado->dados_mapa[endereco], valores, n * sizeof(int));
+    return ERR_OK;
+  }
+  for (int i = 0; i < n; i++) {
+    err_t err = mem_escreve(estado->mem_secundaria, endereco + i, valores[i]);
+    if (err != ERR_OK) {
+      return err;
+    }
+  }
+  return ERR_OK;
+}
+
+err_t vm_estado_sec_le_bloco(vm_estado_t *estado, int endereco, int *valores, int n)
+{
+  if (estado == NULL || !tem_mem_sec(estado)) {
+    return ERR_OP_INV;
+  }
+  if (endereco < 0 || n < 0 || endereco + n > estado->tam_mem_sec) {
+    return ERR_END_INV;
+  }
+  if (estado->dados_mapa != NULL) {
+    memcpy(valores, &estado->dados_mapa[endereco], n * sizeof(int));
+    return ERR_OK;
+  }
+  for (int i = 0; i < n; i++) {
+    err_t err = mem_le(estado->mem_secundaria, endereco + i, &valores[i]);
+    if (err != ERR_OK) {
+      return err;
+    }
+  }
+  return ERR_OK;
+}
+
+// grava e lê 'n' itens de 'tam' bytes, retornando true se todos foram
+//   transferidos
+static bool grava(FILE *arq, const void *dados, size_t tam, int n)
+{
+  return n <= 0 || fwrite(dados, tam, n, arq) == (size_t)n;
+}
+
+static bool le(FILE *arq, void *dados, size_t tam, int n)
+{
+  return n <= 0 || fread(dados, tam, n, arq) == (size_t)n;
+}
+
+bool vm_estado_salva(vm_estado_t *estado, FILE *arq)
+{
+  int n = estado->num_quadros;
+  int geometria[3] = { estado->num_quadros, estado->num_paginas_sec, estado->tam_mem_sec };
+  bool ok = grava(arq, geometria, sizeof(int), 3)
+            && grava(arq, estado->quadro_livre, sizeof(*estado->quadro_livre), n)
+            && grava(arq, estado->quadro_dono, sizeof(*estado->quadro_dono), n)
+            && grava(arq, estado->quadro_pagina, sizeof(*estado->quadro_pagina), n)
+            && grava(arq, estado->quadro_carimbo, sizeof(*estado->quadro_carimbo), n)
+            && grava(arq, estado->quadro_idade, sizeof(*estado->quadro_idade), n)
+            && grava(arq, estado->quadro_refs, sizeof(*estado->quadro_refs), n)
+            && grava(arq, &estado->num_quadros_livres, sizeof(int), 1)
+            && grava(arq, estado->paginas_sec, sizeof(*estado->paginas_sec), estado->num_paginas_sec)
+            && grava(arq, &estado->num_livres, sizeof(int), 1)
+            && grava(arq, estado->livres, sizeof(*estado->livres), estado->num_livres);
+  if (!ok) {
+    return false;
+  }
+  if (estado->dados_mapa != NULL) {
+    return grava(arq, estado->dados_mapa, sizeof(int), estado->tam_mem_sec);
+  }
+  if (estado->mem_secundaria != NULL) {
+    return mem_salva(estado->mem_secundaria, arq);
+  }
+  return true;
+}
+
+bool vm_estado_restaura(vm_estado_t *estado, FILE *arq)
+{
+  int n = estado->num_quadros;
+  int geometria[3];
+  if (!le(arq, geometria, sizeof(int), 3)
+      || geometria[0] != estado->num_quadros
+      || geometria[1] != estado->num_paginas_sec
+      || geometria[2] != estado->tam_mem_sec) {
+    return false;
+  }
+  bool ok = le(arq, estado->quadro_livre, sizeof(*estado->quadro_livre), n)
+            && le(arq, estado->quadro_dono, sizeof(*estado->quadro_dono), n)
+            && le(arq, estado->quadro_pagina, sizeof(*estado->quadro_pagina), n)
+            && le(arq, estado->quadro_carimbo, sizeof(*estado->quadro_carimbo), n)
+            && le(arq, estado->quadro_idade, sizeof(*estado->quadro_idade), n)
+            && le(arq, estado->quadro_refs, sizeof(*estado->quadro_refs), n)
+            && le(arq, &estado->num_quadros_livres, sizeof(int), 1)
+            && le(arq, estado->paginas_sec, sizeof(*estado->paginas_sec), estado->num_paginas_sec)
+            && le(arq, &estado->num_livres, sizeof(int), 1)
+            && estado->num_livres >= 0 && estado->num_livres <= estado->num_paginas_sec / 2 + 1
+            && le(arq, estado->livres, sizeof(*estado->livres), estado->num_livres);
+  if (!ok) {
+    return false;
+  }
+  if (estado->dados_mapa != NULL) {
+    return le(arq, estado->dados_mapa, sizeof(int), estado->tam_mem_sec);
+  }
+  if (estado->mem_secundaria != NULL) {
+    return mem_restaura(estado->mem_secundaria, arq);
+  }
+  return true;
 }
@@ -8,17 +8,20 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #include "memoria.h"
 
-// descreve um quadro físico da memória principal
-typedef struct {
-  bool livre;             // true se o quadro está disponível
-  int dono_pid;           // pid do processo que ocupa o quadro, ou -1
-  int pagina_virtual;     // índice da página virtual ocupante, ou -1
-  unsigned long carimbo_fifo; // usado para FIFO/clock
-  unsigned long idade;    // usado para envelhecimento/LRU aproximado
-} quadro_desc_t;
+// bit mais significativo da idade de um quadro, ligado no envelhecimento
+//   quando a página do quadro foi acessada
+#define VM_BITS_IDADE_MSB (sizeof(unsigned long) * 8 - 1)
+#define VM_IDADE_MSB (1UL << VM_BITS_IDADE_MSB)
+
+// critério para a escolha do quadro a substituir
+typedef enum {
+  VITIMA_MENOR_IDADE,     // LRU aproximado por envelhecimento
+  VITIMA_MENOR_CARIMBO    // FIFO
+} vm_criterio_vitima_t;
 
 // descreve uma página armazenada na memória secundária
 typedef struct {
@@ -27,6 +30,7 @@ typedef struct {
   int pagina_virtual;     // página correspondente, ou -1
   int base_endereco;      // endereço base na memória secundária
   int tamanho;            // tamanho da região em palavras
+  int referencias;        // processos que usam o slot (mais de um após SO_FORK)
 } pagina_sec_desc_t;
 
 // estado global do gerenciador de memória virtual
@@ -42,11 +46,26 @@ void vm_estado_destroi(vm_estado_t *estado);
 // devolve o número de quadros físicos gerenciados
 int vm_estado_num_quadros(const vm_estado_t *estado);
 
+// devolve o número de quadros físicos livres (mantido a cada ocupação e
+//   liberação, sem varrer a tabela)
+int vm_estado_num_quadros_livres(const vm_estado_t *estado);
+
 // devolve o número de páginas secundárias gerenciadas
 int vm_estado_num_paginas_sec(const vm_estado_t *estado);
 
-// obtém um ponteiro mutável para um descritor de quadro; retorna NULL se índice inválido
-quadro_desc_t *vm_estado_quadro(vm_estado_t *estado, int indice);
+// campos de um quadro físico; para índice inválido o quadro é tratado como
+//   não livre, sem dono (-1), sem página (-1), carimbo, idade e referências 0
+// a tabela de quadros é mantida como estrutura de vetores, por isso não há
+//   um descritor por quadro para devolver
+bool vm_estado_quadro_livre(const vm_estado_t *estado, int indice);
+int vm_estado_quadro_dono(const vm_estado_t *estado, int indice);
+int vm_estado_quadro_pagina(const vm_estado_t *estado, int indice);
+unsigned long vm_estado_quadro_carimbo(const vm_estado_t *estado, int indice);
+unsigned long vm_estado_quadro_idade(const vm_estado_t *estado, int indice);
+int vm_estado_quadro_referencias(const vm_estado_t *estado, int indice);
+
+// altera a idade de um quadro
+void vm_estado_define_idade(vm_estado_t *estado, int indice, unsigned long idade);
 
 // obtém um ponteiro mutável para um descritor de página secundária; retorna NULL se índice inválido
 pagina_sec_desc_t *vm_estado_pagina_sec(vm_estado_t *estado, int indice);
@@ -57,14 +76,58 @@ void vm_estado_reseta(vm_estado_t *estado);
 // encontra o índice de um quadro livre; retorna -1 se nenhum disponível
 int vm_estado_busca_quadro_livre(vm_estado_t *estado);
 
-// marca um quadro como ocupado pelo pid/página informados
+// marca um quadro como ocupado pelo pid/página informados, com uma referência
 void vm_estado_ocupa_quadro(vm_estado_t *estado, int indice, int pid, int pagina_virtual, unsigned long carimbo);
 
+// um quadro compartilhado (cópia na escrita) é mapeado na mesma página
+//   virtual por vários processos; o dono é um deles, e as referências contam
+//   quantos são
+// acrescenta uma referência a um quadro ocupado
+void vm_estado_retem_quadro(vm_estado_t *estado, int indice);
+
+// retira uma referência de um quadro ocupado, liberando-o quando não sobrar
+//   nenhuma; retorna quantas referências sobraram
+int vm_estado_solta_quadro(vm_estado_t *estado, int indice);
+
+// troca o processo dono de um quadro ocupado
+void vm_estado_define_dono(vm_estado_t *estado, int indice, int pid);
+
 // libera um quadro ocupado, preservando carimbos para depuração
 void vm_estado_libera_quadro(vm_estado_t *estado, int indice);
 
-// encontra o índice de um slot livre na memória secundária
-int vm_estado_busca_pagsec_livre(vm_estado_t *estado);
+// libera todos os quadros ocupados pelo processo 'pid'; retorna quantos
+int vm_estado_libera_quadros_do_processo(vm_estado_t *estado, int pid);
+
+// envelhece os 'n' quadros em 'quadros' (os de um processo) por vários ticks
+//   de uma vez: a idade é deslocada 'antes' bits à direita, recebe no bit mais
+//   significativo o bit de acesso correspondente em 'acessados', e é deslocada
+//   mais 'depois' bits (ticks em que o processo não executou)
+// com antes = 1 e depois = 0 é o envelhecimento de um tick
+void vm_estado_envelhece_quadros(vm_estado_t *estado, const int quadros[],
+                                 const unsigned char acessados[], int n,
+                                 int antes, int depois);
+
+// escolhe o quadro a substituir entre os ocupados por processos (quadros
+//   reservados, com dono negativo, nunca são escolhidos), o de menor idade ou
+//   o de menor carimbo, conforme 'criterio'
+// retorna -1 se não houver quadro elegível
+int vm_estado_busca_vitima(vm_estado_t *estado, vm_criterio_vitima_t criterio);
+
+// aloca uma extensão de 'num_paginas' slots contíguos na memória secundária,
+//   escolhendo a menor região livre que comporte o pedido (best-fit)
+// retorna o índice do primeiro slot da extensão, ou -1 se não houver região
+//   livre grande o suficiente
+int vm_estado_aloca_extensao(vm_estado_t *estado, int num_paginas);
+
+// devolve ao alocador a extensão que começa no slot 'base' e tem 'num_paginas'
+//   slots, liberando os descritores e juntando com as regiões livres vizinhas
+void vm_estado_libera_extensao(vm_estado_t *estado, int base, int num_paginas);
+
+// número de regiões livres na memória secundária (medida de fragmentação)
+int vm_estado_num_extensoes_livres(const vm_estado_t *estado);
+
+// tamanho (em páginas) da maior região livre na memória secundária
+int vm_estado_maior_extensao_livre(const vm_estado_t *estado);
 
 // ocupa um slot da secundária
 void vm_estado_ocupa_pagsec(vm_estado_t *estado, int indice, int pid, int pagina_virtual, int base_endereco, int tamanho);
@@ -72,13 +135,49 @@ void vm_estado_ocupa_pagsec(vm_estado_t *estado, int indice, int pid, int pagina
 // libera um slot da secundária
 void vm_estado_libera_pagsec(vm_estado_t *estado, int indice);
 
+// um slot ocupado começa com uma referência; depois de SO_FORK é usado por
+//   mais de um processo, até que um deles grave a página em outro slot
+// acrescenta uma referência a um slot ocupado
+void vm_estado_retem_pagsec(vm_estado_t *estado, int indice);
+
+// retira uma referência de um slot ocupado; quando não sobra nenhuma o slot
+//   volta ao alocador, como uma extensão de uma página
+// retorna quantas referências sobraram
+int vm_estado_solta_pagsec(vm_estado_t *estado, int indice);
+
 // configura o tamanho da memória secundária (em palavras) e cria o mem_t correspondente
 void vm_estado_configura_mem_sec(vm_estado_t *estado, int tamanho);
 
+// configura a memória secundária com 'tamanho' palavras mapeadas (mmap) do
+//   arquivo 'nome' do hospedeiro, em vez de um mem_t no heap
+// o arquivo é criado se não existir, e zerado se existir
+// retorna false se não for possível abrir ou mapear o arquivo
+bool vm_estado_configura_mem_sec_arquivo(vm_estado_t *estado, int tamanho, const char *nome);
+
 // grava uma palavra na memória secundária
 err_t vm_estado_sec_escreve(vm_estado_t *estado, int endereco, int valor);
 
 // lê uma palavra da memória secundária
 err_t vm_estado_sec_le(vm_estado_t *estado, int endereco, int *valor);
 
+// grava 'n' palavras consecutivas na memória secundária, a partir de 'endereco'
+// permite transferir várias páginas de uma extensão contígua de uma vez
+err_t vm_estado_sec_escreve_bloco(vm_estado_t *estado, int endereco, const int *valores, int n);
+
+// lê 'n' palavras consecutivas da memória secundária, a partir de 'endereco'
+err_t vm_estado_sec_le_bloco(vm_estado_t *estado, int endereco, int *valores, int n);
+
+// grava em 'arq' as tabelas de quadros e de slots, as regiões livres e o
+//   conteúdo da memória secundária (checkpoint da máquina)
+// retorna false em caso de erro de escrita
+bool vm_estado_salva(vm_estado_t *estado, FILE *arq);
+
+// recupera o que foi gravado por vm_estado_salva num estado com a mesma
+//   geometria (número de quadros e de slots, tamanho da memória secundária);
+//   o conteúdo vai para a memória secundária já configurada, esteja ela no
+//   heap ou num arquivo mapeado
+// retorna false em caso de erro de leitura ou se a geometria não confere; o
+//   estado fica inconsistente se o erro for depois da verificação
+bool vm_estado_restaura(vm_estado_t *estado, FILE *arq);
+
 #endif // VMEM_H